@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * bench.h
+ * Timing helpers shared by the benchmark programs.
+ */
+
+#ifndef NTIRPC_BENCH_H
+#define NTIRPC_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline uint64_t
+bench_now(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/* latency samples, in nanoseconds */
+struct bench_lat {
+	uint64_t *ns;
+	size_t n;
+	size_t max;
+};
+
+static inline bool
+bench_lat_add(struct bench_lat *lat, uint64_t ns)
+{
+	uint64_t *p;
+
+	if (lat->n == lat->max) {
+		lat->max = lat->max ? lat->max * 2 : 4096;
+		p = realloc(lat->ns, lat->max * sizeof(uint64_t));
+		if (!p)
+			return (false);
+		lat->ns = p;
+	}
+	lat->ns[lat->n++] = ns;
+	return (true);
+}
+
+/* appends src to dst, and frees src */
+static inline bool
+bench_lat_merge(struct bench_lat *dst, struct bench_lat *src)
+{
+	size_t ix;
+	bool ok = true;
+
+	for (ix = 0; ix < src->n && ok; ++ix)
+		ok = bench_lat_add(dst, src->ns[ix]);
+	free(src->ns);
+	src->ns = NULL;
+	src->n = src->max = 0;
+	return (ok);
+}
+
+static int
+bench_u64_cmpf(const void *lhs, const void *rhs)
+{
+	uint64_t l = *(const uint64_t *)lhs;
+	uint64_t r = *(const uint64_t *)rhs;
+
+	return ((l > r) - (l < r));
+}
+
+static inline void
+bench_lat_sort(struct bench_lat *lat)
+{
+	qsort(lat->ns, lat->n, sizeof(uint64_t), bench_u64_cmpf);
+}
+
+/* of sorted samples, in nanoseconds */
+static inline uint64_t
+bench_lat_pct(const struct bench_lat *lat, double pct)
+{
+	size_t ix;
+
+	if (!lat->n)
+		return (0);
+	ix = (size_t)(lat->n * pct / 100);
+	return (lat->ns[(ix < lat->n) ? ix : lat->n - 1]);
+}
+
+#endif				/* NTIRPC_BENCH_H */
@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_bench.c
+ * Loopback RPC throughput and latency.
+ *
+ * Starts an in-process server listening on 127.0.0.1, one TCP listener per
+ * event channel and one UDP transport on the global channel, then drives it
+ * from client threads spread over those transports.  Each run reports
+ * calls per second, payload throughput and latency percentiles; with -l,
+ * followed by the lock call sites counted during the run.  With -T, every
+ * request is traced and the spans are written to file at exit, as Chrome
+ * trace event JSON.
+ *
+ *   rpc_bench [-t clients] [-c channels] [-w pool threads] [-d seconds]
+ *	       [-p tcp|udp] [-s bytes] [-l] [-T file]
+ *
+ * Without -p or -s, runs null calls, 128 byte and 1 MiB echoes over TCP,
+ * and the first two over UDP.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpc/rpc.h>
+#include <rpc/svc_rqst.h>
+#include <rpc/lock_stat.h>
+#include <rpc/span.h>
+
+#include "bench.h"
+
+#define BENCH_PROG 0x20049000
+#define BENCH_VERS 1
+#define BENCH_ECHO 1
+
+#define BENCH_MAX_CHANS 64
+#define BENCH_MAX_SIZE (1024 * 1024)
+#define BENCH_UDP_MAX 32768
+#define BENCH_BUFSZ (BENCH_MAX_SIZE + 1024)
+
+struct bench_buf {
+	u_int len;
+	char *val;
+};
+
+struct bench_chan {
+	uint32_t id;
+	pthread_t thread;
+	struct sockaddr_in tcp;
+};
+
+struct bench_client {
+	pthread_t thread;
+	struct sockaddr_in *addr;
+	int proto;
+	u_int size;
+	uint64_t until;
+	uint64_t calls;
+	uint64_t errors;
+	struct bench_lat lat;
+};
+
+static struct bench_chan chans[BENCH_MAX_CHANS];
+static int nchans = 1;
+static struct sockaddr_in udp_addr;
+static pthread_t udp_thread;
+static bool lock_stat;
+static const char *span_path;
+
+static bool
+xdr_bench_buf(XDR *xdrs, struct bench_buf *bp)
+{
+	return (xdr_bytes(xdrs, &bp->val, &bp->len, BENCH_BUFSZ));
+}
+
+static void
+bench_dispatch(struct svc_req *req, SVCXPRT *xprt)
+{
+	struct bench_buf arg;
+
+	switch (req->rq_proc) {
+	case NULLPROC:
+		(void)svc_sendreply(xprt, req, (xdrproc_t) xdr_void, NULL);
+		break;
+	case BENCH_ECHO:
+		memset(&arg, 0, sizeof(arg));
+		if (!svc_getargs(xprt, req, (xdrproc_t) xdr_bench_buf, &arg,
+				 NULL)) {
+			svcerr_decode(xprt, req);
+			break;
+		}
+		(void)svc_sendreply(xprt, req, (xdrproc_t) xdr_bench_buf,
+				    &arg);
+		(void)svc_freeargs(xprt, req, (xdrproc_t) xdr_bench_buf,
+				   &arg);
+		break;
+	default:
+		svcerr_noproc(xprt, req);
+		break;
+	}
+}
+
+static void *
+bench_chan_thread(void *arg)
+{
+	struct bench_chan *chan = arg;
+
+	(void)svc_rqst_thrd_run(chan->id, SVC_RQST_FLAG_NONE);
+	return (NULL);
+}
+
+static void *
+bench_udp_thread(void *arg)
+{
+	svc_run();
+	return (NULL);
+}
+
+static int
+bench_socket(int type, struct sockaddr_in *sin)
+{
+	socklen_t len = sizeof(*sin);
+	int fd;
+
+	fd = socket(AF_INET, type, 0);
+	if (fd < 0)
+		return (-1);
+
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_family = AF_INET;
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (struct sockaddr *)sin, len) < 0
+	    || getsockname(fd, (struct sockaddr *)sin, &len) < 0) {
+		close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+static bool
+bench_server(void)
+{
+	SVCXPRT *xprt;
+	int ix, fd;
+
+	for (ix = 0; ix < nchans; ++ix) {
+		if (svc_rqst_new_evchan(&chans[ix].id, NULL,
+					SVC_RQST_FLAG_CHAN_AFFINITY)) {
+			fprintf(stderr, "svc_rqst_new_evchan failed\n");
+			return (false);
+		}
+
+		/* accepted connections follow the listener's channel */
+		fd = bench_socket(SOCK_STREAM, &chans[ix].tcp);
+		if (fd < 0) {
+			perror("tcp socket");
+			return (false);
+		}
+		xprt = svc_vc_ncreate2(fd, 0, 0, SVC_VC_CREATE_LISTEN
+				       | SVC_VC_CREATE_XPRT_NOREG);
+		if (!xprt) {
+			fprintf(stderr, "svc_vc_ncreate2 failed\n");
+			return (false);
+		}
+		if (ix == 0 && !svc_reg(xprt, BENCH_PROG, BENCH_VERS,
+					bench_dispatch, NULL)) {
+			fprintf(stderr, "svc_reg failed\n");
+			return (false);
+		}
+		(void)svc_rqst_evchan_reg(chans[ix].id, xprt,
+					  SVC_RQST_FLAG_NONE);
+
+		if (pthread_create(&chans[ix].thread, NULL, bench_chan_thread,
+				   &chans[ix])) {
+			fprintf(stderr, "pthread_create failed\n");
+			return (false);
+		}
+	}
+
+	/* registered on the global channel, run by svc_run() */
+	fd = bench_socket(SOCK_DGRAM, &udp_addr);
+	if (fd < 0) {
+		perror("udp socket");
+		return (false);
+	}
+	xprt = svc_dg_ncreate(fd, BENCH_UDP_MAX + 1024, BENCH_UDP_MAX + 1024);
+	if (!xprt) {
+		fprintf(stderr, "svc_dg_ncreate failed\n");
+		return (false);
+	}
+	if (pthread_create(&udp_thread, NULL, bench_udp_thread, NULL)) {
+		fprintf(stderr, "pthread_create failed\n");
+		return (false);
+	}
+	return (true);
+}
+
+static CLIENT *
+bench_clnt(struct bench_client *bc)
+{
+	struct netbuf nb;
+	CLIENT *clnt;
+	int fd;
+
+	fd = socket(AF_INET, (bc->proto == IPPROTO_TCP)
+			     ? SOCK_STREAM : SOCK_DGRAM, 0);
+	if (fd < 0)
+		return (NULL);
+
+	nb.maxlen = nb.len = sizeof(*bc->addr);
+	nb.buf = bc->addr;
+	if (bc->proto == IPPROTO_TCP) {
+		if (connect(fd, (struct sockaddr *)bc->addr,
+			    sizeof(*bc->addr)) < 0) {
+			close(fd);
+			return (NULL);
+		}
+		clnt = clnt_vc_ncreate2(fd, &nb, BENCH_PROG, BENCH_VERS,
+					0, 0, CLNT_CREATE_FLAG_NONE);
+	} else
+		clnt = clnt_dg_ncreate(fd, &nb, BENCH_PROG, BENCH_VERS,
+				       BENCH_UDP_MAX + 1024,
+				       BENCH_UDP_MAX + 1024);
+	if (!clnt) {
+		close(fd);
+		return (NULL);
+	}
+	(void)CLNT_CONTROL(clnt, CLSET_FD_CLOSE, NULL);
+	return (clnt);
+}
+
+static void *
+bench_client_thread(void *arg)
+{
+	struct bench_client *bc = arg;
+	struct timeval timeout = { 30, 0 };
+	struct bench_buf args, res;
+	enum clnt_stat stat;
+	uint64_t start, now;
+	AUTH *auth;
+	CLIENT *clnt;
+
+	clnt = bench_clnt(bc);
+	if (!clnt) {
+		bc->errors++;
+		return (NULL);
+	}
+	auth = authnone_ncreate();
+
+	args.len = bc->size;
+	args.val = malloc(bc->size ? bc->size : 1);
+	res.val = malloc(BENCH_BUFSZ);
+	if (!args.val || !res.val) {
+		bc->errors++;
+		goto out;
+	}
+	memset(args.val, 'x', bc->size);
+
+	for (start = bench_now(); start < bc->until; start = now) {
+		if (bc->size) {
+			res.len = 0;
+			stat = clnt_call(clnt, auth, BENCH_ECHO,
+					 (xdrproc_t) xdr_bench_buf, &args,
+					 (xdrproc_t) xdr_bench_buf, &res,
+					 timeout);
+			if (stat == RPC_SUCCESS && res.len != args.len)
+				stat = RPC_CANTDECODERES;
+		} else
+			stat = clnt_call(clnt, auth, NULLPROC,
+					 (xdrproc_t) xdr_void, NULL,
+					 (xdrproc_t) xdr_void, NULL, timeout);
+		now = bench_now();
+		if (stat != RPC_SUCCESS) {
+			bc->errors++;
+			if (bc->proto == IPPROTO_TCP)
+				break;
+			continue;
+		}
+		bc->calls++;
+		if (!bench_lat_add(&bc->lat, now - start))
+			break;
+	}
+
+ out:
+	free(args.val);
+	free(res.val);
+	AUTH_DESTROY(auth);
+	CLNT_DESTROY(clnt);
+	return (NULL);
+}
+
+static void
+bench_run(int proto, u_int size, int nclients, int seconds)
+{
+	struct bench_client *clients;
+	struct bench_lat lat = { NULL, 0, 0 };
+	uint64_t calls = 0, errors = 0;
+	uint64_t start, elapsed;
+	char label[32];
+	double secs;
+	int ix;
+
+	clients = calloc(nclients, sizeof(struct bench_client));
+	if (!clients)
+		return;
+
+	if (lock_stat)
+		tirpc_lock_stat_reset();
+	start = bench_now();
+	for (ix = 0; ix < nclients; ++ix) {
+		struct bench_client *bc = &clients[ix];
+
+		bc->addr = (proto == IPPROTO_TCP) ? &chans[ix % nchans].tcp
+						  : &udp_addr;
+		bc->proto = proto;
+		bc->size = size;
+		bc->until = start + seconds * 1000000000ULL;
+		if (pthread_create(&bc->thread, NULL, bench_client_thread,
+				   bc)) {
+			bc->errors++;
+			bc->thread = 0;
+		}
+	}
+	for (ix = 0; ix < nclients; ++ix) {
+		if (clients[ix].thread)
+			pthread_join(clients[ix].thread, NULL);
+		calls += clients[ix].calls;
+		errors += clients[ix].errors;
+		(void)bench_lat_merge(&lat, &clients[ix].lat);
+	}
+	elapsed = bench_now() - start;
+	bench_lat_sort(&lat);
+
+	if (size)
+		snprintf(label, sizeof(label), "echo %u", size);
+	else
+		snprintf(label, sizeof(label), "null");
+	secs = elapsed / 1e9;
+	printf("%-3s %-12s %9.0f ops/s %9.1f MB/s"
+	       "  p50 %7.1f  p99 %7.1f  p99.9 %7.1f us  errors %" PRIu64 "\n",
+	       (proto == IPPROTO_TCP) ? "tcp" : "udp", label, calls / secs,
+	       2.0 * size * calls / secs / 1e6,
+	       bench_lat_pct(&lat, 50) / 1e3, bench_lat_pct(&lat, 99) / 1e3,
+	       bench_lat_pct(&lat, 99.9) / 1e3, errors);
+	if (lock_stat)
+		tirpc_lock_stat_dump(stdout);
+
+	free(lat.ns);
+	free(clients);
+}
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-t clients] [-c channels] [-w pool threads]\n"
+		"	[-d seconds] [-p tcp|udp] [-s bytes] [-l] [-T file]\n",
+		prog);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const u_int sizes[] = { 0, 128, BENCH_MAX_SIZE };
+	svc_init_params params;
+	int nclients = 4;
+	int seconds = 2;
+	int proto = 0;
+	long size = -1;
+	u_int pool = 0;
+	u_int ix;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:c:w:d:p:s:lT:")) != -1) {
+		switch (opt) {
+		case 't':
+			nclients = atoi(optarg);
+			break;
+		case 'c':
+			nchans = atoi(optarg);
+			break;
+		case 'w':
+			pool = atoi(optarg);
+			break;
+		case 'd':
+			seconds = atoi(optarg);
+			break;
+		case 'p':
+			if (!strcmp(optarg, "tcp"))
+				proto = IPPROTO_TCP;
+			else if (!strcmp(optarg, "udp"))
+				proto = IPPROTO_UDP;
+			else
+				usage(argv[0]);
+			break;
+		case 's':
+			size = atol(optarg);
+			break;
+		case 'l':
+			lock_stat = true;
+			break;
+		case 'T':
+			span_path = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (nclients < 1 || seconds < 1 || nchans < 1
+	    || nchans > BENCH_MAX_CHANS || size > BENCH_MAX_SIZE)
+		usage(argv[0]);
+
+	memset(&params, 0, sizeof(params));
+	params.flags = SVC_INIT_EPOLL;
+	params.max_events = 1024;
+	params.ioq_thrd_max = pool;
+	if (!svc_init(&params)) {
+		fprintf(stderr, "svc_init failed\n");
+		return (1);
+	}
+	if (!bench_server())
+		return (1);
+	if (lock_stat)
+		tirpc_lock_stat_enable();
+	if (span_path && !tirpc_span_enable(1, 65536)) {
+		fprintf(stderr, "tirpc_span_enable failed\n");
+		return (1);
+	}
+
+	printf("%d clients, %d channels, %u pool threads, %d s per run\n",
+	       nclients, nchans, pool, seconds);
+
+	for (ix = 0; ix < sizeof(sizes) / sizeof(sizes[0]); ++ix) {
+		u_int sz = (size < 0) ? sizes[ix] : (u_int) size;
+
+		if (proto != IPPROTO_UDP)
+			bench_run(IPPROTO_TCP, sz, nclients, seconds);
+		if (proto != IPPROTO_TCP && sz <= BENCH_UDP_MAX)
+			bench_run(IPPROTO_UDP, sz, nclients, seconds);
+		if (size >= 0)
+			break;
+	}
+
+	for (ix = 0; ix < nchans; ++ix)
+		(void)svc_rqst_thrd_signal(chans[ix].id,
+					   SVC_RQST_SIGNAL_SHUTDOWN);
+	svc_exit();
+	for (ix = 0; ix < nchans; ++ix)
+		pthread_join(chans[ix].thread, NULL);
+	pthread_join(udp_thread, NULL);
+
+	if (span_path) {
+		uint64_t cursor = 0;
+		FILE *fp = fopen(span_path, "w");
+
+		if (!fp) {
+			perror(span_path);
+			return (1);
+		}
+		printf("%u spans written to %s\n",
+		       tirpc_span_export(fp, &cursor), span_path);
+		fclose(fp);
+	}
+	return (0);
+}
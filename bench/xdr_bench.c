@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * xdr_bench.c
+ * XDR encode and decode cost, without a network.
+ *
+ * Runs each workload through the xdr_mem, xdr_ioq, xdr_rec and xdr_inrec
+ * streams (xdr_inrec decodes only), and reports nanoseconds per operation
+ * and encoded bytes per second.  The record streams read and write a
+ * memory buffer, so only the codec and stream costs are measured.
+ *
+ *   xdr_bench [-d seconds] [-w workload] [-x mem|ioq|rec|inrec]
+ *
+ * Each case runs for -d seconds (default 0.5).  -w and -x select a single
+ * workload or stream by name.
+ */
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpc/rpc.h>
+#include <rpc/xdr_inrec.h>
+#include <rpc/xdr_ioq.h>
+
+#include "nfs4.h"
+#include "bench.h"
+
+#define XB_BUFSZ (2 * 1024 * 1024)
+#define XB_RECSZ (64 * 1024)
+#define XB_OPAQUE_SIZE (1024 * 1024)
+#define XB_ARRAY_SIZE 1024
+#define XB_READ_SIZE (64 * 1024)
+#define XB_BATCH 16
+
+struct xb_opaque {
+	u_int len;
+	char *val;
+};
+
+struct xb_array {
+	u_int len;
+	uint32_t *val;
+};
+
+struct xb_work {
+	const char *name;
+	xdrproc_t proc;
+	void *obj;		/* encoded */
+	size_t size;		/* of the decoded object */
+	void (*prep)(void *);	/* readies a zeroed object for decoding */
+	u_int len;		/* encoded length, from the mem stream */
+};
+
+/* memory "connection" behind the record streams */
+struct xb_recbuf {
+	char *buf;
+	size_t len;
+	size_t pos;
+};
+
+static double duration = 0.5;
+
+/*
+ * Workloads
+ */
+
+static struct rpc_msg call_msg;
+static struct rpc_msg reply_msg;
+static struct authunix_parms sys_cred;
+static gid_t sys_gids[NGRPS];
+static char sys_machname[] = "client.bench.example.com";
+static struct xb_opaque opaque;
+static struct xb_array array;
+static COMPOUND4args compound_args;
+static COMPOUND4res compound_res;
+
+static bool
+xdr_xb_opaque(XDR *xdrs, struct xb_opaque *o)
+{
+	return (xdr_bytes(xdrs, &o->val, &o->len, XB_OPAQUE_SIZE));
+}
+
+static bool
+xdr_xb_array(XDR *xdrs, struct xb_array *a)
+{
+	return (xdr_array(xdrs, (char **)&a->val, &a->len, XB_ARRAY_SIZE,
+			  sizeof(uint32_t), (xdrproc_t) xdr_uint32_t));
+}
+
+static void
+prep_callmsg(void *obj)
+{
+	struct rpc_msg *msg = obj;
+
+	/* as svc_request does, decode credentials in place */
+	msg->rm_call.cb_cred.oa_base = msg->cb_cred_body;
+	msg->rm_call.cb_verf.oa_base = msg->cb_verf_body;
+}
+
+static void
+prep_replymsg(void *obj)
+{
+	struct rpc_msg *msg = obj;
+
+	msg->acpted_rply.ar_results.proc = (xdrproc_t) xdr_void;
+}
+
+static void
+setup_work(void)
+{
+	static nfs_argop4 argops[3];
+	static nfs_resop4 resops[2];
+	static uint32_t attrmask[2] = { 0x0010011a, 0x00b0a23a };
+	static char fh[64];
+	static char tag[] = "bench";
+	XDR xdrs;
+	u_int ix;
+
+	call_msg.rm_xid = 0x12345678;
+	call_msg.rm_direction = CALL;
+	call_msg.rm_call.cb_rpcvers = RPC_MSG_VERSION;
+	call_msg.rm_call.cb_prog = NFS4_PROGRAM;
+	call_msg.rm_call.cb_vers = NFS_V4;
+	call_msg.rm_call.cb_proc = NFSPROC4_COMPOUND;
+
+	sys_cred.aup_time = 1470000000;
+	sys_cred.aup_machname = sys_machname;
+	sys_cred.aup_uid = 1000;
+	sys_cred.aup_gid = 1000;
+	for (ix = 0; ix < NGRPS; ++ix)
+		sys_gids[ix] = 1000 + ix;
+	sys_cred.aup_len = NGRPS;
+	sys_cred.aup_gids = sys_gids;
+
+	/* the call header carries the AUTH_SYS credential */
+	xdrmem_ncreate(&xdrs, call_msg.cb_cred_body, MAX_AUTH_BYTES,
+		       XDR_ENCODE);
+	if (!xdr_authunix_parms(&xdrs, &sys_cred)) {
+		fprintf(stderr, "authunix_parms encode failed\n");
+		exit(1);
+	}
+	call_msg.rm_call.cb_cred.oa_flavor = AUTH_SYS;
+	call_msg.rm_call.cb_cred.oa_base = call_msg.cb_cred_body;
+	call_msg.rm_call.cb_cred.oa_length = XDR_GETPOS(&xdrs);
+	call_msg.rm_call.cb_verf = _null_auth;
+
+	reply_msg.rm_xid = 0x12345678;
+	reply_msg.rm_direction = REPLY;
+	reply_msg.rm_reply.rp_stat = MSG_ACCEPTED;
+	reply_msg.acpted_rply.ar_verf = _null_auth;
+	reply_msg.acpted_rply.ar_stat = SUCCESS;
+	reply_msg.acpted_rply.ar_results.where = NULL;
+	reply_msg.acpted_rply.ar_results.proc = (xdrproc_t) xdr_void;
+
+	opaque.len = XB_OPAQUE_SIZE;
+	opaque.val = malloc(XB_OPAQUE_SIZE);
+
+	array.len = XB_ARRAY_SIZE;
+	array.val = malloc(XB_ARRAY_SIZE * sizeof(uint32_t));
+	for (ix = 0; ix < XB_ARRAY_SIZE; ++ix)
+		array.val[ix] = ix * 2654435761U;
+
+	if (!opaque.val || !array.val) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memset(opaque.val, 0x5a, XB_OPAQUE_SIZE);
+	memset(fh, 0xa5, sizeof(fh));
+
+	/* PUTFH, READ, GETATTR, as for a typical NFSv4.0 read */
+	argops[0].argop = OP_PUTFH;
+	argops[0].nfs_argop4_u.opputfh.object.nfs_fh4_len = sizeof(fh);
+	argops[0].nfs_argop4_u.opputfh.object.nfs_fh4_val = fh;
+	argops[1].argop = OP_READ;
+	argops[1].nfs_argop4_u.opread.stateid.seqid = 1;
+	memset(argops[1].nfs_argop4_u.opread.stateid.other, 0x3c, 12);
+	argops[1].nfs_argop4_u.opread.offset = 1048576;
+	argops[1].nfs_argop4_u.opread.count = XB_READ_SIZE;
+	argops[2].argop = OP_GETATTR;
+	argops[2].nfs_argop4_u.opgetattr.attr_request.bitmap4_len = 2;
+	argops[2].nfs_argop4_u.opgetattr.attr_request.bitmap4_val = attrmask;
+
+	compound_args.tag.utf8string_len = sizeof(tag) - 1;
+	compound_args.tag.utf8string_val = tag;
+	compound_args.minorversion = 0;
+	compound_args.argarray.argarray_len = 3;
+	compound_args.argarray.argarray_val = argops;
+
+	resops[0].resop = OP_PUTFH;
+	resops[0].nfs_resop4_u.opputfh.status = NFS4_OK;
+	resops[1].resop = OP_READ;
+	resops[1].nfs_resop4_u.opread.status = NFS4_OK;
+	resops[1].nfs_resop4_u.opread.READ4res_u.resok4.eof = FALSE;
+	resops[1].nfs_resop4_u.opread.READ4res_u.resok4.data.data_len =
+		XB_READ_SIZE;
+	resops[1].nfs_resop4_u.opread.READ4res_u.resok4.data.data_val =
+		opaque.val;
+
+	compound_res.status = NFS4_OK;
+	compound_res.tag = compound_args.tag;
+	compound_res.resarray.resarray_len = 2;
+	compound_res.resarray.resarray_val = resops;
+}
+
+static struct xb_work works[] = {
+	{ "callmsg", (xdrproc_t) xdr_ncallmsg, &call_msg,
+	  sizeof(struct rpc_msg), prep_callmsg },
+	{ "replymsg", (xdrproc_t) xdr_nreplymsg, &reply_msg,
+	  sizeof(struct rpc_msg), prep_replymsg },
+	{ "authsys", (xdrproc_t) xdr_authunix_parms, &sys_cred,
+	  sizeof(struct authunix_parms), NULL },
+	{ "opaque1m", (xdrproc_t) xdr_xb_opaque, &opaque,
+	  sizeof(struct xb_opaque), NULL },
+	{ "array1k", (xdrproc_t) xdr_xb_array, &array,
+	  sizeof(struct xb_array), NULL },
+	{ "compound4args", (xdrproc_t) xdr_COMPOUND4args, &compound_args,
+	  sizeof(COMPOUND4args), NULL },
+	{ "compound4res", (xdrproc_t) xdr_COMPOUND4res, &compound_res,
+	  sizeof(COMPOUND4res), NULL },
+	{ NULL }
+};
+
+/*
+ * Streams
+ */
+
+static int
+xb_rec_write(XDR *xdrs, void *handle, void *buf, int len)
+{
+	struct xb_recbuf *rb = handle;
+
+	if (rb->len + len > XB_BUFSZ)
+		return (-1);
+	memcpy(rb->buf + rb->len, buf, len);
+	rb->len += len;
+	return (len);
+}
+
+/* replays the recorded stream endlessly, so every decode finds a record */
+static int
+xb_rec_read(XDR *xdrs, void *handle, void *buf, int len)
+{
+	struct xb_recbuf *rb = handle;
+	size_t n = rb->len - rb->pos;
+
+	if (n > len)
+		n = len;
+	memcpy(buf, rb->buf + rb->pos, n);
+	rb->pos += n;
+	if (rb->pos == rb->len)
+		rb->pos = 0;
+	return (n);
+}
+
+enum xb_stream {
+	XB_MEM,
+	XB_IOQ,
+	XB_REC,
+	XB_INREC,
+	XB_STREAMS
+};
+
+static const char *stream_names[XB_STREAMS] = {
+	"mem", "ioq", "rec", "inrec"
+};
+
+struct xb_case {
+	struct xb_work *work;
+	enum xb_stream stream;
+	char *buf;
+	struct xb_recbuf rb;
+	XDR mem;
+	XDR rec;
+	XDR *ioq;
+	void *out;
+};
+
+static XDR *
+ioq_create(void)
+{
+	return (xdr_ioq_create(8192, XB_OPAQUE_SIZE + 8192, UIO_FLAG_FREE));
+}
+
+static bool
+encode_once(struct xb_case *c)
+{
+	struct xb_work *w = c->work;
+	XDR *xdrs;
+
+	switch (c->stream) {
+	case XB_MEM:
+		xdrs = &c->mem;
+		XDR_SETPOS(xdrs, 0);
+		return (w->proc(xdrs, w->obj));
+	case XB_IOQ:
+		xdrs = ioq_create();
+		if (!w->proc(xdrs, w->obj)) {
+			XDR_DESTROY(xdrs);
+			return (false);
+		}
+		XDR_DESTROY(xdrs);
+		return (true);
+	case XB_REC:
+		c->rb.len = 0;
+		return (w->proc(&c->rec, w->obj)
+			&& xdrrec_endofrecord(&c->rec, true));
+	default:
+		break;
+	}
+	return (false);
+}
+
+static bool
+decode_once(struct xb_case *c)
+{
+	struct xb_work *w = c->work;
+	XDR *xdrs;
+	bool rslt;
+
+	memset(c->out, 0, w->size);
+	if (w->prep)
+		w->prep(c->out);
+
+	switch (c->stream) {
+	case XB_MEM:
+		xdrs = &c->mem;
+		XDR_SETPOS(xdrs, 0);
+		break;
+	case XB_IOQ:
+		xdrs = c->ioq;
+		XDR_SETPOS(xdrs, 0);
+		break;
+	case XB_REC:
+		xdrs = &c->rec;
+		if (!xdrrec_skiprecord(xdrs))
+			return (false);
+		break;
+	case XB_INREC:
+		xdrs = &c->rec;
+		if (!xdr_inrec_skiprecord(xdrs))
+			return (false);
+		break;
+	default:
+		return (false);
+	}
+	rslt = w->proc(xdrs, c->out);
+	xdr_nfree(w->proc, c->out);
+	return (rslt);
+}
+
+/* fills the case's stream with one encoded record for decoding */
+static bool
+setup_decode(struct xb_case *c)
+{
+	struct xb_work *w = c->work;
+	XDR enc;
+
+	switch (c->stream) {
+	case XB_MEM:
+		xdrmem_ncreate(&c->mem, c->buf, XB_BUFSZ, XDR_ENCODE);
+		if (!w->proc(&c->mem, w->obj))
+			return (false);
+		xdrmem_ncreate(&c->mem, c->buf, XDR_GETPOS(&c->mem),
+			       XDR_DECODE);
+		return (true);
+	case XB_IOQ:
+		c->ioq = ioq_create();
+		if (!w->proc(c->ioq, w->obj))
+			return (false);
+		c->ioq->x_op = XDR_DECODE;
+		return (true);
+	case XB_REC:
+	case XB_INREC:
+		c->rb.len = 0;
+		c->rb.pos = 0;
+		xdrrec_create(&enc, XB_RECSZ, XB_RECSZ, &c->rb, xb_rec_read,
+			      xb_rec_write);
+		enc.x_op = XDR_ENCODE;
+		if (!w->proc(&enc, w->obj)
+		    || !xdrrec_endofrecord(&enc, true)) {
+			XDR_DESTROY(&enc);
+			return (false);
+		}
+		XDR_DESTROY(&enc);
+		if (c->stream == XB_REC) {
+			xdrrec_create(&c->rec, XB_RECSZ, XB_RECSZ, &c->rb,
+				      xb_rec_read, xb_rec_write);
+			c->rec.x_op = XDR_DECODE;
+		} else
+			xdr_inrec_create(&c->rec, XB_RECSZ, &c->rb,
+					 xb_rec_read);
+		return (true);
+	default:
+		break;
+	}
+	return (false);
+}
+
+static void
+setup_encode(struct xb_case *c)
+{
+	switch (c->stream) {
+	case XB_MEM:
+		xdrmem_ncreate(&c->mem, c->buf, XB_BUFSZ, XDR_ENCODE);
+		break;
+	case XB_REC:
+		c->rb.len = 0;
+		xdrrec_create(&c->rec, XB_RECSZ, XB_RECSZ, &c->rb, xb_rec_read,
+			      xb_rec_write);
+		c->rec.x_op = XDR_ENCODE;
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+teardown(struct xb_case *c)
+{
+	switch (c->stream) {
+	case XB_IOQ:
+		if (c->ioq) {
+			XDR_DESTROY(c->ioq);
+			c->ioq = NULL;
+		}
+		break;
+	case XB_REC:
+	case XB_INREC:
+		XDR_DESTROY(&c->rec);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+report(struct xb_case *c, const char *op, uint64_t n, uint64_t ns)
+{
+	double secs = ns / 1e9;
+
+	printf("%-14s %-6s %-7s %10.1f ns/op %10.1f MB/s\n",
+	       c->work->name, stream_names[c->stream], op,
+	       (double)ns / n, c->work->len * (double)n / secs / 1e6);
+}
+
+static void
+run(struct xb_case *c, const char *op, bool (*once)(struct xb_case *))
+{
+	uint64_t limit = duration * 1e9;
+	uint64_t start = bench_now();
+	uint64_t now;
+	uint64_t n = 0;
+	int ix;
+
+	do {
+		for (ix = 0; ix < XB_BATCH; ++ix) {
+			if (!once(c)) {
+				printf("%-14s %-6s %-7s failed\n",
+				       c->work->name, stream_names[c->stream],
+				       op);
+				return;
+			}
+		}
+		n += XB_BATCH;
+		now = bench_now();
+	} while (now - start < limit);
+
+	report(c, op, n, now - start);
+}
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d seconds] [-w workload] [-x mem|ioq|rec|inrec]\n",
+		prog);
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct xb_case c;
+	struct xb_work *w;
+	const char *only_work = NULL;
+	int only_stream = -1;
+	int stream;
+	int opt;
+	XDR xdrs;
+
+	while ((opt = getopt(argc, argv, "d:w:x:")) != -1) {
+		switch (opt) {
+		case 'd':
+			duration = strtod(optarg, NULL);
+			if (duration <= 0)
+				usage(argv[0]);
+			break;
+		case 'w':
+			only_work = optarg;
+			break;
+		case 'x':
+			for (stream = 0; stream < XB_STREAMS; ++stream)
+				if (!strcmp(optarg, stream_names[stream]))
+					only_stream = stream;
+			if (only_stream < 0)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	setup_work();
+
+	memset(&c, 0, sizeof(c));
+	c.buf = malloc(XB_BUFSZ);
+	c.rb.buf = malloc(XB_BUFSZ);
+	c.out = calloc(1, sizeof(struct rpc_msg) + XB_OPAQUE_SIZE);
+	if (!c.buf || !c.rb.buf || !c.out) {
+		fprintf(stderr, "out of memory\n");
+		return (1);
+	}
+
+	for (w = works; w->name; ++w) {
+		if (only_work && strcmp(only_work, w->name))
+			continue;
+
+		xdrmem_ncreate(&xdrs, c.buf, XB_BUFSZ, XDR_ENCODE);
+		if (!w->proc(&xdrs, w->obj)) {
+			fprintf(stderr, "%s: encode failed\n", w->name);
+			return (1);
+		}
+		w->len = XDR_GETPOS(&xdrs);
+		c.work = w;
+
+		for (stream = 0; stream < XB_STREAMS; ++stream) {
+			if (only_stream >= 0 && stream != only_stream)
+				continue;
+			c.stream = stream;
+
+			if (stream != XB_INREC) {
+				setup_encode(&c);
+				run(&c, "encode", encode_once);
+				teardown(&c);
+			}
+
+			if (!setup_decode(&c)) {
+				printf("%-14s %-6s %-7s setup failed\n",
+				       w->name, stream_names[stream], "decode");
+				teardown(&c);
+				continue;
+			}
+			run(&c, "decode", decode_once);
+			teardown(&c);
+		}
+	}
+
+	free(c.out);
+	free(c.rb.buf);
+	free(c.buf);
+	return (0);
+}
@@ -16,6 +16,9 @@
 #cmakedefine _HAVE_GSSAPI 1
 #cmakedefine HAVE_STRING_H 1
 #cmakedefine HAVE_STRINGS_H 1
+#cmakedefine HAVE_SYS_SENDFILE_H 1
+#cmakedefine HAVE_LINUX_ERRQUEUE_H 1
+#cmakedefine HAVE_SCHED_GETCPU 1
 #cmakedefine LITTLEEND 1
 #cmakedefine BIGEND 1
 #cmakedefine TIRPC_EPOLL 1
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file lock_stat.h
+ * @brief Lock contention accounting
+ *
+ * @section DESCRIPTION
+ *
+ * The transport, event channel, work pool and rbtree_x partition locks
+ * are taken through these macros.  While __ntirpc_lock_stat is clear,
+ * each is one test ahead of the plain lock.  While set, every acquire
+ * is counted against its call site, and an acquire that does not get
+ * the lock on the first try is timed into a log2 histogram of waits.
+ */
+
+#ifndef TIRPC_LOCK_STAT_H
+#define TIRPC_LOCK_STAT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <rpc/types.h>
+#include <intrinsic.h>
+
+enum tirpc_lock_class {
+	TIRPC_LOCK_DPLX_SEND,	/* rpc_dplx send lock */
+	TIRPC_LOCK_DPLX_RECV,	/* rpc_dplx recv lock */
+	TIRPC_LOCK_DPLX_REC,	/* rpc_dplx_rec refcount lock */
+	TIRPC_LOCK_XPRT,	/* xp_lock */
+	TIRPC_LOCK_EVCHAN,	/* svc_rqst event channel (sr_rec->mtx) */
+	TIRPC_LOCK_POOL,	/* work pool queue */
+	TIRPC_LOCK_RBTX,	/* rbtree_x partition */
+	TIRPC_LOCK_CLASSES
+};
+
+/* bucket 0 is waits under 256ns, bucket n (n > 0) under 256ns << n */
+#define TIRPC_LOCK_STAT_BUCKETS 24
+
+struct tirpc_lock_stat {
+	const char *func;
+	int line;
+	u_int lclass;
+	uint64_t acquires;
+	uint64_t contended;
+	uint64_t wait_ns;	/* total, contended acquires only */
+	uint64_t hist[TIRPC_LOCK_STAT_BUCKETS];
+};
+
+extern uint32_t __ntirpc_lock_stat;
+
+void tirpc_lock_stat_mutex(pthread_mutex_t *, u_int, const char *, int);
+void tirpc_lock_stat_rdlock(pthread_rwlock_t *, u_int, const char *, int);
+void tirpc_lock_stat_wrlock(pthread_rwlock_t *, u_int, const char *, int);
+
+#define TIRPC_MUTEX_LOCK_AT(mtx, lclass, func, line) \
+	do {								\
+		if (unlikely(__ntirpc_lock_stat))			\
+			tirpc_lock_stat_mutex((mtx), (lclass),		\
+					      (func), (line));		\
+		else							\
+			pthread_mutex_lock(mtx);			\
+	} while (0)
+
+#define TIRPC_MUTEX_LOCK(mtx, lclass) \
+	TIRPC_MUTEX_LOCK_AT((mtx), (lclass), __func__, __LINE__)
+
+#define TIRPC_RDLOCK(rwl, lclass) \
+	do {								\
+		if (unlikely(__ntirpc_lock_stat))			\
+			tirpc_lock_stat_rdlock((rwl), (lclass),		\
+					       __func__, __LINE__);	\
+		else							\
+			pthread_rwlock_rdlock(rwl);			\
+	} while (0)
+
+#define TIRPC_WRLOCK(rwl, lclass) \
+	do {								\
+		if (unlikely(__ntirpc_lock_stat))			\
+			tirpc_lock_stat_wrlock((rwl), (lclass),		\
+					       __func__, __LINE__);	\
+		else							\
+			pthread_rwlock_wrlock(rwl);			\
+	} while (0)
+
+/*
+ * Counting starts and stops without clearing; reset zeroes every site
+ * (acquires racing with it may survive).
+ */
+void tirpc_lock_stat_enable(void);
+void tirpc_lock_stat_disable(void);
+void tirpc_lock_stat_reset(void);
+
+/*
+ * Copy out up to max call sites, most total wait first.  Returns the
+ * number copied.
+ */
+u_int tirpc_lock_stat_read(struct tirpc_lock_stat *sites, u_int max);
+
+/* One line per call site with any acquires, most total wait first */
+void tirpc_lock_stat_dump(FILE *fp);
+
+const char *tirpc_lock_class_name(u_int lclass);
+
+#endif				/* TIRPC_LOCK_STAT_H */
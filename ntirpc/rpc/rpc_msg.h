@@ -164,12 +164,16 @@ struct rpc_msg {
 
 	int32_t *rm_ibuf;
 	uint32_t rm_flags;
+	uint32_t rm_slow;	/* svc_slow.h slot + 1, or 0 */
 	/* queue of msgs for control xfer */
 	 TAILQ_ENTRY(rpc_msg) msg_q;
 	/* avoid separate alloc/free */
 	char cb_cred_body[MAX_AUTH_BYTES];
 	char cb_verf_body[MAX_AUTH_BYTES];
 	char rq_cred_body[MAX_AUTH_BYTES];	/* size is excessive */
+	/* svc_hist.h, with SVC_INIT_HISTOGRAMS */
+	void *rm_hist;		/* procedure set, once dispatched */
+	uint64_t rm_queued;	/* wakeup to receive, nanoseconds */
 };
 #define acpted_rply ru.RM_rmb.ru.RP_ar
 #define rjcted_rply ru.RM_rmb.ru.RP_dr
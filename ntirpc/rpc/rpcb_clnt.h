@@ -60,6 +60,25 @@
 #include <rpc/types.h>
 #include <rpc/rpcb_prot.h>
 
+/*
+ * rpcbind address cache parameters (TIRPC_GET_RPCB_CACHE and
+ * TIRPC_SET_RPCB_CACHE).  Setting them flushes the cache.  Only
+ * clnt_tp_ncreate() and its callers use the cache, and only for
+ * connection-oriented netids; rpcb_getaddr() always asks rpcbind.
+ *
+ * A program that is not registered is remembered for neg_ttl seconds
+ * (10 by default): clients created in that time fail with
+ * RPC_PROGNOTREGISTERED even once the server has registered.  Set
+ * neg_ttl to 0 where servers are started alongside their clients.
+ */
+struct rpcb_cache_params {
+	u_int ttl;		/* seconds an address is used (0: no cache) */
+	u_int neg_ttl;		/* seconds a lookup failure is remembered */
+	u_int stale;		/* seconds an expired address is used, while
+				 * it is refreshed in the background */
+	u_int max;		/* entries */
+};
+
 __BEGIN_DECLS
 extern bool rpcb_set(const rpcprog_t, const rpcvers_t,
 		     const struct netconfig *,
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file span.h
+ * @brief Sampled per-request trace spans
+ *
+ * @section DESCRIPTION
+ *
+ * While enabled, one request in every rate is sampled by a hash of its
+ * xid, so every stage of a sampled request is kept, and a client and
+ * server using the same rate sample the same calls.  Each span is a
+ * fixed size record, with start and end times, in a lock-free ring.
+ *
+ * The library records receive (read and decode of the call), auth,
+ * dispatch, reply (encode and enqueue) and flush (enqueue to written)
+ * spans.  Applications may add their own within dispatch, for the same
+ * xid, with TIRPC_SPAN_APP.  tirpc_span_export() writes the ring as
+ * Chrome trace event JSON (chrome://tracing, Perfetto), with the xid of
+ * each span in its args.
+ */
+
+#ifndef TIRPC_SPAN_H
+#define TIRPC_SPAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <rpc/types.h>
+#include <intrinsic.h>
+
+enum tirpc_span_stage {
+	TIRPC_SPAN_RECEIVE,	/* arg: proc */
+	TIRPC_SPAN_AUTH,	/* arg: auth_stat */
+	TIRPC_SPAN_DISPATCH,	/* arg: proc */
+	TIRPC_SPAN_REPLY,	/* arg: encoded (bool) */
+	TIRPC_SPAN_FLUSH,	/* arg: 0 */
+	TIRPC_SPAN_APP,		/* named by the application */
+	TIRPC_SPAN_STAGES
+};
+
+struct tirpc_span_rec {
+	uint64_t seq;		/* ring position + 1, 0 while written */
+	uint64_t start;		/* CLOCK_MONOTONIC nanoseconds */
+	uint64_t end;
+	const void *xprt;
+	const char *name;	/* TIRPC_SPAN_APP only, else NULL */
+	uint32_t stage;
+	uint32_t xid;
+	uint32_t arg;
+	uint32_t tid;
+};
+
+extern uint32_t __ntirpc_span_rate;	/* 0 while disabled */
+
+uint64_t tirpc_span_now(void);
+void tirpc_span_emit(u_int, const char *, const void *, uint32_t, uint32_t,
+		     uint64_t, uint64_t);
+
+static inline bool
+tirpc_span_sampled(uint32_t xid)
+{
+	uint32_t rate = __ntirpc_span_rate;
+
+	/* xids are usually sequential, so spread them first */
+	return (rate && ((xid * 2654435761U) >> 8) % rate == 0);
+}
+
+/* start time for a span, or 0 when the xid is not sampled */
+static inline uint64_t
+tirpc_span_begin(uint32_t xid)
+{
+	if (likely(!__ntirpc_span_rate) || !tirpc_span_sampled(xid))
+		return (0);
+	return (tirpc_span_now());
+}
+
+#define TIRPC_SPAN_END(stage, xprt, xid, arg, start) \
+	do {								\
+		if (unlikely(start))					\
+			tirpc_span_emit((stage), NULL, (xprt), (xid),	\
+					(arg), (start),			\
+					tirpc_span_now());		\
+	} while (0)
+
+/* name must outlive the ring, e.g. a string literal */
+#define TIRPC_SPAN_APP(name, xprt, xid, start) \
+	do {								\
+		if (unlikely(start))					\
+			tirpc_span_emit(TIRPC_SPAN_APP, (name), (xprt),	\
+					(xid), 0, (start),		\
+					tirpc_span_now());		\
+	} while (0)
+
+/*
+ * The ring is allocated by the first enable, rounded up to a power of
+ * two records, and kept until shutdown; later sizes are ignored.  A
+ * rate of 1 samples every request.
+ */
+bool tirpc_span_enable(u_int rate, u_int nrecs);
+void tirpc_span_disable(void);
+
+/*
+ * Copy out up to max records from *cursor (initially 0), advancing it.
+ * Records overwritten before they were read are skipped.
+ */
+u_int tirpc_span_read(struct tirpc_span_rec *recs, u_int max,
+		      uint64_t *cursor);
+
+/*
+ * Write every record from *cursor as one Chrome trace JSON document,
+ * advancing it.  Returns the number of spans written.
+ */
+u_int tirpc_span_export(FILE *fp, uint64_t *cursor);
+
+#endif				/* TIRPC_SPAN_H */
@@ -82,6 +82,24 @@
 #define SVC_INIT_WARNX          0x0004
 #define SVC_INIT_NOREG_XPRTS    0x0008
 #define SVC_INIT_BLKIN          0x0010
+#define SVC_INIT_AUTHUNIX_CACHE 0x0020
+#define SVC_INIT_AUTHUNIX_SHORT 0x0040	/* implies AUTHUNIX_CACHE */
+#define SVC_INIT_REPLY_SIZED    0x0080	/* size vc replies before encoding */
+#define SVC_INIT_ZEROCOPY       0x0100	/* MSG_ZEROCOPY for large vc replies */
+#define SVC_INIT_COALESCE       0x0200	/* MSG_MORE for queued vc replies */
+#define SVC_INIT_HISTOGRAMS     0x0400	/* latency histograms, svc_hist.h */
+#define SVC_INIT_STATS          0x0800	/* serve svc_stats.h snapshots */
+#define SVC_INIT_SLOW_REQUESTS  0x1000	/* log slow calls, svc_slow.h */
+#define SVC_INIT_IOQ_BACKLOG    0x2000	/* bound vc replies queued per xprt */
+#define SVC_INIT_MEM_BUDGET     0x4000	/* cap request memory, svc_mem.h */
+
+/*
+ * vc replies holding UIO_FLAG_FD file ranges (xdr.h) send each range
+ * with sendfile(2), straight from the page cache, so SVC_INIT_ZEROCOPY
+ * does not apply to them.  SVC_INIT_COALESCE applies to the memory
+ * segments ending such a reply; one ending in a file range is not held
+ * back for the replies queued behind it.
+ */
 
 #define SVC_SHUTDOWN_FLAG_NONE  0x0000
 
@@ -139,11 +157,32 @@ typedef struct svc_init_params {
 	u_int gss_max_idle_gen;
 	u_int gss_max_gc;
 	u_int ioq_thrd_max;
+	u_int authunix_hash_partitions;
+	u_int authunix_max_cred;
+	u_int authunix_short_max;
+	u_int authunix_short_ttl;	/* seconds */
+	u_int ioq_zerocopy_min;	/* smallest segment sent zero copy */
+	u_int ioq_coalesce_usec;	/* longest replies are held back */
+	const char *stats_path;	/* Unix socket, with SVC_INIT_STATS */
+	u_int slow_request_msec;	/* with SVC_INIT_SLOW_REQUESTS */
+	u_int ioq_backlog_bytes;	/* high watermarks, with */
+	u_int ioq_backlog_count;	/* SVC_INIT_IOQ_BACKLOG */
+	uint64_t mem_budget;	/* bytes, with SVC_INIT_MEM_BUDGET */
 } svc_init_params;
 
 /* Svc param flags */
 #define SVC_FLAG_NONE             0x0000
 #define SVC_FLAG_NOREG_XPRTS      0x0001
+#define SVC_FLAG_AUTHUNIX_CACHE   0x0002
+#define SVC_FLAG_AUTHUNIX_SHORT   0x0004
+#define SVC_FLAG_REPLY_SIZED      0x0008
+#define SVC_FLAG_ZEROCOPY         0x0010
+#define SVC_FLAG_COALESCE         0x0020
+#define SVC_FLAG_HISTOGRAMS       0x0040
+#define SVC_FLAG_SLOW_REQUESTS    0x0080
+#define SVC_FLAG_IOQ_BACKLOG      0x0100
+#define SVC_FLAG_MEM_BUDGET       0x0200
+#define SVC_FLAG_STATS            0x0400
 
 /*
  * SVCXPRT xp_flags
@@ -308,16 +347,52 @@ typedef struct rpc_svcxprt {
 		} epoll;
 #endif
 	} ev_u;
+
+	/* latency, with SVC_INIT_HISTOGRAMS (appended, keeps the layout
+	 * above for existing binaries) */
+	struct svc_hist_set *xp_hist;
+	uint64_t xp_wakeup;	/* last event, monotonic nanoseconds */
 } SVCXPRT;
 
+struct svc_proc_tbl;		/* forward decl. */
+struct svc_hist_set;		/* forward decl. */
+
 /* Service record used by exported search routines */
 typedef struct svc_record {
 	rpcprog_t sc_prog;
 	rpcvers_t sc_vers;
 	char *sc_netid;
 	void (*sc_dispatch) (struct svc_req *, SVCXPRT *);
+	struct svc_proc_tbl *sc_procs;	/* svc_reg_procs() only */
 } svc_rec_t;
 
+/*
+ * Per-procedure service description, for svc_reg_procs()
+ *
+ * The library decodes arguments (sp_args_size bytes) with sp_xdr_args
+ * into a pooled buffer, zeroes sp_res_size bytes for results, and calls
+ * sp_handler.  If the handler returns true, results are encoded with
+ * sp_xdr_res and sent; else the handler has replied (or will not).
+ * Arguments and results are freed by the library afterward, whichever
+ * the handler returned.
+ */
+typedef bool (*svc_proc_handler_t) (struct svc_req *, SVCXPRT *, void *,
+				    void *);
+
+struct svc_proc_desc {
+	svc_proc_handler_t sp_handler;	/* NULL: PROC_UNAVAIL */
+	xdrproc_t sp_xdr_args;
+	xdrproc_t sp_xdr_res;
+	u_int sp_args_size;
+	u_int sp_res_size;
+};
+
+struct svc_proc_stats {
+	uint64_t calls;		/* dispatched to sp_handler */
+	uint64_t garbage_args;	/* failed sp_xdr_args */
+	uint64_t send_errors;	/* failed reply */
+};
+
 typedef struct svc_vers_range {
 	rpcvers_t lowvers;
 	rpcvers_t highvers;
@@ -590,6 +665,38 @@ __END_DECLS
 __BEGIN_DECLS
 extern void svc_unreg(const rpcprog_t, const rpcvers_t);
 __END_DECLS
+/*
+ * Service registration with a table of procedures (indexed by proc)
+ *
+ * svc_reg_procs(xprt, prog, vers, procs, nprocs, nconf)
+ * const SVCXPRT *xprt;
+ * const rpcprog_t prog;
+ * const rpcvers_t vers;
+ * const struct svc_proc_desc *procs;  -- must outlive the registration
+ * const u_int nprocs;
+ * const struct netconfig *nconf;
+ */
+__BEGIN_DECLS
+extern bool svc_reg_procs(SVCXPRT *, const rpcprog_t, const rpcvers_t,
+			  const struct svc_proc_desc *, const u_int,
+			  const struct netconfig *);
+extern bool svc_proc_stats_get(const rpcprog_t, const rpcvers_t,
+			       const rpcproc_t, struct svc_proc_stats *);
+extern void svc_proc_dispatch(struct svc_proc_tbl *, struct svc_req *,
+			      SVCXPRT *);
+__END_DECLS
+
+/*
+ * Call a service record, as found by lookup
+ */
+static inline void
+svc_rec_dispatch(svc_rec_t *rec, struct svc_req *req, SVCXPRT *xprt)
+{
+	if (rec->sc_procs)
+		svc_proc_dispatch(rec->sc_procs, req, xprt);
+	else
+		(*rec->sc_dispatch) (req, xprt);
+}
 /*
  * Transport registration.
  *
@@ -80,4 +80,15 @@ extern enum auth_stat svc_auth_authenticate(struct svc_req *,
 extern int svc_auth_reg(int,
 			enum auth_stat (*)(struct svc_req *, struct rpc_msg *));
 __END_DECLS
+
+/*
+ * Interned AUTH_SYS credentials (SVC_INIT_AUTHUNIX_CACHE)
+ *
+ * rq_clntcred is shared and read only; SVCAUTH_RELEASE drops it.
+ */
+__BEGIN_DECLS
+extern void *svcauth_unix_get_private(struct svc_req *);
+extern bool svcauth_unix_set_private(struct svc_req *, void *,
+				     void (*)(void *));
+__END_DECLS
 #endif				/* !_RPC_SVC_AUTH_H */
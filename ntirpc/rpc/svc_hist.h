@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file svc_hist.h
+ * @brief Request latency histograms
+ *
+ * @section DESCRIPTION
+ *
+ * With SVC_INIT_HISTOGRAMS, latencies are recorded per transport and per
+ * (program, version, procedure) of calls dispatched to a registered
+ * service by svc_dispatch_default() or svc_getreq_default().  Buckets are logarithmic, four to each
+ * power of two microseconds, so any value is within 25% of its bucket's
+ * lower bound.
+ */
+
+#ifndef TIRPC_SVC_HIST_H
+#define TIRPC_SVC_HIST_H
+
+#include <rpc/svc.h>
+
+#define SVC_HIST_BUCKETS 96	/* last also holds everything past 33s */
+
+enum svc_hist_kind {
+	SVC_HIST_QUEUE,		/* event wakeup to receive by a worker */
+	SVC_HIST_SERVICE,	/* dispatch */
+	SVC_HIST_FLUSH,		/* reply enqueue to written */
+	SVC_HIST_KINDS
+};
+
+struct svc_hist {
+	uint64_t count;
+	uint64_t sum;		/* microseconds */
+	uint64_t bucket[SVC_HIST_BUCKETS];
+};
+
+__BEGIN_DECLS
+/* lower bound of a bucket, in microseconds */
+extern uint64_t svc_hist_bucket_usec(u_int);
+
+/* lower bound of the bucket holding the given percentile (0-100) */
+extern uint64_t svc_hist_percentile(const struct svc_hist *, double);
+
+/* merged over all threads; false if nothing has been recorded */
+extern bool svc_hist_xprt_get(SVCXPRT *, enum svc_hist_kind,
+			      struct svc_hist *);
+extern bool svc_hist_proc_get(const rpcprog_t, const rpcvers_t,
+			      const rpcproc_t, enum svc_hist_kind,
+			      struct svc_hist *);
+__END_DECLS
+
+#endif				/* TIRPC_SVC_HIST_H */
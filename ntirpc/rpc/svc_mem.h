@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file svc_mem.h
+ * @brief Request memory accounting and budget
+ *
+ * @section DESCRIPTION
+ *
+ * Buffers that grow with load are counted by category.  Each thread
+ * batches its changes until it exits, so a gauge may lag by up to
+ * SVC_MEM_BATCH bytes per thread.
+ *
+ * With SVC_INIT_MEM_BUDGET, once the total reaches
+ * svc_init_params.mem_budget, transports are re-armed only for hangups
+ * and new connections are closed as they are accepted.  Calls already
+ * read into a receive buffer are still served, so the total can
+ * overshoot by their replies.  Both resume when the total falls to 7/8
+ * of the budget.  While it stays over, waiting transports are still
+ * re-armed about once a second, so a budget that idle receive buffers
+ * fill slows the server down rather than stopping it.
+ */
+
+#ifndef TIRPC_SVC_MEM_H
+#define TIRPC_SVC_MEM_H
+
+#include <rpc/svc.h>
+
+#define SVC_MEM_BATCH 65536
+
+enum svc_mem_cat {
+	SVC_MEM_INREC,		/* xdr_inrec receive buffers */
+	SVC_MEM_IOQ,		/* xdr_ioq segment buffers */
+	SVC_MEM_RPC_MSG,	/* alloc_rpc_msg() */
+	SVC_MEM_DRC,		/* duplicate request cache */
+	SVC_MEM_CATS
+};
+
+struct svc_mem_stats {
+	int64_t bytes[SVC_MEM_CATS];
+	int64_t total;
+	uint64_t budget;	/* 0 without SVC_INIT_MEM_BUDGET */
+	bool over;
+};
+
+__BEGIN_DECLS
+/* also for memory the application keeps, such as its own DRC */
+extern void svc_mem_add(enum svc_mem_cat, int64_t);
+extern void svc_mem_get(struct svc_mem_stats *);
+extern const char *svc_mem_name(enum svc_mem_cat);
+__END_DECLS
+
+#endif				/* TIRPC_SVC_MEM_H */
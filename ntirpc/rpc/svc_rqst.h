@@ -48,6 +48,7 @@
 #define SVC_RQST_FLAG_SREC_LOCKED	0x01000000
 #define SVC_RQST_FLAG_SREC_UNLOCK	0x02000000
 #define SVC_RQST_FLAG_XPRT_UREG		0x04000000
+#define SVC_RQST_FLAG_MEM_RESUME	0x10000000 /* from svc_mem, not parked */
 #define SR_REQ_RELEASE_KEEP_LOCKED	0x08000000
 
 /*
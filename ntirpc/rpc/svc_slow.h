@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file svc_slow.h
+ * @brief Slow request watchdog
+ *
+ * @section DESCRIPTION
+ *
+ * With SVC_INIT_SLOW_REQUESTS, each call takes a slot in a fixed table
+ * when its header is decoded, and the time it reaches each stage is
+ * stored there.  A watchdog thread scans the table, and a call still in
+ * flight past svc_init_params.slow_request_msec is logged once; it is
+ * logged again, with every stage, when it completes.  One line each:
+ *
+ *   slow request <state> xprt <ptr> fd <fd> xid <xid> <prog>/<vers>/<proc>
+ *	queue <us> auth <us> service <us> flush <us> tid <tid>
+ *
+ * where state is the stage still running, or "done".  Stages not reached
+ * are "-".  Tid is the thread that dispatched the call, to take a stack
+ * of while it is still in service.
+ *
+ * Applications that dispatch calls themselves, instead of through
+ * svc_getreq_default() or svc_dispatch_default(), mark the dispatch with
+ * svc_slow_stage(req, SVC_SLOW_DISPATCHED).
+ */
+
+#ifndef TIRPC_SVC_SLOW_H
+#define TIRPC_SVC_SLOW_H
+
+#include <rpc/svc.h>
+
+enum svc_slow_stage {
+	SVC_SLOW_QUEUED,	/* event wakeup, waiting for a worker */
+	SVC_SLOW_RECEIVED,	/* call header decoded */
+	SVC_SLOW_DISPATCHED,	/* handed to the service */
+	SVC_SLOW_REPLIED,	/* reply encoded and queued */
+	SVC_SLOW_FLUSHED,	/* reply written */
+	SVC_SLOW_STAGES
+};
+
+__BEGIN_DECLS
+extern void svc_slow_stage(struct svc_req *, enum svc_slow_stage);
+__END_DECLS
+
+#endif				/* TIRPC_SVC_SLOW_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file svc_stats.h
+ * @brief Transport-neutral service statistics
+ *
+ * @section DESCRIPTION
+ *
+ * Counters are kept per CPU and summed by readers, but only with
+ * SVC_INIT_STATS (stats_path may be NULL) or once svc_stats_listen() has
+ * succeeded.  Then every connection to the Unix socket is sent
+ * one snapshot, as "name value" lines, and closed.  The svc_mem.h gauges
+ * follow as "mem_<category> <bytes>" lines.  Per transport lines
+ * are "xprt <fd> <type> <queued replies> <queued bytes> <throttled>",
+ * followed by any lock call sites counted since tirpc_lock_stat_enable()
+ * (see lock_stat.h).  Queued bytes are only counted with
+ * SVC_INIT_IOQ_BACKLOG.
+ */
+
+#ifndef TIRPC_SVC_STATS_H
+#define TIRPC_SVC_STATS_H
+
+#include <rpc/svc.h>
+
+enum svc_stat {
+	SVC_STAT_REQUESTS,	/* calls decoded */
+	SVC_STAT_RX_BYTES,
+	SVC_STAT_TX_BYTES,
+	SVC_STAT_RECV_ERRORS,	/* failed receive or call header */
+	SVC_STAT_AUTH_ERRORS,
+	SVC_STAT_SEND_ERRORS,
+	SVC_STAT_DRC_HITS,	/* duplicate request cache */
+	SVC_STAT_DRC_MISSES,
+	SVC_STAT_GSS_HITS,	/* RPCSEC_GSS context cache */
+	SVC_STAT_GSS_MISSES,
+	SVC_STAT_SLOW_REQUESTS,	/* past svc_slow.h threshold */
+	SVC_STAT_SLOW_UNTRACKED,	/* no free watchdog slot */
+	SVC_STAT_IOQ_THROTTLED,	/* xprt over an ioq backlog watermark */
+	SVC_STAT_IOQ_DEFERRED,	/* receive re-arm held back */
+	SVC_STAT_IOQ_RESUMED,	/* and re-armed once drained */
+	SVC_STAT_MEM_OVER,	/* svc_mem.h budget reached */
+	SVC_STAT_MEM_PAUSED,	/* receive re-arm held back */
+	SVC_STAT_MEM_SHED,	/* connection closed on accept */
+	SVC_STAT_MEM_PROBED,	/* parked xprts re-armed while over */
+	SVC_STAT_COUNTERS
+};
+
+struct svc_stats {
+	uint64_t counter[SVC_STAT_COUNTERS];
+	uint32_t xprts;
+	uint32_t pool_threads;	/* svc_work_pool */
+	uint32_t pool_idle;
+	uint32_t pool_queued;
+	uint32_t ioq_queued;	/* replies waiting on all vc xprts */
+	uint32_t ioq_max;	/* on the most backlogged one */
+	uint32_t ioq_throttled;	/* xprts not reading, SVC_INIT_IOQ_BACKLOG */
+	uint64_t ioq_bytes;	/* queued, SVC_INIT_IOQ_BACKLOG */
+};
+
+__BEGIN_DECLS
+/* also for counters the application keeps, such as its own DRC */
+extern void svc_stats_add(enum svc_stat, uint64_t);
+extern void svc_stats_get(struct svc_stats *);
+extern const char *svc_stats_name(enum svc_stat);
+
+/* serve snapshots at path, replacing any existing socket */
+extern bool svc_stats_listen(const char *);
+__END_DECLS
+
+#endif				/* TIRPC_SVC_STATS_H */
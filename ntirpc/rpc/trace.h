@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.h
+ * @brief Request lifecycle tracepoints
+ *
+ * @section DESCRIPTION
+ *
+ * Each tracepoint is a test of one bit in __ntirpc_trace_mask.  When
+ * enabled, it appends a fixed size binary record to a lock-free ring,
+ * without formatting; consumers copy records out with tirpc_trace_read().
+ */
+
+#ifndef TIRPC_TRACE_H
+#define TIRPC_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <rpc/types.h>
+#include <intrinsic.h>
+
+enum tirpc_trace_point {
+	TIRPC_TRACE_RECV,	/* xprt, 0, datagram length */
+	TIRPC_TRACE_DECODE,	/* xprt, xid, proc */
+	TIRPC_TRACE_AUTH,	/* xprt, xid, auth_stat */
+	TIRPC_TRACE_DISPATCH,	/* xprt, xid, proc */
+	TIRPC_TRACE_REPLY,	/* xprt, xid, encoded (bool) */
+	TIRPC_TRACE_FLUSH,	/* xprt, 0, bytes */
+	TIRPC_TRACE_TASK,	/* work_pool_entry, 0, 0 */
+	TIRPC_TRACE_WAIT,	/* work_pool, 0, 0 */
+	TIRPC_TRACE_POINTS
+};
+
+#define TIRPC_TRACE_ALL ((1 << TIRPC_TRACE_POINTS) - 1)
+
+struct tirpc_trace_rec {
+	uint64_t seq;		/* ring position + 1, 0 while written */
+	uint64_t ts;		/* CLOCK_MONOTONIC nanoseconds */
+	const void *obj;
+	uint32_t point;
+	uint32_t xid;
+	uint32_t arg;
+	uint32_t tid;
+};
+
+extern uint32_t __ntirpc_trace_mask;
+
+void tirpc_trace_emit(u_int, const void *, uint32_t, uint32_t);
+
+#define TIRPC_TRACE(point, obj, xid, arg) \
+	do {								\
+		if (unlikely(__ntirpc_trace_mask & (1 << (point))))	\
+			tirpc_trace_emit((point), (obj), (xid), (arg));	\
+	} while (0)
+
+/*
+ * The ring is allocated by the first enable, rounded up to a power of
+ * two records, and kept until shutdown; later sizes are ignored.
+ */
+bool tirpc_trace_enable(uint32_t mask, u_int nrecs);
+void tirpc_trace_disable(void);
+
+/*
+ * Copy out up to max records from *cursor (initially 0), advancing it.
+ * Records overwritten before they were read are skipped.
+ */
+u_int tirpc_trace_read(struct tirpc_trace_rec *recs, u_int max,
+		       uint64_t *cursor);
+
+#endif				/* TIRPC_TRACE_H */
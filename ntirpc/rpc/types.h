@@ -121,6 +121,8 @@ typedef int32_t rpc_inline_t;
 #define TIRPC_SET_DEBUG_FLAGS      10
 #define TIRPC_GET_WARNX            11
 #define TIRPC_SET_WARNX            12
+#define TIRPC_GET_RPCB_CACHE       13
+#define TIRPC_SET_RPCB_CACHE       14
 
 /*
  * Debug flags support
@@ -44,6 +44,7 @@
 #include <sys/cdefs.h>
 #include <misc/stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #if !defined(_WIN32)
 #include <netinet/in.h>
 #endif
@@ -124,6 +125,8 @@ typedef struct xdr_vio {
 #define UIO_FLAG_FREE		0x0002
 #define UIO_FLAG_BUFQ		0x0004
 #define UIO_FLAG_REALLOC	0x0008
+#define UIO_FLAG_FD		0x0010
+#define UIO_FLAG_MEMACCT	0x0020	/* counted in svc_mem.h */
 
 struct xdr_uio;
 typedef void (*xdr_uio_release)(struct xdr_uio *, u_int);
@@ -143,6 +146,23 @@ typedef struct xdr_uio {
 	xdr_vio	uio_vio[0];	/* appended vectors */
 } xdr_uio;
 
+/*
+ * UIO_FLAG_FD vectors are ranges of the file descriptor in uio_u1, from
+ * file offset vio_head to vio_tail, rather than memory (so offsets are
+ * limited to the pointer width).
+ */
+static inline int
+xdr_uio_fd(xdr_uio *uio)
+{
+	return ((int)(intptr_t)uio->uio_u1);
+}
+
+static inline off_t
+xdr_vio_offset(xdr_vio *vio)
+{
+	return ((off_t)(uintptr_t)vio->vio_head);
+}
+
 /* Op flags */
 #define XDR_PUTBUFS_FLAG_NONE    0x0000
 #define XDR_PUTBUFS_FLAG_RDNLY   0x0001
@@ -150,6 +170,7 @@ typedef struct xdr_uio {
 #define XDR_FLAG_NONE    0x0000
 #define XDR_FLAG_CKSUM   0x0001
 #define XDR_FLAG_VIO     0x0002
+#define XDR_FLAG_NOSPLICE 0x0004	/* XDR_PUTBUFS copies */
 
 /*
  * The XDR handle.
@@ -179,7 +200,7 @@ typedef struct rpc_xdr {
 		void (*x_destroy)(struct rpc_xdr *);
 		bool (*x_control)(struct rpc_xdr *, int, void *);
 		/* new vector and refcounted interfaces */
-		bool (*x_getbufs)(struct rpc_xdr *, xdr_uio *, u_int);
+		bool (*x_getbufs)(struct rpc_xdr *, xdr_uio **, u_int, u_int);
 		bool (*x_putbufs)(struct rpc_xdr *, xdr_uio *, u_int);
 	} *x_ops;
 	void *x_public; /* users' data */
@@ -274,21 +295,91 @@ xdr_putlong(XDR *xdrs, const long *lp)
 #define XDR_GETLONG(xdrs, lp) xdr_getlong(xdrs, lp)
 #define XDR_PUTLONG(xdrs, lp) xdr_putlong(xdrs, lp)
 
-#define XDR_GETBYTES(xdrs, addr, len)   \
-	(*(xdrs)->x_ops->x_getbytes)(xdrs, addr, len)
-#define xdr_getbytes(xdrs, addr, len)			\
-	(*(xdrs)->x_ops->x_getbytes)(xdrs, addr, len)
+/*
+ * Streams with XDR_FLAG_VIO (xdrmem, xdr_ioq) keep their fill position
+ * in x_private, bounded by x_v.  Within the current buffer, the bytes
+ * and inline operations below are direct pointer bumps, with a single
+ * bounds check; otherwise they fall through to x_ops.
+ */
+static inline void *
+xdr_vio_inline(XDR *xdrs, u_int len)
+{
+	void *here = xdrs->x_private;
+	void *future = here + len;
+
+	if (!(xdrs->x_flags & XDR_FLAG_VIO))
+		return (NULL);
+	switch (xdrs->x_op) {
+	case XDR_DECODE:
+		if (unlikely(future > xdrs->x_v.vio_tail))
+			return (NULL);
+		break;
+	case XDR_ENCODE:
+		if (unlikely(future > xdrs->x_v.vio_wrap))
+			return (NULL);
+		break;
+	default:
+		return (NULL);
+	}
+	xdrs->x_private = future;
+	return (here);
+}
 
-#define XDR_PUTBYTES(xdrs, addr, len)			\
-	(*(xdrs)->x_ops->x_putbytes)(xdrs, addr, len)
-#define xdr_putbytes(xdrs, addr, len)			\
-	(*(xdrs)->x_ops->x_putbytes)(xdrs, addr, len)
+static inline bool
+xdr_getbytes(XDR *xdrs, char *addr, u_int len)
+{
+	void *future;
 
+	if (!(xdrs->x_flags & XDR_FLAG_VIO)
+	 || unlikely((future = xdrs->x_private + len) > xdrs->x_v.vio_tail)) {
+		return (*xdrs->x_ops->x_getbytes)(xdrs, addr, len);
+	}
+	memmove(addr, xdrs->x_private, len);
+	xdrs->x_private = future;
+	return (true);
+}
+
+static inline bool
+xdr_putbytes(XDR *xdrs, const char *addr, u_int len)
+{
+	void *future;
+
+	if (!(xdrs->x_flags & XDR_FLAG_VIO)
+	 || unlikely((future = xdrs->x_private + len) > xdrs->x_v.vio_wrap)) {
+		return (*xdrs->x_ops->x_putbytes)(xdrs, addr, len);
+	}
+	memmove(xdrs->x_private, addr, len);
+	xdrs->x_private = future;
+	return (true);
+}
+
+#define XDR_GETBYTES(xdrs, addr, len) xdr_getbytes(xdrs, addr, len)
+#define XDR_PUTBYTES(xdrs, addr, len) xdr_putbytes(xdrs, addr, len)
+
+/*
+ * Consume len bytes of a decode stream, returning in *uio a new xdr_uio
+ * whose vectors reference the stream's own buffers.  The buffers stay
+ * valid until the caller calls (*uio)->uio_release(*uio, UIO_FLAG_NONE).
+ * Returns false, having consumed nothing, where the stream cannot lend.
+ */
 #define XDR_GETBUFS(xdrs, uio, len, flags)		\
 	(*(xdrs)->x_ops->x_getbufs)(xdrs, uio, len, flags)
 #define xdr_getbufs(xdrs, uio, len, flags)		\
 	(*(xdrs)->x_ops->x_getbufs)(xdrs, uio, len, flags)
 
+/*
+ * Append the vectors (vio_head to vio_tail) of uio to an encode stream,
+ * splicing them in place where the stream can, else copying (reading
+ * UIO_FLAG_FD ranges).  Ownership follows
+ * uio->uio_flags:
+ *   UIO_FLAG_GIFT	the caller's reference on uio passes to the stream,
+ *			else the stream takes one of its own;
+ *   UIO_FLAG_FREE	the vector buffers (vio_base to vio_wrap) are
+ *			mem_alloc'd, and the stream frees them.
+ * The stream drops its reference with uio->uio_release (if any) once the
+ * bytes are sent or copied; without uio_release, the buffers must
+ * outlive the stream.  On failure, the caller keeps ownership.
+ */
 #define XDR_PUTBUFS(xdrs, uio, flags)			\
 	(*(xdrs)->x_ops->x_putbufs)(xdrs, uio, flags)
 #define xdr_putbufs(xdrs, uio, flags)			\
@@ -304,10 +395,17 @@ xdr_putlong(XDR *xdrs, const long *lp)
 #define xdr_setpos(xdrs, pos)			\
 	(*(xdrs)->x_ops->x_setpostn)(xdrs, pos)
 
-#define XDR_INLINE(xdrs, len)			\
-	(*(xdrs)->x_ops->x_inline)(xdrs, len)
-#define xdr_inline(xdrs, len)			\
-	(*(xdrs)->x_ops->x_inline)(xdrs, len)
+static inline int32_t *
+xdr_inline(XDR *xdrs, u_int len)
+{
+	int32_t *buf = xdr_vio_inline(xdrs, len);
+
+	if (likely(buf != NULL))
+		return (buf);
+	return (*xdrs->x_ops->x_inline)(xdrs, len);
+}
+
+#define XDR_INLINE(xdrs, len) xdr_inline(xdrs, len)
 
 #define XDR_DESTROY(xdrs)	     \
 	if ((xdrs)->x_ops->x_destroy)			\
@@ -623,12 +721,20 @@ extern bool xdr_enum(XDR *, enum_t *);
 extern bool xdr_array(XDR *, char **, u_int *, u_int, u_int, xdrproc_t);
 extern bool xdr_bytes(XDR *, char **, u_int *, u_int);
 extern bool xdr_opaque(XDR *, char *, u_int);
+extern bool xdr_opaque_uio(XDR *, xdr_uio **, u_int);
+extern bool xdr_bytes_uio(XDR *, xdr_uio **, u_int *, u_int);
+extern bool xdr_putbufs_copy(XDR *, xdr_uio *, u_int);
+extern void xdr_putbufs_release(xdr_uio *);
 extern bool xdr_string(XDR *, char **, u_int);
 extern bool xdr_union(XDR *, enum_t *, char *, const struct xdr_discrim *,
 		      xdrproc_t);
 extern bool xdr_char(XDR *, char *);
 extern bool xdr_u_char(XDR *, u_char *);
 extern bool xdr_vector(XDR *, char *, u_int, u_int, xdrproc_t);
+extern bool xdr_array_u32(XDR *, uint32_t **, u_int *, u_int);
+extern bool xdr_array_u64(XDR *, uint64_t **, u_int *, u_int);
+extern bool xdr_vector_u32(XDR *, uint32_t *, u_int);
+extern bool xdr_vector_u64(XDR *, uint64_t *, u_int);
 extern bool xdr_float(XDR *, float *);
 extern bool xdr_double(XDR *, double *);
 extern bool xdr_quadruple(XDR *, long double *);
@@ -678,6 +784,10 @@ extern void xdrmem_ncreate(XDR *, char *, u_int, enum xdr_op);
 /* intrinsic checksum (be careful) */
 extern uint64_t xdrmem_cksum(XDR *, u_int);
 
+/* XDR counting encoded bytes only */
+extern void xdrsize_create(XDR *);
+extern u_long xdr_sizeof(xdrproc_t, void *);
+
 /* XDR using stdio library */
 extern void xdrstdio_create(XDR *, FILE *, enum xdr_op);
 
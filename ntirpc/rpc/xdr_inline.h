@@ -44,6 +44,7 @@
 #if !defined(_WIN32)
 #include <err.h>
 #endif
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -415,6 +416,24 @@ inline_xdr_enum(XDR *xdrs, enum_t *ep)
 	}
 }
 
+/*
+ * decode window
+ * Returns len bytes (a multiple of BYTES_PER_XDR_UNIT) in place when
+ * the stream has them contiguous, else copies them into stage, which
+ * must be at least len bytes.  Either way, one stream operation.
+ */
+static inline int32_t *
+inline_xdr_getwindow(XDR *xdrs, u_int len, int32_t *stage)
+{
+	int32_t *buf = XDR_INLINE(xdrs, len);
+
+	if (buf != NULL)
+		return (buf);
+	if (!XDR_GETBYTES(xdrs, (caddr_t) stage, len))
+		return (NULL);
+	return (stage);
+}
+
 /*
  * decode opaque data
  * Allows the specification of a fixed size sequence of opaque bytes.
@@ -423,6 +442,7 @@ inline_xdr_enum(XDR *xdrs, enum_t *ep)
 static inline bool
 inline_xdr_getopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 {
+	void *buf;
 	u_int rndup;
 
 	/*
@@ -431,11 +451,27 @@ inline_xdr_getopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	if (cnt == 0)
 		return (true);
 
+	/* RNDUP(cnt) would wrap */
+	if (unlikely(cnt > UINT_MAX - BYTES_PER_XDR_UNIT)) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s:%u ERROR cnt %u",
+			__func__, __LINE__, cnt);
+		return (false);
+	}
+
+	/* data and padding in one step.  memmove, as gcc may expand a
+	 * bounded memcpy into a slow rep movs.
+	 */
+	buf = xdr_vio_inline(xdrs, RNDUP(cnt));
+	if (likely(buf != NULL)) {
+		memmove(cp, buf, cnt);
+		return (true);
+	}
+
 	/*
-	 * XDR_INLINE is just as likely to do a function call,
-	 * so don't bother with it here.
+	 * not contiguous here, so straight to the stream's own routine
 	 */
-	if (!XDR_GETBYTES(xdrs, cp, cnt)) {
+	if (!(*xdrs->x_ops->x_getbytes)(xdrs, cp, cnt)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s:%u ERROR opaque",
 			__func__, __LINE__);
@@ -450,8 +486,8 @@ inline_xdr_getopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	if (rndup > 0) {
 		uint32_t crud;
 
-		if (!XDR_GETBYTES(xdrs, (caddr_t) &crud,
-				  BYTES_PER_XDR_UNIT - rndup)) {
+		if (!(*xdrs->x_ops->x_getbytes)(xdrs, (caddr_t) &crud,
+						 BYTES_PER_XDR_UNIT - rndup)) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
 				"%s:%u ERROR crud",
 				__func__, __LINE__);
@@ -470,6 +506,7 @@ inline_xdr_getopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 static inline bool
 inline_xdr_putopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 {
+	void *buf;
 	u_int rndup;
 
 	/*
@@ -478,11 +515,26 @@ inline_xdr_putopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	if (cnt == 0)
 		return (true);
 
+	/* RNDUP(cnt) would wrap */
+	if (unlikely(cnt > UINT_MAX - BYTES_PER_XDR_UNIT)) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s:%u ERROR cnt %u",
+			__func__, __LINE__, cnt);
+		return (false);
+	}
+
+	/* data and padding in one step */
+	buf = xdr_vio_inline(xdrs, RNDUP(cnt));
+	if (likely(buf != NULL)) {
+		*(uint32_t *) (buf + RNDUP(cnt) - BYTES_PER_XDR_UNIT) = 0;
+		memmove(buf, cp, cnt);
+		return (true);
+	}
+
 	/*
-	 * XDR_INLINE is just as likely to do a function call,
-	 * so don't bother with it here.
+	 * not contiguous here, so straight to the stream's own routine
 	 */
-	if (!XDR_PUTBYTES(xdrs, cp, cnt)) {
+	if (!(*xdrs->x_ops->x_putbytes)(xdrs, cp, cnt)) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s:%u ERROR opaque",
 			__func__, __LINE__);
@@ -497,8 +549,8 @@ inline_xdr_putopaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	if (rndup > 0) {
 		uint32_t zero = 0;
 
-		if (!XDR_PUTBYTES(xdrs, (caddr_t) &zero,
-				  BYTES_PER_XDR_UNIT - rndup)) {
+		if (!(*xdrs->x_ops->x_putbytes)(xdrs, (caddr_t) &zero,
+						 BYTES_PER_XDR_UNIT - rndup)) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
 				"%s:%u ERROR zero",
 				__func__, __LINE__);
@@ -533,6 +585,31 @@ inline_xdr_opaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	return (false);
 }
 
+/*
+ * encode counted bytes (length, data and padding) in one step, when
+ * the stream has room inline; false otherwise, and nothing is encoded.
+ */
+static inline bool
+inline_xdr_putcounted(XDR *xdrs, const char *sp, u_int cnt)
+{
+	void *buf;
+
+	/* the length unit plus RNDUP(cnt) would wrap */
+	if (unlikely(cnt > UINT_MAX - 2 * BYTES_PER_XDR_UNIT))
+		return (false);
+	buf = xdr_vio_inline(xdrs, BYTES_PER_XDR_UNIT + RNDUP(cnt));
+	if (buf == NULL)
+		return (false);
+	*(uint32_t *) buf = htonl(cnt);
+	if (cnt) {
+		buf += BYTES_PER_XDR_UNIT;
+		/* zero the padding (last unit), then overlay the data */
+		*(uint32_t *) (buf + RNDUP(cnt) - BYTES_PER_XDR_UNIT) = 0;
+		memmove(buf, sp, cnt);
+	}
+	return (true);
+}
+
 /*
  * XDR counted bytes
  * *cpp is a pointer to the bytes, *sizep is the count.
@@ -545,6 +622,10 @@ inline_xdr_bytes(XDR *xdrs, char **cpp, u_int *sizep,
 	char *sp = *cpp;	/* sp is the actual string pointer */
 	u_int nodesize;
 
+	if (xdrs->x_op == XDR_ENCODE && *sizep <= maxsize
+	    && inline_xdr_putcounted(xdrs, sp, *sizep))
+		return (true);
+
 	/*
 	 * first deal with the length since xdr bytes are counted
 	 */
@@ -671,6 +752,9 @@ inline_xdr_string(XDR *xdrs, char **cpp, u_int maxsize)
 		if (sp == NULL)
 			return false;
 		size = strlen(sp);
+		if (xdrs->x_op == XDR_ENCODE && size <= maxsize
+		    && inline_xdr_putcounted(xdrs, sp, size))
+			return (true);
 		break;
 	case XDR_DECODE:
 		break;
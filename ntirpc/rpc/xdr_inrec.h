@@ -44,6 +44,9 @@ extern bool xdr_inrec_skiprecord(XDR *);
 /* true if no more input */
 extern bool xdr_inrec_eof(XDR *);
 
+/* true if input is already buffered, without reading more */
+extern bool xdr_inrec_buffered(XDR *);
+
 /* intrinsic checksum (be careful) */
 extern uint64_t xdr_inrec_cksum(XDR *);
 
@@ -88,6 +88,20 @@ struct xdr_ioq {
 	struct xdr_ioq_uv_head ioq_uv;	/* header/vectors */
 
 	uint64_t id;
+
+	/* svc_hist, when enqueued for output */
+	struct svc_hist_set *ioq_hist;
+	uint64_t ioq_ts;
+
+	/* span.h, when the reply's xid is sampled */
+	uint64_t ioq_span;
+	uint32_t ioq_xid;
+
+	/* svc_slow.h slot + 1, ended when written */
+	uint32_t ioq_slow;
+
+	/* counted in its xprt's backlog, until dequeued */
+	u_int ioq_backlog;
 };
 
 #define _IOQ(p) (opr_containerof((p), struct xdr_ioq, ioq_s))
@@ -112,6 +126,8 @@ extern struct poolq_entry *xdr_ioq_uv_fetch_nothing(struct xdr_ioq *xioq,
 extern void xdr_ioq_uv_release(struct xdr_ioq_uv *uv);
 
 extern XDR *xdr_ioq_create(u_int min_bsize, u_int max_bsize, u_int uio_flags);
+extern XDR *xdr_ioq_create_sized(u_int size, u_int min_bsize,
+				 u_int max_bsize, u_int uio_flags);
 extern void xdr_ioq_release(struct poolq_head *ioqh);
 extern void xdr_ioq_reset(struct xdr_ioq *xioq, u_int wh_pos);
 extern void xdr_ioq_setup(struct xdr_ioq *xioq);
@@ -72,6 +72,7 @@ static struct auth_ops *authunix_ops(void);
  * This struct is pointed to by the ah_private field of an auth_handle.
  */
 struct audata {
+	mutex_t au_lock;	/* serializes cred switches and marshalling */
 	struct opaque_auth au_origcred;	/* original credentials */
 	struct opaque_auth au_shcred;	/* short hand cred */
 	u_long au_shfaults;	/* short hand cache faults */
@@ -121,6 +122,7 @@ authunix_ncreate(char *machname, uid_t uid, gid_t gid, int len,
 	auth->ah_private = (caddr_t) au;
 	auth->ah_verf = au->au_shcred = _null_auth;
 	auth->ah_refcnt = 1;
+	mutex_init(&au->au_lock, NULL);
 	au->au_shfaults = 0;
 	au->au_origcred.oa_base = NULL;
 
@@ -263,17 +265,27 @@ static bool
 authunix_marshal(AUTH *auth, XDR *xdrs)
 {
 	struct audata *au;
+	bool rslt;
 
 	assert(auth != NULL);
 	assert(xdrs != NULL);
 
 	au = AUTH_PRIVATE(auth);
-	return (XDR_PUTBYTES(xdrs, au->au_marshed, au->au_mpos));
+	mutex_lock(&au->au_lock);
+	rslt = XDR_PUTBYTES(xdrs, au->au_marshed, au->au_mpos);
+	mutex_unlock(&au->au_lock);
+	return (rslt);
 }
 
+/*
+ * A server offering a shorthand returns it in an AUTH_SHORT verifier;
+ * switch subsequent calls to it.  Calls already in flight with the
+ * full credential may return the same shorthand again.
+ */
 static bool
 authunix_validate(AUTH *auth, struct opaque_auth *verf)
 {
+	struct opaque_auth shcred;
 	struct audata *au;
 	XDR xdrs;
 
@@ -285,20 +297,40 @@ authunix_validate(AUTH *auth, struct opaque_auth *verf)
 		xdrmem_create(&xdrs, verf->oa_base, verf->oa_length,
 			      XDR_DECODE);
 
+		shcred.oa_base = NULL;
+		if (!xdr_opaque_auth(&xdrs, &shcred)) {
+			xdrs.x_op = XDR_FREE;
+			(void)xdr_opaque_auth(&xdrs, &shcred);
+			shcred.oa_base = NULL;
+		}
+		XDR_DESTROY(&xdrs);
+
+		mutex_lock(&au->au_lock);
+		if (shcred.oa_base != NULL
+		    && au->au_shcred.oa_base != NULL
+		    && shcred.oa_flavor == au->au_shcred.oa_flavor
+		    && shcred.oa_length == au->au_shcred.oa_length
+		    && !memcmp(shcred.oa_base, au->au_shcred.oa_base,
+			       shcred.oa_length)) {
+			/* unchanged */
+			mutex_unlock(&au->au_lock);
+			mem_free(shcred.oa_base, shcred.oa_length);
+			return (true);
+		}
+
 		if (au->au_shcred.oa_base != NULL) {
 			mem_free(au->au_shcred.oa_base,
 				 au->au_shcred.oa_length);
 			au->au_shcred.oa_base = NULL;
 		}
-		if (xdr_opaque_auth(&xdrs, &au->au_shcred)) {
+		if (shcred.oa_base != NULL) {
+			au->au_shcred = shcred;
 			auth->ah_cred = au->au_shcred;
 		} else {
-			xdrs.x_op = XDR_FREE;
-			(void)xdr_opaque_auth(&xdrs, &au->au_shcred);
-			au->au_shcred.oa_base = NULL;
 			auth->ah_cred = au->au_origcred;
 		}
 		marshal_new_auth(auth);
+		mutex_unlock(&au->au_lock);
 	}
 	return (true);
 }
@@ -314,8 +346,10 @@ authunix_refresh(AUTH *auth, void *dummy)
 
 	assert(auth != NULL);
 
+	mutex_lock(&au->au_lock);
 	if (auth->ah_cred.oa_base == au->au_origcred.oa_base) {
 		/* there is no hope.  Punt */
+		mutex_unlock(&au->au_lock);
 		return (false);
 	}
 	au->au_shfaults++;
@@ -344,6 +378,7 @@ authunix_refresh(AUTH *auth, void *dummy)
 	xdrs.x_op = XDR_FREE;
 	(void)xdr_authunix_parms(&xdrs, &aup);
 	XDR_DESTROY(&xdrs);
+	mutex_unlock(&au->au_lock);
 	return (stat);
 }
 
@@ -360,6 +395,7 @@ authunix_destroy(AUTH *auth)
 	if (au->au_shcred.oa_base != NULL)
 		mem_free(au->au_shcred.oa_base, au->au_shcred.oa_length);
 
+	mutex_destroy(&au->au_lock);
 	mem_free(auth->ah_private, sizeof(struct audata));
 
 	if (auth->ah_verf.oa_base != NULL)
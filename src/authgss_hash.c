@@ -38,6 +38,7 @@
 #include <rpc/svc.h>
 #include <rpc/svc_auth.h>
 #include <rpc/gss_internal.h>
+#include <rpc/lock_stat.h>
 #include "svc_internal.h"
 
 /* GSS context cache */
@@ -162,7 +163,7 @@ authgss_ctx_hash_get(struct rpc_gss_cred *gc)
 	gk.hk.k = gss_ctx_hash(gss_ctx);
 
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gk.hk.k);
-	mutex_lock(&t->mtx);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
 	ngd =
 	    rbtree_x_cached_lookup(&authgss_hash_st.xt, t, &gk.node_k, gk.hk.k);
 	if (ngd) {
@@ -176,6 +177,7 @@ authgss_ctx_hash_get(struct rpc_gss_cred *gc)
 		(void)atomic_inc_uint32_t(&gd->gen);
 	}
 	mutex_unlock(&t->mtx);
+	svc_stats_add(gd ? SVC_STAT_GSS_HITS : SVC_STAT_GSS_MISSES, 1);
 
 	return (gd);
 }
@@ -195,7 +197,7 @@ authgss_ctx_hash_set(struct svc_rpc_gss_data *gd)
 
 	++(gd->refcnt);		/* locked */
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gd->hk.k);
-	mutex_lock(&t->mtx);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
 	rslt =
 	    rbtree_x_cached_insert(&authgss_hash_st.xt, t, &gd->node_k,
 				   gd->hk.k);
@@ -219,7 +221,7 @@ authgss_ctx_hash_del(struct svc_rpc_gss_data *gd)
 	cond_init_authgss_hash();
 
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gd->hk.k);
-	mutex_lock(&t->mtx);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
 	rbtree_x_cached_remove(&authgss_hash_st.xt, t, &gd->node_k, gd->hk.k);
 	axp = (struct authgss_x_part *)t->u1;
 	TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
@@ -263,7 +265,7 @@ void authgss_ctx_gc_idle(void)
 		xp = &(authgss_hash_st.xt.tree[part]);
 		axp = (struct authgss_x_part *)xp->u1;
 		cnt = 0;
-		mutex_lock(&xp->mtx);
+		TIRPC_MUTEX_LOCK(&xp->mtx, TIRPC_LOCK_RBTX);
  again:
 		gd = TAILQ_FIRST(&axp->lru_q);
 		if (!gd)
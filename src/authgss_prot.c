@@ -146,7 +146,7 @@ xdr_rpc_gss_wrap_data(XDR *xdrs, xdrproc_t xdr_func, caddr_t xdr_ptr,
 	OM_uint32 maj_stat, min_stat;
 	int start, end, conf_state;
 	bool xdr_stat;
-	u_int databuflen, maxwrapsz;
+	u_int databuflen, maxwrapsz, x_flags;
 
 	/* Write dummy for databody length. */
 	start = XDR_GETPOS(xdrs);
@@ -157,8 +157,15 @@ xdr_rpc_gss_wrap_data(XDR *xdrs, xdrproc_t xdr_func, caddr_t xdr_ptr,
 	memset(&databuf, 0, sizeof(databuf));
 	memset(&wrapbuf, 0, sizeof(wrapbuf));
 
-	/* Marshal rpc_gss_data_t (sequence number + arguments). */
-	if (!inline_xdr_u_int(xdrs, &seq) || !(*xdr_func) (xdrs, xdr_ptr))
+	/* Marshal rpc_gss_data_t (sequence number + arguments).
+	 * It is wrapped in place, so XDR_PUTBUFS must copy. */
+	if (!inline_xdr_u_int(xdrs, &seq))
+		return (FALSE);
+	x_flags = xdrs->x_flags;
+	xdrs->x_flags |= XDR_FLAG_NOSPLICE;
+	xdr_stat = (*xdr_func) (xdrs, xdr_ptr);
+	xdrs->x_flags = x_flags;
+	if (!xdr_stat)
 		return (FALSE);
 	end = XDR_GETPOS(xdrs);
 
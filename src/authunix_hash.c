@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <rpc/rpc.h>
+#include <rpc/types.h>
+#include "rpc_com.h"
+#include <intrinsic.h>
+#include <misc/abstract_atomic.h>
+#include <misc/rbtree_x.h>
+#include <misc/city.h>
+#include <rpc/svc.h>
+#include <rpc/svc_auth.h>
+#include <rpc/lock_stat.h>
+#include "svc_internal.h"
+#include "authunix_internal.h"
+
+/* AUTH_SYS credential cache */
+
+struct authunix_x_part {
+	uint32_t gen;
+	uint32_t size;
+	 TAILQ_HEAD(unix_cred_tailq, svc_rpc_unix_cred) lru_q;
+};
+
+struct authunix_hash_st {
+	mutex_t lock;
+	struct rbtree_x xt;
+	uint32_t max_part;
+	bool initialized;
+};
+
+static struct authunix_hash_st authunix_hash_st = {
+	MUTEX_INITIALIZER,	/* lock */
+	{
+	 0,			/* npart */
+	 RBT_X_FLAG_NONE,	/* flags */
+	 255,			/* cachesz */
+	 NULL			/* tree */
+	 },			/* xt */
+	0,			/* max_part */
+	false			/* initialized */
+};
+
+static int
+svc_rpc_unix_cmpf(const struct opr_rbtree_node *lhs,
+		  const struct opr_rbtree_node *rhs)
+{
+	struct svc_rpc_unix_cred *lk, *rk;
+	int rc;
+
+	lk = opr_containerof(lhs, struct svc_rpc_unix_cred, node_k);
+	rk = opr_containerof(rhs, struct svc_rpc_unix_cred, node_k);
+
+	if (lk->hk < rk->hk)
+		return (-1);
+	if (lk->hk > rk->hk)
+		return (1);
+
+	/* hash collision is possible, the raw bytes are the key */
+	if (lk->cred_len < rk->cred_len)
+		return (-1);
+	if (lk->cred_len > rk->cred_len)
+		return (1);
+
+	rc = memcmp(lk->cred_body, rk->cred_body, lk->cred_len);
+	if (rc < 0)
+		return (-1);
+	if (rc > 0)
+		return (1);
+	return (0);
+}
+
+static void
+authunix_hash_init(void)
+{
+	int ix, code = 0;
+
+	mutex_lock(&authunix_hash_st.lock);
+
+	/* once */
+	if (authunix_hash_st.initialized)
+		goto unlock;
+
+	code =
+	    rbtx_init(&authunix_hash_st.xt, svc_rpc_unix_cmpf,
+		      __svc_params->authunix.hash_partitions,
+		      RBT_X_FLAG_ALLOC | RBT_X_FLAG_CACHE_RT);
+	if (code)
+		__warnx(TIRPC_DEBUG_FLAG_AUTH, "%s: rbtx_init failed",
+			__func__);
+
+	/* init read-through cache */
+	for (ix = 0; ix < authunix_hash_st.xt.npart; ++ix) {
+		struct rbtree_x_part *xp = &(authunix_hash_st.xt.tree[ix]);
+		struct authunix_x_part *axp;
+
+		xp->cache =
+		    mem_zalloc(authunix_hash_st.xt.cachesz *
+			       sizeof(struct opr_rbtree_node *));
+		if (unlikely(!xp->cache)) {
+			__warnx(TIRPC_DEBUG_FLAG_AUTH,
+				"%s: rbtx cache partition alloc failed",
+				__func__);
+			authunix_hash_st.xt.cachesz = 0;
+			break;
+		}
+		/* partition cred LRU */
+		axp = (struct authunix_x_part *)
+		    mem_zalloc(sizeof(struct authunix_x_part));
+		TAILQ_INIT(&axp->lru_q);
+		xp->u1 = axp;
+	}
+
+	authunix_hash_st.max_part =
+	    __svc_params->authunix.max_cred / authunix_hash_st.xt.npart;
+	if (!authunix_hash_st.max_part)
+		authunix_hash_st.max_part = 1;
+	authunix_hash_st.initialized = true;
+
+ unlock:
+	mutex_unlock(&authunix_hash_st.lock);
+}
+
+#define cond_init_authunix_hash() { \
+		do { \
+			if (!authunix_hash_st.initialized) \
+				authunix_hash_init(); \
+		} while (0); \
+	}
+
+static inline void
+authunix_cred_free(struct svc_rpc_unix_cred *uc)
+{
+	if (uc->priv && uc->priv_free)
+		uc->priv_free(uc->priv);
+	mem_free(uc, sizeof(struct svc_rpc_unix_cred) + uc->cred_len);
+}
+
+void
+authunix_cred_unref(struct svc_rpc_unix_cred *uc)
+{
+	if (atomic_dec_uint32_t(&uc->refcnt) == 0)
+		authunix_cred_free(uc);
+}
+
+/* Returns a referenced credential matching the raw bytes, decoding and
+ * interning them on a miss.  NULL when the credential is malformed. */
+struct svc_rpc_unix_cred *
+authunix_cred_hash_get(caddr_t oa_base, u_int oa_length)
+{
+	struct svc_rpc_unix_cred uk, *uc, *victim;
+	struct opr_rbtree_node *nuc;
+	struct authunix_x_part *axp;
+	struct rbtree_x_part *t;
+
+	cond_init_authunix_hash();
+
+	uk.hk = CityHash64(oa_base, oa_length);
+	uk.cred_len = oa_length;
+	uk.cred_body = oa_base;
+
+	t = rbtx_partition_of_scalar(&authunix_hash_st.xt, uk.hk);
+	axp = (struct authunix_x_part *)t->u1;
+
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+	nuc =
+	    rbtree_x_cached_lookup(&authunix_hash_st.xt, t, &uk.node_k, uk.hk);
+	if (nuc) {
+		uc = opr_containerof(nuc, struct svc_rpc_unix_cred, node_k);
+		/* lru adjust */
+		TAILQ_REMOVE(&axp->lru_q, uc, lru_q);
+		TAILQ_INSERT_TAIL(&axp->lru_q, uc, lru_q);
+		uc->gen = ++(axp->gen);
+		(void)atomic_inc_uint32_t(&uc->refcnt);
+		mutex_unlock(&t->mtx);
+		return (uc);
+	}
+	mutex_unlock(&t->mtx);
+
+	/* miss, decode outside the partition lock */
+	uc = mem_zalloc(sizeof(struct svc_rpc_unix_cred) + oa_length);
+	if (unlikely(!uc))
+		return (NULL);
+	uc->cred_body = (caddr_t) (uc + 1);
+	uc->cred_len = oa_length;
+	memcpy(uc->cred_body, oa_base, oa_length);
+	uc->hk = uk.hk;
+	uc->aup.aup_machname = uc->machname;
+	uc->aup.aup_gids = uc->gids;
+	if (svcauth_unix_decode(&uc->aup, uc->cred_body, oa_length)
+	    != AUTH_OK) {
+		mem_free(uc, sizeof(struct svc_rpc_unix_cred) + oa_length);
+		return (NULL);
+	}
+	uc->refcnt = 2;		/* sentinel + call path */
+
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+	nuc =
+	    rbtree_x_cached_lookup(&authunix_hash_st.xt, t, &uk.node_k, uk.hk);
+	if (unlikely(nuc)) {
+		/* raced with another decoder, use the winner */
+		mem_free(uc, sizeof(struct svc_rpc_unix_cred) + oa_length);
+		uc = opr_containerof(nuc, struct svc_rpc_unix_cred, node_k);
+		(void)atomic_inc_uint32_t(&uc->refcnt);
+		mutex_unlock(&t->mtx);
+		return (uc);
+	}
+	(void)rbtree_x_cached_insert(&authunix_hash_st.xt, t, &uc->node_k,
+				     uc->hk);
+	TAILQ_INSERT_TAIL(&axp->lru_q, uc, lru_q);
+	uc->gen = ++(axp->gen);
+	++(axp->size);
+
+	/* bound the partition, oldest first */
+	while (axp->size > authunix_hash_st.max_part) {
+		victim = TAILQ_FIRST(&axp->lru_q);
+		rbtree_x_cached_remove(&authunix_hash_st.xt, t,
+				       &victim->node_k, victim->hk);
+		TAILQ_REMOVE(&axp->lru_q, victim, lru_q);
+		--(axp->size);
+
+		/* drop sentinel ref (may free victim) */
+		authunix_cred_unref(victim);
+	}
+	mutex_unlock(&t->mtx);
+
+	return (uc);
+}
+
+void
+authunix_cred_set_private(struct svc_rpc_unix_cred *uc, void *priv,
+			  void (*priv_free) (void *), bool *set)
+{
+	struct rbtree_x_part *t;
+
+	t = rbtx_partition_of_scalar(&authunix_hash_st.xt, uc->hk);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+	*set = (uc->priv == NULL);
+	if (*set) {
+		uc->priv_free = priv_free;
+		uc->priv = priv;
+	}
+	mutex_unlock(&t->mtx);
+}
+
+/* AUTH_SHORT handle table
+ *
+ * Handles are issued (as AUTH_SHORT response verifiers) for interned
+ * credentials, each holding a reference on its credential until it
+ * expires or is evicted.  Expiry is fixed at issue, so each partition
+ * LRU is also in expiry order.
+ */
+
+struct svc_rpc_unix_short {
+	struct opr_rbtree_node node_k;
+	 TAILQ_ENTRY(svc_rpc_unix_short) lru_q;
+	uint64_t handle;
+	time_t expires;
+	struct svc_rpc_unix_cred *uc;
+};
+
+struct authunix_short_x_part {
+	uint32_t size;
+	 TAILQ_HEAD(unix_short_tailq, svc_rpc_unix_short) lru_q;
+};
+
+struct authunix_short_st {
+	mutex_t lock;
+	struct rbtree_x xt;
+	uint32_t max_part;
+	uint64_t seed;
+	uint64_t next;
+	bool initialized;
+};
+
+static struct authunix_short_st authunix_short_st = {
+	MUTEX_INITIALIZER,	/* lock */
+	{
+	 0,			/* npart */
+	 RBT_X_FLAG_NONE,	/* flags */
+	 255,			/* cachesz */
+	 NULL			/* tree */
+	 },			/* xt */
+	0,			/* max_part */
+	0,			/* seed */
+	0,			/* next */
+	false			/* initialized */
+};
+
+static int
+svc_rpc_unix_short_cmpf(const struct opr_rbtree_node *lhs,
+			const struct opr_rbtree_node *rhs)
+{
+	struct svc_rpc_unix_short *lk, *rk;
+
+	lk = opr_containerof(lhs, struct svc_rpc_unix_short, node_k);
+	rk = opr_containerof(rhs, struct svc_rpc_unix_short, node_k);
+
+	if (lk->handle < rk->handle)
+		return (-1);
+
+	if (lk->handle == rk->handle)
+		return (0);
+
+	return (1);
+}
+
+static void
+authunix_short_init(void)
+{
+	struct timespec now;
+	int ix, code = 0;
+
+	mutex_lock(&authunix_short_st.lock);
+
+	/* once */
+	if (authunix_short_st.initialized)
+		goto unlock;
+
+	code =
+	    rbtx_init(&authunix_short_st.xt, svc_rpc_unix_short_cmpf,
+		      __svc_params->authunix.hash_partitions,
+		      RBT_X_FLAG_ALLOC | RBT_X_FLAG_CACHE_RT);
+	if (code)
+		__warnx(TIRPC_DEBUG_FLAG_AUTH, "%s: rbtx_init failed",
+			__func__);
+
+	for (ix = 0; ix < authunix_short_st.xt.npart; ++ix) {
+		struct rbtree_x_part *xp = &(authunix_short_st.xt.tree[ix]);
+		struct authunix_short_x_part *sxp;
+
+		xp->cache =
+		    mem_zalloc(authunix_short_st.xt.cachesz *
+			       sizeof(struct opr_rbtree_node *));
+		if (unlikely(!xp->cache)) {
+			__warnx(TIRPC_DEBUG_FLAG_AUTH,
+				"%s: rbtx cache partition alloc failed",
+				__func__);
+			authunix_short_st.xt.cachesz = 0;
+			break;
+		}
+		sxp = (struct authunix_short_x_part *)
+		    mem_zalloc(sizeof(struct authunix_short_x_part));
+		TAILQ_INIT(&sxp->lru_q);
+		xp->u1 = sxp;
+	}
+
+	authunix_short_st.max_part =
+	    __svc_params->authunix.short_max / authunix_short_st.xt.npart;
+	if (!authunix_short_st.max_part)
+		authunix_short_st.max_part = 1;
+
+	/* handles should not repeat across server instances */
+	(void)clock_gettime(CLOCK_REALTIME, &now);
+	authunix_short_st.seed =
+	    ((uint64_t) now.tv_sec << 32) ^ now.tv_nsec ^ getpid();
+	authunix_short_st.initialized = true;
+
+ unlock:
+	mutex_unlock(&authunix_short_st.lock);
+}
+
+#define cond_init_authunix_short() { \
+		do { \
+			if (!authunix_short_st.initialized) \
+				authunix_short_init(); \
+		} while (0); \
+	}
+
+static inline time_t
+authunix_short_now(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	return (now.tv_sec);
+}
+
+/* partition locked */
+static inline void
+authunix_short_remove(struct rbtree_x_part *t,
+		      struct authunix_short_x_part *sxp,
+		      struct svc_rpc_unix_short *us)
+{
+	rbtree_x_cached_remove(&authunix_short_st.xt, t, &us->node_k,
+			       us->handle);
+	TAILQ_REMOVE(&sxp->lru_q, us, lru_q);
+	--(sxp->size);
+	authunix_cred_unref(us->uc);
+	mem_free(us, sizeof(struct svc_rpc_unix_short));
+}
+
+static struct svc_rpc_unix_short *
+authunix_short_lookup(struct rbtree_x_part *t, uint64_t handle)
+{
+	struct svc_rpc_unix_short sk;
+	struct opr_rbtree_node *nus;
+
+	sk.handle = handle;
+	nus =
+	    rbtree_x_cached_lookup(&authunix_short_st.xt, t, &sk.node_k,
+				   handle);
+	if (!nus)
+		return (NULL);
+	return (opr_containerof(nus, struct svc_rpc_unix_short, node_k));
+}
+
+/* Returns a (possibly existing) live short handle for uc. */
+bool
+authunix_short_issue(struct svc_rpc_unix_cred *uc, uint64_t *handle)
+{
+	struct authunix_short_x_part *sxp;
+	struct svc_rpc_unix_short *us;
+	struct rbtree_x_part *t;
+	uint64_t h, ctr;
+	time_t now;
+
+	cond_init_authunix_short();
+	now = authunix_short_now();
+
+	h = atomic_fetch_uint64_t(&uc->sh_handle);
+	if (h) {
+		t = rbtx_partition_of_scalar(&authunix_short_st.xt, h);
+		TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+		us = authunix_short_lookup(t, h);
+		if (us && us->uc == uc && us->expires > now) {
+			mutex_unlock(&t->mtx);
+			*handle = h;
+			return (true);
+		}
+		mutex_unlock(&t->mtx);
+	}
+
+	us = mem_alloc(sizeof(struct svc_rpc_unix_short));
+	if (unlikely(!us))
+		return (false);
+	(void)atomic_inc_uint32_t(&uc->refcnt);
+	us->uc = uc;
+	us->expires = now + __svc_params->authunix.short_ttl;
+
+ retry:
+	ctr = atomic_inc_uint64_t(&authunix_short_st.next);
+	h = CityHash64WithSeed((const char *)&ctr, sizeof(ctr),
+			       authunix_short_st.seed);
+	if (unlikely(!h))
+		goto retry;
+	us->handle = h;
+
+	t = rbtx_partition_of_scalar(&authunix_short_st.xt, h);
+	sxp = (struct authunix_short_x_part *)t->u1;
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+	if (unlikely(authunix_short_lookup(t, h) != NULL)) {
+		mutex_unlock(&t->mtx);
+		goto retry;
+	}
+	(void)rbtree_x_cached_insert(&authunix_short_st.xt, t, &us->node_k,
+				     h);
+	TAILQ_INSERT_TAIL(&sxp->lru_q, us, lru_q);
+	++(sxp->size);
+
+	/* bound the partition, and reap expired handles */
+	while ((us = TAILQ_FIRST(&sxp->lru_q)) != NULL) {
+		if (sxp->size <= authunix_short_st.max_part
+		    && us->expires > now)
+			break;
+		authunix_short_remove(t, sxp, us);
+	}
+	mutex_unlock(&t->mtx);
+
+	atomic_store_uint64_t(&uc->sh_handle, h);
+	*handle = h;
+	return (true);
+}
+
+/* Returns the referenced credential for a live handle, else NULL. */
+struct svc_rpc_unix_cred *
+authunix_short_get(uint64_t handle)
+{
+	struct authunix_short_x_part *sxp;
+	struct svc_rpc_unix_cred *uc = NULL;
+	struct svc_rpc_unix_short *us;
+	struct rbtree_x_part *t;
+
+	cond_init_authunix_short();
+
+	t = rbtx_partition_of_scalar(&authunix_short_st.xt, handle);
+	sxp = (struct authunix_short_x_part *)t->u1;
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
+	us = authunix_short_lookup(t, handle);
+	if (us) {
+		if (us->expires > authunix_short_now()) {
+			uc = us->uc;
+			(void)atomic_inc_uint32_t(&uc->refcnt);
+		} else
+			authunix_short_remove(t, sxp, us);
+	}
+	mutex_unlock(&t->mtx);
+
+	return (uc);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef AUTHUNIX_INTERNAL_H
+#define AUTHUNIX_INTERNAL_H
+
+#include <rpc/types.h>
+#include <rpc/auth.h>
+#include <rpc/auth_unix.h>
+#include <misc/rbtree.h>
+#include <misc/queue.h>
+#include <misc/abstract_atomic.h>
+
+/*
+ * An interned AUTH_SYS credential.
+ *
+ * Keyed by the raw credential body as received on the wire, so that
+ * identical credentials are decoded once and shared (read only) by
+ * every request that presents them.  The cache holds one (sentinel)
+ * reference; each request holds another until SVCAUTH_RELEASE.
+ */
+struct svc_rpc_unix_cred {
+	struct opr_rbtree_node node_k;
+	 TAILQ_ENTRY(svc_rpc_unix_cred) lru_q;
+	uint64_t hk;		/* CityHash64 of cred_body */
+	uint32_t refcnt;
+	uint32_t gen;
+
+	/* last AUTH_SHORT handle issued, if any */
+	uint64_t sh_handle;
+
+	/* application data, set once (e.g., mapped identity) */
+	void *priv;
+	void (*priv_free) (void *);
+
+	/* cooked form--immutable once interned */
+	struct authunix_parms aup;
+	char machname[MAX_MACHINE_NAME + 1];
+	gid_t gids[NGRPS];
+
+	/* raw form (key), allocated inline after the struct */
+	u_int cred_len;
+	caddr_t cred_body;
+};
+
+enum auth_stat svcauth_unix_decode(struct authunix_parms *aup,
+				   caddr_t oa_base, u_int oa_length);
+
+struct svc_rpc_unix_cred *authunix_cred_hash_get(caddr_t oa_base,
+						  u_int oa_length);
+void authunix_cred_unref(struct svc_rpc_unix_cred *uc);
+void authunix_cred_set_private(struct svc_rpc_unix_cred *uc, void *priv,
+			       void (*priv_free) (void *), bool *set);
+
+bool authunix_short_issue(struct svc_rpc_unix_cred *uc, uint64_t *handle);
+struct svc_rpc_unix_cred *authunix_short_get(uint64_t handle);
+
+#endif				/* AUTHUNIX_INTERNAL_H */
@@ -284,17 +284,19 @@ clnt_tp_ncreate_timed(const char *hostname, rpcprog_t prog,
 	 * Get the address of the server
 	 */
 	svcaddr =
-		__rpcb_findaddr_timed(prog, vers, (struct netconfig *)nconf,
-				      (char *)hostname, &cl,
-				      (struct timeval *)tp);
+		__rpcb_findaddr_cached(prog, vers, (struct netconfig *)nconf,
+				       (char *)hostname, &cl,
+				       (struct timeval *)tp);
 	if (svcaddr == NULL) {
 		/* appropriate error number is set by rpcbind libraries */
 		return (NULL);
 	}
 	if (cl == NULL) {
-		/* __rpc_findaddr_timed failed? */
+		/* __rpcb_findaddr_cached failed, or the address was cached */
 		cl = clnt_tli_ncreate(RPC_ANYFD, nconf, svcaddr, prog, vers, 0,
 				      0);
+		if (cl == NULL)
+			__rpcb_cache_invalidate(prog, vers, nconf, hostname);
 	} else {
 		/* Reuse the CLIENT handle and change the appropriate fields */
 		if (CLNT_CONTROL(cl, CLSET_SVC_ADDR, (void *)svcaddr) == true) {
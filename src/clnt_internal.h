@@ -47,6 +47,7 @@ struct ct_wait_entry
 #include <rpc/work_pool.h>
 #include <rpc/xdr_ioq.h>
 #include <misc/wait_queue.h>
+#include <rpc/lock_stat.h>
 
 typedef struct rpc_dplx_lock {
 	struct wait_entry we;
@@ -195,7 +196,8 @@ struct rpc_dplx_rec {
 
 #define REC_LOCK(rec) \
 	do { \
-		mutex_lock(&((rec)->locktrace.mtx)); \
+		TIRPC_MUTEX_LOCK(&((rec)->locktrace.mtx), \
+				 TIRPC_LOCK_DPLX_REC); \
 		(rec)->locktrace.func = __func__; \
 		(rec)->locktrace.line = __LINE__; \
 	} while (0)
@@ -236,6 +238,13 @@ struct x_vc_data {
 		struct poolq_head ioq;
 		bool active;
 		bool nonblock;
+		bool zerocopy;	/* SO_ZEROCOPY enabled */
+		bool zccopied;	/* but the kernel copied anyway */
+		bool throttled;	/* over an ioq backlog watermark */
+		bool rearm_deferred;	/* while throttled */
+		uint64_t ioq_bytes;	/* with SVC_FLAG_IOQ_BACKLOG */
+		uint32_t zcseq;	/* next MSG_ZEROCOPY send */
+		struct poolq_head zcq;	/* sends awaiting completion */
 		u_int sendsz;
 		u_int recvsz;
 		XDR xdrs_in;	/* send queue */
@@ -253,6 +262,7 @@ alloc_x_vc_data(void)
 {
 	struct x_vc_data *xd = mem_zalloc(sizeof(struct x_vc_data));
 	TAILQ_INIT(&xd->shared.ioq.qh);
+	TAILQ_INIT(&xd->shared.zcq.qh);
 	return (xd);
 }
 
@@ -1,7 +1,10 @@
 NTIRPC_${NTIRPC_VERSION} {
   global:
     # __*
+    __ntirpc_lock_stat;
     __ntirpc_pkg_params;
+    __ntirpc_span_rate;
+    __ntirpc_trace_mask;
     __rpc_createerr;
     __rpc_dtbsize;
     __rpc_endconf;
@@ -151,11 +154,21 @@ NTIRPC_${NTIRPC_VERSION} {
     svc_exit;
     svc_fd_ncreate;
     svc_fd_ncreate2;
+    svc_hist_bucket_usec;
+    svc_hist_percentile;
+    svc_hist_proc_get;
+    svc_hist_xprt_get;
     svc_init;
+    svc_mem_add;
+    svc_mem_get;
+    svc_mem_name;
     svc_ncreate;
+    svc_proc_dispatch;
+    svc_proc_stats_get;
     svc_raw_ncreate;
     svc_rdma_ncreate;
     svc_reg;
+    svc_reg_procs;
     svc_register;
     svc_rqst_new_evchan;
     svc_rqst_evchan_reg;
@@ -167,6 +180,11 @@ NTIRPC_${NTIRPC_VERSION} {
     svc_run_epoll;
     svc_sendreply;
     svc_shutdown;
+    svc_slow_stage;
+    svc_stats_add;
+    svc_stats_get;
+    svc_stats_listen;
+    svc_stats_name;
     svc_tli_ncreate;
     svc_tp_ncreate;
     svc_unreg;
@@ -182,6 +200,8 @@ NTIRPC_${NTIRPC_VERSION} {
     svcauth_gss_nextverf;
     svcauth_gss_release_cred;
     svcauth_gss_set_svc_name;
+    svcauth_unix_get_private;
+    svcauth_unix_set_private;
     svcerr_auth;
     svcerr_decode;
     svcerr_noproc;
@@ -200,15 +220,37 @@ NTIRPC_${NTIRPC_VERSION} {
     # t*
     taddr2uaddr;
     tirpc_control;
+    tirpc_lock_class_name;
+    tirpc_lock_stat_disable;
+    tirpc_lock_stat_dump;
+    tirpc_lock_stat_enable;
+    tirpc_lock_stat_mutex;
+    tirpc_lock_stat_rdlock;
+    tirpc_lock_stat_read;
+    tirpc_lock_stat_reset;
+    tirpc_lock_stat_wrlock;
+    tirpc_span_disable;
+    tirpc_span_emit;
+    tirpc_span_enable;
+    tirpc_span_export;
+    tirpc_span_now;
+    tirpc_span_read;
+    tirpc_trace_disable;
+    tirpc_trace_emit;
+    tirpc_trace_enable;
+    tirpc_trace_read;
 
     # u*
     uaddr2taddr;
 
     # x*
     xdr_array;
+    xdr_array_u32;
+    xdr_array_u64;
     xdr_authunix_parms;
     xdr_bool;
     xdr_bytes;
+    xdr_bytes_uio;
     xdr_call_decode;
     xdr_call_encode;
     xdr_char;
@@ -217,7 +259,9 @@ NTIRPC_${NTIRPC_VERSION} {
     xdr_dplx_msg;
     xdr_enum;
     xdr_float;
+    xdr_free_null_stream;
     xdr_hyper;
+    xdr_inrec_buffered;
     xdr_inrec_cksum;
     xdr_inrec_create;
     xdr_inrec_eof;
@@ -228,6 +272,7 @@ NTIRPC_${NTIRPC_VERSION} {
     xdr_int16_t;
     xdr_int32_t;
     xdr_int64_t;
+    xdr_ioq_create;
     xdr_long;
     xdr_longlong_t;
     xdr_naccepted_reply;
@@ -239,10 +284,13 @@ NTIRPC_${NTIRPC_VERSION} {
     xdr_nreplymsg;
     xdr_opaque;
     xdr_opaque_auth;
+    xdr_opaque_uio;
     xdr_pmap;
     xdr_pmaplist;
     xdr_pmaplist_ptr;
     xdr_pointer;
+    xdr_putbufs_copy;
+    xdr_putbufs_release;
     xdr_quad_t;
     xdr_reference;
     xdr_rmtcall_args;
@@ -269,6 +317,7 @@ NTIRPC_${NTIRPC_VERSION} {
     xdr_rpcbs_rmtcalllist;
     xdr_rpcbs_rmtcalllist_ptr;
     xdr_short;
+    xdr_sizeof;
     xdr_string;
     xdr_u_char;
     xdr_u_hyper;
@@ -287,6 +336,8 @@ NTIRPC_${NTIRPC_VERSION} {
     xdr_uint64_t;
     xdr_union;
     xdr_vector;
+    xdr_vector_u32;
+    xdr_vector_u64;
     xdr_void;
     xdr_wrapstring;
     xdrmem_ncreate;
@@ -294,6 +345,7 @@ NTIRPC_${NTIRPC_VERSION} {
     xdrrec_endofrecord;
     xdrrec_eof;
     xdrrec_skiprecord;
+    xdrsize_create;
     xdrstdio_create;
     xprt_register;
     xprt_unregister;
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * lock_stat.c
+ * Lock contention accounting by call site.
+ *
+ * Call sites live in an open addressed table keyed by function name
+ * pointer, line and lock class.  Lookups are lock-free: a slot is
+ * filled under lock_stat_mtx and published by storing its func last,
+ * and slots are never removed.  Sites beyond the table are summed into
+ * one "(other)" site.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <misc/abstract_atomic.h>
+#include <rpc/lock_stat.h>
+
+#include "rpc_ring.h"
+
+#define LOCK_STAT_SITES 1024	/* power of 2 */
+
+struct lock_stat_site {
+	const char *func;	/* published last */
+	int line;
+	u_int lclass;
+	uint64_t acquires;
+	uint64_t contended;
+	uint64_t wait_ns;
+	uint64_t hist[TIRPC_LOCK_STAT_BUCKETS];
+} __attribute__ ((aligned(64)));
+
+uint32_t __ntirpc_lock_stat;
+
+static mutex_t lock_stat_mtx = MUTEX_INITIALIZER;
+static struct lock_stat_site lock_stat_sites[LOCK_STAT_SITES];
+static struct lock_stat_site lock_stat_other = {
+	"(other)", 0, TIRPC_LOCK_CLASSES
+};
+
+static const char *lock_class_names[TIRPC_LOCK_CLASSES] = {
+	"dplx_send",
+	"dplx_recv",
+	"dplx_rec",
+	"xprt",
+	"evchan",
+	"pool",
+	"rbtx",
+};
+
+const char *
+tirpc_lock_class_name(u_int lclass)
+{
+	if (lclass >= TIRPC_LOCK_CLASSES)
+		return ("other");
+	return (lock_class_names[lclass]);
+}
+
+static inline u_int
+lock_stat_hash(const char *func, int line, u_int lclass)
+{
+	uint64_t h = ((uintptr_t)func ^ ((uint64_t)line << 3) ^ lclass)
+		     * 0x9e3779b97f4a7c15ULL;
+
+	return (h >> 32) & (LOCK_STAT_SITES - 1);
+}
+
+static struct lock_stat_site *
+lock_stat_insert(const char *func, int line, u_int lclass, u_int hash)
+{
+	struct lock_stat_site *site = &lock_stat_other;
+	struct lock_stat_site *s;
+	u_int ix;
+
+	mutex_lock(&lock_stat_mtx);
+	for (ix = 0; ix < LOCK_STAT_SITES; ++ix) {
+		s = &lock_stat_sites[(hash + ix) & (LOCK_STAT_SITES - 1)];
+		if (!s->func) {
+			s->line = line;
+			s->lclass = lclass;
+			atomic_store_voidptr((void **)&s->func, (void *)func);
+			site = s;
+			break;
+		}
+		if (s->func == func && s->line == line
+		    && s->lclass == lclass) {
+			site = s;
+			break;
+		}
+	}
+	mutex_unlock(&lock_stat_mtx);
+	return (site);
+}
+
+static inline struct lock_stat_site *
+lock_stat_site(const char *func, int line, u_int lclass)
+{
+	u_int hash = lock_stat_hash(func, line, lclass);
+	struct lock_stat_site *s;
+	const char *f;
+	u_int ix;
+
+	for (ix = 0; ix < LOCK_STAT_SITES; ++ix) {
+		s = &lock_stat_sites[(hash + ix) & (LOCK_STAT_SITES - 1)];
+		f = atomic_fetch_voidptr((void **)&s->func);
+		if (!f)
+			return (lock_stat_insert(func, line, lclass, hash));
+		if (f == func && s->line == line && s->lclass == lclass)
+			return (s);
+	}
+	return (&lock_stat_other);
+}
+
+static inline u_int
+lock_stat_bucket(uint64_t ns)
+{
+	u_int b;
+
+	if (ns < 256)
+		return (0);
+	b = 64 - __builtin_clzll(ns) - 8;
+	return (b < TIRPC_LOCK_STAT_BUCKETS ? b : TIRPC_LOCK_STAT_BUCKETS - 1);
+}
+
+static inline void
+lock_stat_contended(struct lock_stat_site *s, uint64_t start)
+{
+	uint64_t wait = rpc_now_ns() - start;
+
+	atomic_inc_uint64_t(&s->acquires);
+	atomic_inc_uint64_t(&s->contended);
+	atomic_add_uint64_t(&s->wait_ns, wait);
+	atomic_inc_uint64_t(&s->hist[lock_stat_bucket(wait)]);
+}
+
+void
+tirpc_lock_stat_mutex(pthread_mutex_t *mtx, u_int lclass, const char *func,
+		      int line)
+{
+	struct lock_stat_site *s = lock_stat_site(func, line, lclass);
+	uint64_t start;
+
+	if (!pthread_mutex_trylock(mtx)) {
+		atomic_inc_uint64_t(&s->acquires);
+		return;
+	}
+	start = rpc_now_ns();
+	pthread_mutex_lock(mtx);
+	lock_stat_contended(s, start);
+}
+
+void
+tirpc_lock_stat_rdlock(pthread_rwlock_t *rwl, u_int lclass, const char *func,
+		       int line)
+{
+	struct lock_stat_site *s = lock_stat_site(func, line, lclass);
+	uint64_t start;
+
+	if (!pthread_rwlock_tryrdlock(rwl)) {
+		atomic_inc_uint64_t(&s->acquires);
+		return;
+	}
+	start = rpc_now_ns();
+	pthread_rwlock_rdlock(rwl);
+	lock_stat_contended(s, start);
+}
+
+void
+tirpc_lock_stat_wrlock(pthread_rwlock_t *rwl, u_int lclass, const char *func,
+		       int line)
+{
+	struct lock_stat_site *s = lock_stat_site(func, line, lclass);
+	uint64_t start;
+
+	if (!pthread_rwlock_trywrlock(rwl)) {
+		atomic_inc_uint64_t(&s->acquires);
+		return;
+	}
+	start = rpc_now_ns();
+	pthread_rwlock_wrlock(rwl);
+	lock_stat_contended(s, start);
+}
+
+void
+tirpc_lock_stat_enable(void)
+{
+	atomic_store_uint32_t(&__ntirpc_lock_stat, 1);
+}
+
+void
+tirpc_lock_stat_disable(void)
+{
+	atomic_store_uint32_t(&__ntirpc_lock_stat, 0);
+}
+
+static void
+lock_stat_clear(struct lock_stat_site *s)
+{
+	u_int ix;
+
+	atomic_store_uint64_t(&s->acquires, 0);
+	atomic_store_uint64_t(&s->contended, 0);
+	atomic_store_uint64_t(&s->wait_ns, 0);
+	for (ix = 0; ix < TIRPC_LOCK_STAT_BUCKETS; ++ix)
+		atomic_store_uint64_t(&s->hist[ix], 0);
+}
+
+void
+tirpc_lock_stat_reset(void)
+{
+	u_int ix;
+
+	for (ix = 0; ix < LOCK_STAT_SITES; ++ix)
+		if (atomic_fetch_voidptr((void **)&lock_stat_sites[ix].func))
+			lock_stat_clear(&lock_stat_sites[ix]);
+	lock_stat_clear(&lock_stat_other);
+}
+
+static void
+lock_stat_copy(struct tirpc_lock_stat *dst, struct lock_stat_site *s)
+{
+	u_int ix;
+
+	dst->func = s->func;
+	dst->line = s->line;
+	dst->lclass = s->lclass;
+	dst->acquires = atomic_fetch_uint64_t(&s->acquires);
+	dst->contended = atomic_fetch_uint64_t(&s->contended);
+	dst->wait_ns = atomic_fetch_uint64_t(&s->wait_ns);
+	for (ix = 0; ix < TIRPC_LOCK_STAT_BUCKETS; ++ix)
+		dst->hist[ix] = atomic_fetch_uint64_t(&s->hist[ix]);
+}
+
+static int
+lock_stat_cmpf(const void *lhs, const void *rhs)
+{
+	const struct tirpc_lock_stat *l = lhs;
+	const struct tirpc_lock_stat *r = rhs;
+
+	if (l->wait_ns != r->wait_ns)
+		return (l->wait_ns < r->wait_ns) ? 1 : -1;
+	if (l->acquires != r->acquires)
+		return (l->acquires < r->acquires) ? 1 : -1;
+	return (0);
+}
+
+/* snapshot of every site with acquires, sorted; caller frees */
+static u_int
+lock_stat_snapshot(struct tirpc_lock_stat **out)
+{
+	struct tirpc_lock_stat *sites;
+	u_int n = 0;
+	u_int ix;
+
+	sites = mem_alloc((LOCK_STAT_SITES + 1) * sizeof(*sites));
+	if (!sites) {
+		*out = NULL;
+		return (0);
+	}
+	for (ix = 0; ix < LOCK_STAT_SITES; ++ix) {
+		if (!atomic_fetch_voidptr((void **)&lock_stat_sites[ix].func))
+			continue;
+		lock_stat_copy(&sites[n], &lock_stat_sites[ix]);
+		if (sites[n].acquires)
+			n++;
+	}
+	lock_stat_copy(&sites[n], &lock_stat_other);
+	if (sites[n].acquires)
+		n++;
+
+	qsort(sites, n, sizeof(*sites), lock_stat_cmpf);
+	*out = sites;
+	return (n);
+}
+
+u_int
+tirpc_lock_stat_read(struct tirpc_lock_stat *sites, u_int max)
+{
+	struct tirpc_lock_stat *all;
+	u_int n = lock_stat_snapshot(&all);
+
+	if (n > max)
+		n = max;
+	if (n)
+		memcpy(sites, all, n * sizeof(*sites));
+	if (all)
+		mem_free(all, (LOCK_STAT_SITES + 1) * sizeof(*all));
+	return (n);
+}
+
+/* upper bound of the bucket holding the pct'th contended wait */
+static uint64_t
+lock_stat_pct(const struct tirpc_lock_stat *site, u_int pct)
+{
+	uint64_t want = (site->contended * pct + 99) / 100;
+	uint64_t seen = 0;
+	u_int ix;
+
+	if (!site->contended)
+		return (0);
+	for (ix = 0; ix < TIRPC_LOCK_STAT_BUCKETS - 1; ++ix) {
+		seen += site->hist[ix];
+		if (seen >= want)
+			break;
+	}
+	return (256ULL << ix);
+}
+
+/*
+ * lock <class> <func>:<line> <acquires> <contended> <wait_ns> <p50_ns>
+ *	<p99_ns>
+ */
+void
+tirpc_lock_stat_dump(FILE *fp)
+{
+	struct tirpc_lock_stat *sites;
+	u_int n = lock_stat_snapshot(&sites);
+	u_int ix;
+
+	for (ix = 0; ix < n; ++ix)
+		fprintf(fp, "lock %s %s:%d %" PRIu64 " %" PRIu64 " %" PRIu64
+			" %" PRIu64 " %" PRIu64 "\n",
+			tirpc_lock_class_name(sites[ix].lclass),
+			sites[ix].func, sites[ix].line, sites[ix].acquires,
+			sites[ix].contended, sites[ix].wait_ns,
+			lock_stat_pct(&sites[ix], 50),
+			lock_stat_pct(&sites[ix], 99));
+	if (sites)
+		mem_free(sites, (LOCK_STAT_SITES + 1) * sizeof(*sites));
+}
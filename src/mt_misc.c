@@ -13,9 +13,6 @@
 /* protects the services list (svc.c) */
 pthread_rwlock_t svc_lock = RWLOCK_INITIALIZER;
 
-/* protects the RPCBIND address cache */
-pthread_rwlock_t rpcbaddr_cache_lock = RWLOCK_INITIALIZER;
-
 /* protects authdes cache (svcauth_des.c) */
 pthread_mutex_t authdes_lock = MUTEX_INITIALIZER;
 
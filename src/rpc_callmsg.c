@@ -183,30 +183,62 @@ xdr_call_encode(XDR *xdrs, struct rpc_msg *cmsg)
 	return (true);
 }
 
+/*
+ * copy an opaque_auth body out of a decode window
+ */
+static inline bool
+xdr_call_decode_auth(struct opaque_auth *oa, int32_t *buf)
+{
+	if (!oa->oa_length)
+		return (true);
+	if (oa->oa_base == NULL) {
+		oa->oa_base = (caddr_t)mem_alloc(oa->oa_length);
+		if (oa->oa_base == NULL) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s:%u ERROR mem_alloc(oa->oa_length)",
+				__func__, __LINE__);
+			return (false);
+		}
+	}
+	memcpy(oa->oa_base, buf, oa->oa_length);
+	return (true);
+}
+
 /*
  * decode a call message, log error messages
  *
- * param[IN]	buf	3 more inline
+ * The remainder of the header is taken in (at most) three windows,
+ * each contiguous either in the stream or by a single copy: through
+ * the credential length, the credential body through the verifier
+ * length, and the verifier body.  Lengths are checked before any body
+ * is read, so each window is parsed without further checks.
+ *
+ * param[IN]	buf	3 more inline (or staged)
  */
 bool
 xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
 {
-	if (buf != NULL) {
-		__warnx(TIRPC_DEBUG_FLAG_RPC_MSG,
-			"%s:%u INLINE",
-			__func__, __LINE__);
-		cmsg->rm_call.cb_rpcvers = IXDR_GET_U_INT32(buf);
-	} else {
+	int32_t stage[RNDUP(MAX_AUTH_BYTES) / BYTES_PER_XDR_UNIT + 6];
+	struct opaque_auth *cred = &cmsg->rm_call.cb_cred;
+	struct opaque_auth *verf = &cmsg->rm_call.cb_verf;
+	bool have_proc = false;
+	u_int len;
+
+	if (buf == NULL) {
 		__warnx(TIRPC_DEBUG_FLAG_RPC_MSG,
 			"%s:%u non-INLINE",
 			__func__, __LINE__);
-		if (!xdr_getuint32(xdrs, &cmsg->rm_call.cb_rpcvers)) {
+		buf = inline_xdr_getwindow(xdrs, 6 * BYTES_PER_XDR_UNIT,
+					   stage);
+		if (buf == NULL) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
-				"%s:%u ERROR rm_call.cb_rpcvers",
+				"%s:%u ERROR call header",
 				__func__, __LINE__);
 			return (false);
 		}
+		have_proc = true;
 	}
+	cmsg->rm_call.cb_rpcvers = IXDR_GET_U_INT32(buf);
 	if (cmsg->rm_call.cb_rpcvers != RPC_MSG_VERSION) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s:%u ERROR rm_call.cb_rpcvers %u != %u",
@@ -215,50 +247,66 @@ xdr_call_decode(XDR *xdrs, struct rpc_msg *cmsg, int32_t *buf)
 			RPC_MSG_VERSION);
 		return (false);
 	}
+	cmsg->rm_call.cb_prog = IXDR_GET_U_INT32(buf);
+	cmsg->rm_call.cb_vers = IXDR_GET_U_INT32(buf);
 
-	if (buf != NULL) {
-		cmsg->rm_call.cb_prog = IXDR_GET_U_INT32(buf);
-		cmsg->rm_call.cb_vers = IXDR_GET_U_INT32(buf);
-	} else if (!xdr_getuint32(xdrs, &(cmsg->rm_call.cb_prog))) {
-		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s:%u ERROR rm_call.cb_prog",
-			__func__, __LINE__);
-		return (false);
-	} else if (!xdr_getuint32(xdrs, &(cmsg->rm_call.cb_vers))) {
-		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s:%u ERROR rm_call.cb_vers",
-			__func__, __LINE__);
-		return (false);
-	}
-
-	buf = XDR_INLINE(xdrs, 3 * BYTES_PER_XDR_UNIT);
-	if (buf != NULL) {
-		cmsg->rm_call.cb_proc = IXDR_GET_U_INT32(buf);
-		if (!inline_auth_decode(xdrs, &(cmsg->rm_call.cb_cred), buf)) {
+	if (!have_proc) {
+		buf = inline_xdr_getwindow(xdrs, 3 * BYTES_PER_XDR_UNIT,
+					   stage);
+		if (buf == NULL) {
 			__warnx(TIRPC_DEBUG_FLAG_ERROR,
-				"%s:%u ERROR (return)",
+				"%s:%u ERROR rm_call.cb_proc",
 				__func__, __LINE__);
 			return (false);
 		}
-	} else if (!xdr_getuint32(xdrs, &(cmsg->rm_call.cb_proc))) {
+	}
+	cmsg->rm_call.cb_proc = IXDR_GET_U_INT32(buf);
+	cred->oa_flavor = IXDR_GET_ENUM(buf, enum_t);
+	cred->oa_length = (u_int) IXDR_GET_U_INT32(buf);
+	if (cred->oa_length > MAX_AUTH_BYTES) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s:%u ERROR rm_call.cb_proc",
-			__func__, __LINE__);
+			"%s:%u ERROR cb_cred.oa_length (%u) > %u",
+			__func__, __LINE__,
+			cred->oa_length,
+			MAX_AUTH_BYTES);
 		return (false);
-	} else if (!inline_auth_decode(xdrs, &(cmsg->rm_call.cb_cred), NULL)) {
+	}
+
+	/* credential body, verifier flavor and length */
+	len = RNDUP(cred->oa_length);
+	buf = inline_xdr_getwindow(xdrs, len + 2 * BYTES_PER_XDR_UNIT,
+				   stage);
+	if (buf == NULL) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s:%u ERROR (return)",
+			"%s:%u ERROR cb_cred",
 			__func__, __LINE__);
 		return (false);
 	}
+	if (!xdr_call_decode_auth(cred, buf))
+		return (false);
+	buf += len / BYTES_PER_XDR_UNIT;
+	verf->oa_flavor = IXDR_GET_ENUM(buf, enum_t);
+	verf->oa_length = (u_int) IXDR_GET_U_INT32(buf);
+	if (verf->oa_length > MAX_AUTH_BYTES) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s:%u ERROR cb_verf.oa_length (%u) > %u",
+			__func__, __LINE__,
+			verf->oa_length,
+			MAX_AUTH_BYTES);
+		return (false);
+	}
+	if (!verf->oa_length)
+		return (true);
 
-	if (!inline_auth_decode(xdrs, &(cmsg->rm_call.cb_verf), NULL)) {
+	/* verifier body */
+	buf = inline_xdr_getwindow(xdrs, RNDUP(verf->oa_length), stage);
+	if (buf == NULL) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
-			"%s:%u ERROR (return)",
+			"%s:%u ERROR cb_verf",
 			__func__, __LINE__);
 		return (false);
 	}
-	return (true);
+	return (xdr_call_decode_auth(verf, buf));
 }
 
 /*
@@ -79,9 +79,18 @@ struct netbuf *__rpcb_findaddr(rpcprog_t, rpcvers_t, const struct netconfig *,
 struct netbuf *__rpcb_findaddr_timed(rpcprog_t, rpcvers_t,
 				     const struct netconfig *, const char *,
 				     CLIENT **, struct timeval *);
+struct netbuf *__rpcb_findaddr_cached(rpcprog_t, rpcvers_t,
+				      const struct netconfig *, const char *,
+				      CLIENT **, struct timeval *);
+struct rpcb_cache_params;
+void __rpcb_cache_invalidate(rpcprog_t, rpcvers_t, const struct netconfig *,
+			     const char *);
+void __rpcb_cache_params(struct rpcb_cache_params *, bool);
 
 bool __rpc_control(int, void *);
 
+bool xdr_reply_encode_tmpl(XDR *, struct rpc_msg *, bool *);
+
 char *_get_next_token(char *, int);
 
 bool __svc_clean_idle(fd_set *, int, bool);
@@ -182,7 +182,7 @@ rpc_ctx_wait_reply(rpc_ctx_t *ctx, uint32_t flags)
 			opr_rbtree_remove(&xd->cx.calls.t, &ctx->node_k);
 			REC_UNLOCK(rec);
 
-			mutex_lock(&xprt->xp_lock);
+			TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 			xp_flags = xprt->xp_flags;
 			mutex_unlock(&xprt->xp_lock);
 
@@ -54,7 +54,7 @@ rpc_dplx_slxi(SVCXPRT *xprt, const char *func, int line)
 {
 	struct rpc_dplx_rec *rec = (struct rpc_dplx_rec *)xprt->xp_p5;
 	rpc_dplx_lock_t *lk = &rec->send.lock;
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_SEND, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -73,7 +73,7 @@ rpc_dplx_rlxi(SVCXPRT *xprt, const char *func, int line)
 {
 	struct rpc_dplx_rec *rec = (struct rpc_dplx_rec *)xprt->xp_p5;
 	rpc_dplx_lock_t *lk = &rec->recv.lock;
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_RECV, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -93,7 +93,7 @@ rpc_dplx_slci(CLIENT *clnt, const char *func, int line)
 	struct rpc_dplx_rec *rec = (struct rpc_dplx_rec *)clnt->cl_p2;
 	rpc_dplx_lock_t *lk = &rec->send.lock;
 
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_SEND, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -113,7 +113,7 @@ rpc_dplx_rlci(CLIENT *clnt, const char *func, int line)
 	struct rpc_dplx_rec *rec = (struct rpc_dplx_rec *)clnt->cl_p2;
 	rpc_dplx_lock_t *lk = &rec->recv.lock;
 
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_RECV, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -235,7 +235,7 @@ rpc_dplx_lookup_rec(int fd, uint32_t iflags, uint32_t *oflags)
 	rk.fd_k = fd;
 	t = rbtx_partition_of_scalar(&(rpc_dplx_rec_set.xt), fd);
 
-	rwlock_rdlock(&t->lock);
+	TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);
 	nv = opr_rbtree_lookup(&t->t, &rk.node_k);
 
 	/* XXX rework lock+insert case, so that new entries are inserted
@@ -243,7 +243,7 @@ rpc_dplx_lookup_rec(int fd, uint32_t iflags, uint32_t *oflags)
 
 	if (!nv) {
 		rwlock_unlock(&t->lock);
-		rwlock_wrlock(&t->lock);
+		TIRPC_WRLOCK(&t->lock, TIRPC_LOCK_RBTX);
 		nv = opr_rbtree_lookup(&t->t, &rk.node_k);
 		if (!nv) {
 			rec = alloc_dplx_rec();
@@ -296,7 +296,7 @@ rpc_dplx_slfi(int fd, const char *func, int line)
 	    rpc_dplx_lookup_rec(fd, RPC_DPLX_FLAG_NONE, &oflags);
 	rpc_dplx_lock_t *lk = &rec->send.lock;
 
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_SEND, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -322,7 +322,7 @@ rpc_dplx_rlfi(int fd, const char *func, int line)
 	    rpc_dplx_lookup_rec(fd, RPC_DPLX_FLAG_NONE, &oflags);
 	rpc_dplx_lock_t *lk = &rec->recv.lock;
 
-	mutex_lock(&lk->we.mtx);
+	TIRPC_MUTEX_LOCK_AT(&lk->we.mtx, TIRPC_LOCK_DPLX_RECV, func, line);
 	if (__ntirpc_pkg_params.debug_flags & TIRPC_DEBUG_FLAG_LOCK) {
 		lk->locktrace.func = (char *)func;
 		lk->locktrace.line = line;
@@ -357,7 +357,7 @@ rpc_dplx_unref(struct rpc_dplx_rec *rec, u_int flags)
 	if (rec->refcnt == 0) {
 		t = rbtx_partition_of_scalar(&rpc_dplx_rec_set.xt, rec->fd_k);
 		REC_UNLOCK(rec);
-		rwlock_wrlock(&t->lock);
+		TIRPC_WRLOCK(&t->lock, TIRPC_LOCK_RBTX);
 		nv = opr_rbtree_lookup(&t->t, &rec->node_k);
 		rec = NULL;
 		if (nv) {
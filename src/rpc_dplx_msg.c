@@ -48,6 +48,8 @@
 #include <rpc/xdr_inline.h>
 #include <rpc/auth_inline.h>
 
+#include "rpc_com.h"
+
 static const struct xdr_discrim reply_dscrm[3] = {
 	{(int)MSG_ACCEPTED, (xdrproc_t) xdr_naccepted_reply},
 	{(int)MSG_DENIED, (xdrproc_t) xdr_nrejected_reply},
@@ -59,6 +61,119 @@ static const struct xdr_discrim reply_dscrm[3] = {
  * so memcpy may be a small win over memmove.
  */
 
+/*
+ * Reply header templates, pre-serialized per verifier flavor and accept
+ * (or auth) status, for replies with an empty verifier.  Word 0 is left
+ * for the xid.  PROG_MISMATCH and RPC_MISMATCH replies copy their
+ * template and append the low and high versions after it.
+ */
+#define RPC_REPLY_TMPL_FLAVORS (AUTH_DH + 1)
+#define RPC_REPLY_TMPL_WHY (RPCSEC_GSS_CTXPROBLEM + 1)
+#define RPC_REPLY_TMPL_MAX 8	/* words, incl. low, high */
+
+static struct {
+	uint32_t accepted[RPC_REPLY_TMPL_FLAVORS][SYSTEM_ERR + 1][6];
+	uint32_t auth_error[RPC_REPLY_TMPL_WHY][5];
+	uint32_t rpc_mismatch[4];
+} rpc_reply_tmpl;
+
+static pthread_once_t rpc_reply_tmpl_once = PTHREAD_ONCE_INIT;
+
+static void
+rpc_reply_tmpl_init(void)
+{
+	uint32_t *t;
+	int flavor, stat;
+
+	for (flavor = 0; flavor < RPC_REPLY_TMPL_FLAVORS; ++flavor) {
+		for (stat = SUCCESS; stat <= SYSTEM_ERR; ++stat) {
+			t = rpc_reply_tmpl.accepted[flavor][stat];
+			t[1] = htonl(REPLY);
+			t[2] = htonl(MSG_ACCEPTED);
+			t[3] = htonl(flavor);
+			t[4] = 0;	/* oa_length */
+			t[5] = htonl(stat);
+		}
+	}
+	for (stat = 0; stat < RPC_REPLY_TMPL_WHY; ++stat) {
+		t = rpc_reply_tmpl.auth_error[stat];
+		t[1] = htonl(REPLY);
+		t[2] = htonl(MSG_DENIED);
+		t[3] = htonl(AUTH_ERROR);
+		t[4] = htonl(stat);
+	}
+	t = rpc_reply_tmpl.rpc_mismatch;
+	t[1] = htonl(REPLY);
+	t[2] = htonl(MSG_DENIED);
+	t[3] = htonl(RPC_MISMATCH);
+}
+
+/*
+ * encode a reply message header from its template, followed by any
+ * results.  Returns false when dmsg has no template, and nothing was
+ * encoded; otherwise *rslt holds the outcome.
+ */
+bool
+xdr_reply_encode_tmpl(XDR *xdrs, struct rpc_msg *dmsg, bool *rslt)
+{
+	uint32_t hdr[RPC_REPLY_TMPL_MAX];
+	struct accepted_reply *ar = NULL;
+	struct rejected_reply *rr;
+	u_int n;
+
+	if (unlikely(dmsg->rm_direction != REPLY))
+		return (false);
+
+	(void)pthread_once(&rpc_reply_tmpl_once, rpc_reply_tmpl_init);
+
+	switch (dmsg->rm_reply.rp_stat) {
+	case MSG_ACCEPTED:
+		ar = &dmsg->rm_reply.rp_acpt;
+		if (ar->ar_verf.oa_length
+		    || (u_int) ar->ar_verf.oa_flavor >= RPC_REPLY_TMPL_FLAVORS
+		    || (u_int) ar->ar_stat > SYSTEM_ERR)
+			return (false);
+		memcpy(hdr, rpc_reply_tmpl.accepted[ar->ar_verf.oa_flavor]
+					[ar->ar_stat], 6 * sizeof(uint32_t));
+		n = 6;
+		if (ar->ar_stat == PROG_MISMATCH) {
+			hdr[n++] = htonl(ar->ar_vers.low);
+			hdr[n++] = htonl(ar->ar_vers.high);
+		}
+		break;
+	case MSG_DENIED:
+		rr = &dmsg->rm_reply.rp_rjct;
+		if (rr->rj_stat == AUTH_ERROR
+		    && (u_int) rr->rj_why < RPC_REPLY_TMPL_WHY) {
+			memcpy(hdr, rpc_reply_tmpl.auth_error[rr->rj_why],
+			       5 * sizeof(uint32_t));
+			n = 5;
+		} else if (rr->rj_stat == RPC_MISMATCH) {
+			memcpy(hdr, rpc_reply_tmpl.rpc_mismatch,
+			       4 * sizeof(uint32_t));
+			n = 4;
+			hdr[n++] = htonl(rr->rj_vers.low);
+			hdr[n++] = htonl(rr->rj_vers.high);
+		} else
+			return (false);
+		break;
+	default:
+		return (false);
+	}
+	hdr[0] = htonl(dmsg->rm_xid);
+
+	if (!XDR_PUTBYTES(xdrs, (char *)hdr, n * BYTES_PER_XDR_UNIT)) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s:%u ERROR header (%u words)",
+			__func__, __LINE__, n);
+		*rslt = false;
+	} else if (ar && ar->ar_stat == SUCCESS)
+		*rslt = (*(ar->ar_results.proc))(xdrs, ar->ar_results.where);
+	else
+		*rslt = true;
+	return (true);
+}
+
 /*
  * encode a reply message, log error messages
  */
@@ -67,6 +182,10 @@ xdr_reply_encode(XDR *xdrs, struct rpc_msg *dmsg)
 {
 	struct opaque_auth *oa;
 	int32_t *buf;
+	bool rslt;
+
+	if (xdr_reply_encode_tmpl(xdrs, dmsg, &rslt))
+		return (rslt);
 
 	switch (dmsg->rm_reply.rp_stat) {
 	case MSG_ACCEPTED:
@@ -389,29 +508,22 @@ xdr_reply_decode(XDR *xdrs, struct rpc_msg *dmsg, int32_t *buf)
 bool
 xdr_dplx_decode(XDR *xdrs, struct rpc_msg *dmsg)
 {
+	int32_t stage[5];
 	int32_t *buf;
 
 	/*
-	 * NOTE: 5 here, 3 more in each _decode
+	 * NOTE: 5 here, 3 more in each _decode.  The shortest reply is 5
+	 * units, so no more may be taken before the direction is known.
 	 */
-	buf = XDR_INLINE(xdrs, 5 * BYTES_PER_XDR_UNIT);
-	if (buf != NULL) {
-		dmsg->rm_xid = IXDR_GET_U_INT32(buf);
-		dmsg->rm_direction = IXDR_GET_ENUM(buf, enum msg_type);
-	} else {
-		if (!xdr_getuint32(xdrs, &(dmsg->rm_xid))) {
-			__warnx(TIRPC_DEBUG_FLAG_ERROR,
-				"%s:%u ERROR rm_xid",
-				__func__, __LINE__);
-			return (false);
-		}
-		if (!xdr_getenum(xdrs, (enum_t *)&(dmsg->rm_direction))) {
-			__warnx(TIRPC_DEBUG_FLAG_ERROR,
-				"%s:%u ERROR rm_direction",
-				__func__, __LINE__);
-			return (false);
-		}
+	buf = inline_xdr_getwindow(xdrs, 5 * BYTES_PER_XDR_UNIT, stage);
+	if (buf == NULL) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s:%u ERROR rm_xid",
+			__func__, __LINE__);
+		return (false);
 	}
+	dmsg->rm_xid = IXDR_GET_U_INT32(buf);
+	dmsg->rm_direction = IXDR_GET_ENUM(buf, enum msg_type);
 
 	switch (dmsg->rm_direction) {
 	case CALL:
@@ -87,6 +87,12 @@ tirpc_control(const u_int rq, void *in)
 	case TIRPC_SET_WARNX:
 		__ntirpc_pkg_params.warnx = *(warnx_t) in;
 		break;
+	case TIRPC_GET_RPCB_CACHE:
+		__rpcb_cache_params((struct rpcb_cache_params *)in, false);
+		break;
+	case TIRPC_SET_RPCB_CACHE:
+		__rpcb_cache_params((struct rpcb_cache_params *)in, true);
+		break;
 	default:
 		return (false);
 	}
@@ -48,6 +48,8 @@
 #include <rpc/xdr_inline.h>
 #include <rpc/auth_inline.h>
 
+#include "rpc_com.h"
+
 static void accepted(enum accept_stat, struct rpc_err *);
 static void rejected(enum reject_stat, struct rpc_err *);
 
@@ -158,9 +160,15 @@ static const struct xdr_discrim reply_dscrm[3] = {
 bool
 xdr_nreplymsg(XDR *xdrs, struct rpc_msg *rmsg)
 {
+	bool rslt;
+
 	assert(xdrs != NULL);
 	assert(rmsg != NULL);
 
+	if (xdrs->x_op == XDR_ENCODE
+	    && xdr_reply_encode_tmpl(xdrs, rmsg, &rslt))
+		return (rslt);
+
 	if (inline_xdr_u_int32_t(xdrs, &(rmsg->rm_xid))
 	    && inline_xdr_enum(xdrs, (enum_t *) &(rmsg->rm_direction))
 	    && (rmsg->rm_direction == REPLY))
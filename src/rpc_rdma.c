@@ -76,6 +76,7 @@
 
 #include "misc/abstract_atomic.h"
 #include "rpc_rdma.h"
+#include "svc_internal.h"
 
 #ifdef HAVE_VALGRIND_MEMCHECK_H
 #  include <valgrind/memcheck.h>
@@ -1353,6 +1354,7 @@ rpc_rdma_destroy(SVCXPRT *s_xprt)
 	mutex_destroy(&xprt->xprt.xp_lock);
 	mutex_destroy(&xprt->xprt.xp_auth_lock);
 
+	svc_hist_xprt_destroy(&xprt->xprt);
 	mem_free(xprt, sizeof(*xprt));
 }
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rpc_ring.c
+ * Lock-free record ring, see rpc_ring.h.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <misc/abstract_atomic.h>
+
+#include "rpc_ring.h"
+
+__thread uint32_t __rpc_tid;
+
+uint32_t
+rpc_gettid_slow(void)
+{
+#ifdef SYS_gettid
+	__rpc_tid = syscall(SYS_gettid);
+#else
+	__rpc_tid = (uint32_t)(uintptr_t)&__rpc_tid;
+#endif
+	return (__rpc_tid);
+}
+
+bool
+rpc_ring_alloc(struct rpc_ring *ring, u_int nrecs)
+{
+	char *recs;
+	uint64_t size = 1;
+
+	mutex_lock(&ring->mtx);
+	if (!ring->recs) {
+		while (size < nrecs)
+			size <<= 1;
+		recs = mem_zalloc(size * ring->recsize);
+		if (!recs) {
+			mutex_unlock(&ring->mtx);
+			return (false);
+		}
+		ring->mask = size - 1;
+		/* published before any writer is enabled */
+		atomic_store_voidptr((void **)&ring->recs, recs);
+	}
+	mutex_unlock(&ring->mtx);
+	return (true);
+}
+
+u_int
+rpc_ring_read(struct rpc_ring *ring, void *recs, u_int max, uint64_t *cursor)
+{
+	char *out = recs;
+	uint64_t *rec;
+	uint64_t head = atomic_fetch_uint64_t(&ring->head);
+	uint64_t pos = *cursor;
+	uint64_t seq;
+	u_int n = 0;
+
+	if (!ring->recs)
+		return (0);
+
+	/* anything older has been overwritten */
+	if (head - pos > ring->mask + 1)
+		pos = head - (ring->mask + 1);
+
+	for (; pos < head && n < max; ++pos) {
+		rec = (uint64_t *)(ring->recs
+				   + (pos & ring->mask) * ring->recsize);
+		seq = atomic_fetch_uint64_t(rec);
+		if (seq > pos + 1)
+			continue;	/* overwritten */
+		if (seq != pos + 1)
+			break;		/* still being written, retry later */
+		memcpy(out + n * ring->recsize, rec, ring->recsize);
+		if (atomic_fetch_uint64_t(rec) != seq)
+			continue;	/* overwritten while copying */
+		n++;
+	}
+	*cursor = pos;
+	return (n);
+}
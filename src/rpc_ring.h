@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Lock-free ring of fixed size records, shared by the tracepoints and
+ * the request spans, and the clock and thread id they stamp them with.
+ *
+ * Every record begins with a uint64_t sequence.  Writers claim a
+ * position with one atomic add, then publish the record by storing its
+ * sequence (position + 1) last; readers check the sequence before and
+ * after copying, so a record being overwritten is never returned.
+ */
+
+#ifndef RPC_RING_H
+#define RPC_RING_H
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/abstract_atomic.h>
+#include <intrinsic.h>
+
+struct rpc_ring {
+	mutex_t mtx;		/* serializes allocation */
+	char *recs;
+	size_t recsize;
+	uint64_t mask;		/* ring size - 1 */
+	uint64_t head;		/* next position */
+};
+
+#define RPC_RING_INITIALIZER(type) \
+	{ MUTEX_INITIALIZER, NULL, sizeof(type), 0, 0 }
+
+/* CLOCK_MONOTONIC nanoseconds */
+static inline uint64_t
+rpc_now_ns(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+extern __thread uint32_t __rpc_tid;
+
+uint32_t rpc_gettid_slow(void);
+
+/* kernel thread id, cached per thread */
+static inline uint32_t
+rpc_gettid(void)
+{
+	if (unlikely(!__rpc_tid))
+		return (rpc_gettid_slow());
+	return (__rpc_tid);
+}
+
+/*
+ * The ring is allocated by the first call, rounded up to a power of two
+ * records, and kept until shutdown; later sizes are ignored.
+ */
+bool rpc_ring_alloc(struct rpc_ring *ring, u_int nrecs);
+
+static inline bool
+rpc_ring_ready(struct rpc_ring *ring)
+{
+	return (ring->recs != NULL);
+}
+
+static inline uint64_t
+rpc_ring_head(struct rpc_ring *ring)
+{
+	return (atomic_fetch_uint64_t(&ring->head));
+}
+
+/* claim the next record, to be filled in and passed to rpc_ring_publish */
+static inline void *
+rpc_ring_claim(struct rpc_ring *ring, uint64_t *pos)
+{
+	uint64_t *rec;
+
+	*pos = atomic_inc_uint64_t(&ring->head) - 1;
+	rec = (uint64_t *)(ring->recs + (*pos & ring->mask) * ring->recsize);
+	atomic_store_uint64_t(rec, 0);
+	return (rec);
+}
+
+static inline void
+rpc_ring_publish(void *rec, uint64_t pos)
+{
+	atomic_store_uint64_t((uint64_t *)rec, pos + 1);
+}
+
+/*
+ * Copy out up to max records from *cursor (initially 0), advancing it.
+ * Records overwritten before they were read are skipped.
+ */
+u_int rpc_ring_read(struct rpc_ring *ring, void *recs, u_int max,
+		    uint64_t *cursor);
+
+#endif				/* RPC_RING_H */
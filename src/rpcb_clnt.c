@@ -54,6 +54,13 @@
 #include <netdb.h>
 #include <syslog.h>
 #include <assert.h>
+#include <time.h>
+
+#include <misc/portable.h>
+#include <misc/queue.h>
+#include <misc/opr.h>
+#include <misc/city.h>
+#include <rpc/work_pool.h>
 
 #include "rpc_com.h"
 
@@ -67,27 +74,75 @@ static const char nullstring[] = "\000";
 
 #define RPCB_OWNER_STRING "libntirpc"
 
-#define CACHESIZE 6
+/*
+ * Address cache, for both the rpcbind address of a (host, netid), and
+ * the service address of a (host, netid, prog, vers).  Hashed into
+ * independently locked partitions, each bounded with LRU replacement.
+ */
+#define RPCB_CACHE_PARTITIONS 17
+#define RPCB_CACHE_BUCKETS 64	/* per partition, power of 2 */
 
 struct address_cache {
+	struct address_cache *ac_next;	/* hash chain */
+	TAILQ_ENTRY(address_cache) ac_lru;
+	uint64_t ac_hk;
+	rpcprog_t ac_prog;	/* 0 for the rpcbind address */
+	rpcvers_t ac_vers;
 	char *ac_host;
 	char *ac_netid;
 	char *ac_uaddr;
-	struct netbuf *ac_taddr;
-	struct address_cache *ac_next;
+	struct netbuf ac_taddr;
+	enum clnt_stat ac_stat;	/* RPC_SUCCESS, else negative entry */
+	time_t ac_expires;
+	bool ac_refreshing;
+	size_t ac_size;
 };
 
-static struct address_cache *front;
-static int cachesize;
+struct address_cache_part {
+	CACHE_PAD(0);
+	mutex_t mtx;
+	TAILQ_HEAD(ac_lru_head, address_cache) lru;
+	uint32_t count;
+	struct address_cache *bucket[RPCB_CACHE_BUCKETS];
+};
+
+static struct address_cache_part rpcb_cache[RPCB_CACHE_PARTITIONS];
+static pthread_once_t rpcb_cache_once = PTHREAD_ONCE_INIT;
+
+static struct rpcb_cache_params rpcb_cache_params = {
+	.ttl = 300,
+	.neg_ttl = 10,
+	.stale = 60,
+	.max = 1024,
+};
+
+enum rpcb_cache_result {
+	RPCB_CACHE_MISS,
+	RPCB_CACHE_HIT,
+	RPCB_CACHE_STALE,	/* hit, caller should refresh */
+};
+
+struct rpcb_cache_refresh {
+	struct work_pool_entry wpe;
+	rpcprog_t prog;
+	rpcvers_t vers;
+	char *host;
+	char *netid;
+	size_t size;
+};
 
 #define CLCR_GET_RPCB_TIMEOUT 1
 #define CLCR_SET_RPCB_TIMEOUT 2
 
 extern int __rpc_lowvers;
 
-static struct address_cache *check_cache(const char *, const char *);
-static void delete_cache(struct netbuf *);
-static void add_cache(const char *, const char *, struct netbuf *, char *);
+static enum rpcb_cache_result check_cache(const char *, const char *,
+					  rpcprog_t, rpcvers_t,
+					  struct netbuf **, char **,
+					  enum clnt_stat *);
+static void delete_cache(const char *, const char *, rpcprog_t, rpcvers_t);
+static void add_cache(const char *, const char *, rpcprog_t, rpcvers_t,
+		      struct netbuf *, char *, enum clnt_stat);
 static CLIENT *getclnthandle(const char *, const struct netconfig *, char **);
 static CLIENT *local_rpcb(void);
 #ifdef NOTUSED
@@ -121,140 +176,328 @@ bool __rpc_control(int request, void *info)
 	return (true);
 }
 
-/*
- * It might seem that a reader/writer lock would be more reasonable here.
- * However because getclnthandle(), the only user of the cache functions,
- * may do a delete_cache() operation if a check_cache() fails to return an
- * address useful to clnt_tli_ncreate(), we may as well use a mutex.
- */
-/*
- * As it turns out, if the cache lock is *not* a reader/writer lock, we will
- * block all clnt_ncreate's if we are trying to connect to a host that's down,
- * since the lock will be held all during that time.
- */
-extern rwlock_t rpcbaddr_cache_lock;
+static void
+rpcb_cache_init(void)
+{
+	struct address_cache_part *acp;
+	int ix;
+
+	for (ix = 0; ix < RPCB_CACHE_PARTITIONS; ++ix) {
+		acp = &rpcb_cache[ix];
+		mutex_init(&acp->mtx, NULL);
+		TAILQ_INIT(&acp->lru);
+	}
+}
+
+static inline uint64_t
+rpcb_cache_hash(const char *host, const char *netid, rpcprog_t prog,
+		rpcvers_t vers)
+{
+	uint64_t hk = CityHash64WithSeed(host, strlen(host),
+					 ((uint64_t) prog << 32) | vers);
+
+	return (CityHash64WithSeed(netid, strlen(netid), hk));
+}
+
+static inline struct address_cache_part *
+rpcb_cache_part(uint64_t hk)
+{
+	(void)pthread_once(&rpcb_cache_once, rpcb_cache_init);
+	return (&rpcb_cache[hk % RPCB_CACHE_PARTITIONS]);
+}
+
+static inline struct address_cache **
+rpcb_cache_bucket(struct address_cache_part *acp, uint64_t hk)
+{
+	return (&acp->bucket[(hk / RPCB_CACHE_PARTITIONS)
+			     & (RPCB_CACHE_BUCKETS - 1)]);
+}
+
+static inline time_t
+rpcb_cache_now(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+	return (now.tv_sec);
+}
+
+static struct netbuf *
+rpcb_cache_netbuf_dup(const struct netbuf *nb)
+{
+	struct netbuf *dup = mem_zalloc(sizeof(struct netbuf));
+
+	if (!dup)
+		return (NULL);
+	dup->buf = mem_alloc(nb->len);
+	if (!dup->buf) {
+		mem_free(dup, sizeof(struct netbuf));
+		return (NULL);
+	}
+	memcpy(dup->buf, nb->buf, nb->len);
+	dup->len = dup->maxlen = nb->len;
+	return (dup);
+}
+
+/* partition lock held */
+static struct address_cache **
+rpcb_cache_find(struct address_cache_part *acp, uint64_t hk,
+		const char *host, const char *netid, rpcprog_t prog,
+		rpcvers_t vers)
+{
+	struct address_cache **acpp = rpcb_cache_bucket(acp, hk);
+	struct address_cache *cptr;
+
+	for (; (cptr = *acpp) != NULL; acpp = &cptr->ac_next) {
+		if (cptr->ac_hk == hk && cptr->ac_prog == prog
+		    && cptr->ac_vers == vers && !strcmp(cptr->ac_host, host)
+		    && !strcmp(cptr->ac_netid, netid))
+			return (acpp);
+	}
+	return (NULL);
+}
+
+/* partition lock held */
+static void
+rpcb_cache_unlink(struct address_cache_part *acp, struct address_cache **acpp)
+{
+	struct address_cache *cptr = *acpp;
+
+	*acpp = cptr->ac_next;
+	TAILQ_REMOVE(&acp->lru, cptr, ac_lru);
+	--(acp->count);
+	mem_free(cptr, cptr->ac_size);
+}
 
 /*
  * The routines check_cache(), add_cache(), delete_cache() manage the
- * cache of rpcbind addresses for (host, netid).
+ * cache of rpcbind addresses for (host, netid) when prog is 0, and of
+ * service addresses for (host, netid, prog, vers) otherwise.
+ *
+ * check_cache() returns copies of the cached addresses (either may be
+ * NULL), or the cached error of a negative entry in *stat.  A stale
+ * entry is returned at most once for refresh; others see it as a hit
+ * until the refresh replaces it, or the stale interval passes.
  */
-
-static struct address_cache *
-check_cache(const char *host, const char *netid)
+static enum rpcb_cache_result
+check_cache(const char *host, const char *netid, rpcprog_t prog,
+	    rpcvers_t vers, struct netbuf **taddr, char **uaddr,
+	    enum clnt_stat *stat)
 {
+	uint64_t hk = rpcb_cache_hash(host, netid, prog, vers);
+	struct address_cache_part *acp = rpcb_cache_part(hk);
+	struct address_cache **acpp;
 	struct address_cache *cptr;
+	enum rpcb_cache_result result = RPCB_CACHE_HIT;
+	time_t now = rpcb_cache_now();
+
+	if (taddr)
+		*taddr = NULL;
+	if (uaddr)
+		*uaddr = NULL;
+
+	mutex_lock(&acp->mtx);
+	acpp = rpcb_cache_find(acp, hk, host, netid, prog, vers);
+	if (!acpp) {
+		mutex_unlock(&acp->mtx);
+		return (RPCB_CACHE_MISS);
+	}
+	cptr = *acpp;
+
+	if (now >= cptr->ac_expires) {
+		if (cptr->ac_stat != RPC_SUCCESS
+		    || now >= cptr->ac_expires + rpcb_cache_params.stale) {
+			rpcb_cache_unlink(acp, acpp);
+			mutex_unlock(&acp->mtx);
+			return (RPCB_CACHE_MISS);
+		}
+		if (!cptr->ac_refreshing) {
+			cptr->ac_refreshing = true;
+			result = RPCB_CACHE_STALE;
+		}
+	}
+
+	/* most recently used at tail */
+	TAILQ_REMOVE(&acp->lru, cptr, ac_lru);
+	TAILQ_INSERT_TAIL(&acp->lru, cptr, ac_lru);
+
+	*stat = cptr->ac_stat;
+	if (cptr->ac_stat == RPC_SUCCESS) {
+		if (taddr && cptr->ac_taddr.len)
+			*taddr = rpcb_cache_netbuf_dup(&cptr->ac_taddr);
+		if (uaddr && cptr->ac_uaddr)
+			*uaddr = rpc_strdup(cptr->ac_uaddr);
+	}
+	mutex_unlock(&acp->mtx);
 
-	/* READ LOCK HELD ON ENTRY: rpcbaddr_cache_lock */
-	for (cptr = front; cptr != NULL; cptr = cptr->ac_next) {
-		if (!strcmp(cptr->ac_host, host)
-		    && !strcmp(cptr->ac_netid, netid)) {
 #ifdef ND_DEBUG
-			fprintf(stderr, "Found cache entry for %s: %s\n", host,
-				netid);
+	fprintf(stderr, "Found cache entry for %s: %s\n", host, netid);
 #endif
-			return (cptr);
-		}
-	}
-	return ((struct address_cache *)NULL);
+	return (result);
 }
 
 static void
-delete_cache(struct netbuf *addr)
+delete_cache(const char *host, const char *netid, rpcprog_t prog,
+	     rpcvers_t vers)
 {
-	struct address_cache *cptr, *prevptr = NULL;
-
-	/* WRITE LOCK HELD ON ENTRY: rpcbaddr_cache_lock */
-	for (cptr = front; cptr != NULL; cptr = cptr->ac_next) {
-		if (!memcmp(cptr->ac_taddr->buf, addr->buf, addr->len)) {
-			mem_free(cptr->ac_host, 0);	/* XXX */
-			mem_free(cptr->ac_netid, 0);
-			mem_free(cptr->ac_taddr->buf, 0);
-			mem_free(cptr->ac_taddr, 0);
-			if (cptr->ac_uaddr)
-				mem_free(cptr->ac_uaddr, 0);
-			if (prevptr)
-				prevptr->ac_next = cptr->ac_next;
-			else
-				front = cptr->ac_next;
-			mem_free(cptr, 0);
-			cachesize--;
-			break;
-		}
-		prevptr = cptr;
-	}
+	uint64_t hk = rpcb_cache_hash(host, netid, prog, vers);
+	struct address_cache_part *acp = rpcb_cache_part(hk);
+	struct address_cache **acpp;
+
+	mutex_lock(&acp->mtx);
+	acpp = rpcb_cache_find(acp, hk, host, netid, prog, vers);
+	if (acpp)
+		rpcb_cache_unlink(acp, acpp);
+	mutex_unlock(&acp->mtx);
 }
 
+/*
+ * Insert or replace an entry.  A negative entry (stat != RPC_SUCCESS)
+ * records an authoritative failure for neg_ttl seconds.
+ */
 static void
-add_cache(const char *host, const char *netid, struct netbuf *taddr,
-	  char *uaddr)
+add_cache(const char *host, const char *netid, rpcprog_t prog,
+	  rpcvers_t vers, struct netbuf *taddr, char *uaddr,
+	  enum clnt_stat stat)
 {
-	struct address_cache *ad_cache, *cptr, *prevptr;
+	uint64_t hk = rpcb_cache_hash(host, netid, prog, vers);
+	struct address_cache_part *acp = rpcb_cache_part(hk);
+	struct address_cache **acpp;
+	struct address_cache *ad_cache;
+	size_t host_len = strlen(host) + 1;
+	size_t netid_len = strlen(netid) + 1;
+	size_t uaddr_len = (uaddr) ? strlen(uaddr) + 1 : 0;
+	size_t taddr_len = (taddr) ? taddr->len : 0;
+	uint32_t max_part;
+	char *p;
+
+	if (stat == RPC_SUCCESS && !rpcb_cache_params.ttl)
+		return;
+	if (stat != RPC_SUCCESS && !rpcb_cache_params.neg_ttl)
+		return;
 
-	ad_cache = (struct address_cache *)
-	    mem_zalloc(sizeof(struct address_cache));
+	/* one block: entry, taddr, host, netid, uaddr */
+	ad_cache = mem_zalloc(sizeof(struct address_cache) + taddr_len
+			      + host_len + netid_len + uaddr_len);
 	if (!ad_cache)
 		return;
-	ad_cache->ac_host = (host) ? rpc_strdup(host) : NULL;
-	ad_cache->ac_netid = rpc_strdup(netid);
-	ad_cache->ac_uaddr = uaddr ? rpc_strdup(uaddr) : NULL;
-	ad_cache->ac_taddr = (struct netbuf *)mem_zalloc(sizeof(struct netbuf));
-	if (!ad_cache->ac_host || !ad_cache->ac_netid || !ad_cache->ac_taddr
-	    || (uaddr && !ad_cache->ac_uaddr))
-		goto out_free;
-	ad_cache->ac_taddr->len = ad_cache->ac_taddr->maxlen = taddr->len;
-	ad_cache->ac_taddr->buf = (char *)mem_zalloc(taddr->len);
-	if (ad_cache->ac_taddr->buf == NULL)
-		goto out_free;
-	memcpy(ad_cache->ac_taddr->buf, taddr->buf, taddr->len);
+	ad_cache->ac_size = sizeof(struct address_cache) + taddr_len
+	    + host_len + netid_len + uaddr_len;
+	ad_cache->ac_hk = hk;
+	ad_cache->ac_prog = prog;
+	ad_cache->ac_vers = vers;
+	ad_cache->ac_stat = stat;
+	ad_cache->ac_expires = rpcb_cache_now()
+	    + ((stat == RPC_SUCCESS) ? rpcb_cache_params.ttl
+	       : rpcb_cache_params.neg_ttl);
+
+	p = (char *)(ad_cache + 1);
+	if (taddr_len) {
+		ad_cache->ac_taddr.buf = p;
+		ad_cache->ac_taddr.len = ad_cache->ac_taddr.maxlen = taddr_len;
+		memcpy(p, taddr->buf, taddr_len);
+		p += taddr_len;
+	}
+	ad_cache->ac_host = p;
+	memcpy(p, host, host_len);
+	p += host_len;
+	ad_cache->ac_netid = p;
+	memcpy(p, netid, netid_len);
+	p += netid_len;
+	if (uaddr_len) {
+		ad_cache->ac_uaddr = p;
+		memcpy(p, uaddr, uaddr_len);
+	}
 #ifdef ND_DEBUG
 	fprintf(stderr, "Added to cache: %s : %s\n", host, netid);
 #endif
 
-	/* VARIABLES PROTECTED BY rpcbaddr_cache_lock:  cptr */
-	rwlock_wrlock(&rpcbaddr_cache_lock);
-	if (cachesize < CACHESIZE) {
-		ad_cache->ac_next = front;
-		front = ad_cache;
-		cachesize++;
-	} else {
-		/* Free the last entry */
-		cptr = front;
-		prevptr = NULL;
-		while (cptr->ac_next) {
-			prevptr = cptr;
-			cptr = cptr->ac_next;
-		}
+	max_part = rpcb_cache_params.max / RPCB_CACHE_PARTITIONS;
+	if (!max_part)
+		max_part = 1;
+
+	mutex_lock(&acp->mtx);
+	acpp = rpcb_cache_find(acp, hk, host, netid, prog, vers);
+	if (acpp)
+		rpcb_cache_unlink(acp, acpp);
+	while (acp->count >= max_part) {
+		/* least recently used */
+		struct address_cache *cptr = TAILQ_FIRST(&acp->lru);
+
+		acpp = rpcb_cache_find(acp, cptr->ac_hk, cptr->ac_host,
+				       cptr->ac_netid, cptr->ac_prog,
+				       cptr->ac_vers);
+		rpcb_cache_unlink(acp, acpp);
+	}
+	acpp = rpcb_cache_bucket(acp, hk);
+	ad_cache->ac_next = *acpp;
+	*acpp = ad_cache;
+	TAILQ_INSERT_TAIL(&acp->lru, ad_cache, ac_lru);
+	++(acp->count);
+	mutex_unlock(&acp->mtx);
+}
 
-#ifdef ND_DEBUG
-		fprintf(stderr, "Deleted from cache: %s : %s\n", cptr->ac_host,
-			cptr->ac_netid);
-#endif
-		mem_free(cptr->ac_host, 0);	/* XXX */
-		mem_free(cptr->ac_netid, 0);
-		mem_free(cptr->ac_taddr->buf, 0);
-		mem_free(cptr->ac_taddr, 0);
-		if (cptr->ac_uaddr)
-			mem_free(cptr->ac_uaddr, 0);
-
-		if (prevptr) {
-			prevptr->ac_next = NULL;
-			ad_cache->ac_next = front;
-			front = ad_cache;
-		} else {
-			front = ad_cache;
-			ad_cache->ac_next = NULL;
+/*
+ * A refresh of a stale entry has finished (however it ended)
+ */
+static void
+rpcb_cache_refreshed(const char *host, const char *netid, rpcprog_t prog,
+		     rpcvers_t vers)
+{
+	uint64_t hk = rpcb_cache_hash(host, netid, prog, vers);
+	struct address_cache_part *acp = rpcb_cache_part(hk);
+	struct address_cache **acpp;
+
+	mutex_lock(&acp->mtx);
+	acpp = rpcb_cache_find(acp, hk, host, netid, prog, vers);
+	if (acpp)
+		(*acpp)->ac_refreshing = false;
+	mutex_unlock(&acp->mtx);
+}
+
+/*
+ * Drop a service address that failed to connect, so the next call
+ * asks rpcbind again.
+ */
+void
+__rpcb_cache_invalidate(rpcprog_t prog, rpcvers_t vers,
+			const struct netconfig *nconf, const char *host)
+{
+	if (host && nconf && prog)
+		delete_cache(host, nconf->nc_netid, prog, vers);
+}
+
+/*
+ * Get or set address cache parameters (tirpc_control)
+ */
+void
+__rpcb_cache_params(struct rpcb_cache_params *params, bool set)
+{
+	struct address_cache_part *acp;
+	struct address_cache *cptr;
+	int ix;
+
+	if (!set) {
+		*params = rpcb_cache_params;
+		return;
+	}
+	rpcb_cache_params = *params;
+
+	/* flush, rather than trying to apply new limits */
+	(void)pthread_once(&rpcb_cache_once, rpcb_cache_init);
+	for (ix = 0; ix < RPCB_CACHE_PARTITIONS; ++ix) {
+		acp = &rpcb_cache[ix];
+		mutex_lock(&acp->mtx);
+		while ((cptr = TAILQ_FIRST(&acp->lru))) {
+			rpcb_cache_unlink(acp,
+					  rpcb_cache_find(acp, cptr->ac_hk,
+							  cptr->ac_host,
+							  cptr->ac_netid,
+							  cptr->ac_prog,
+							  cptr->ac_vers));
 		}
-		mem_free(cptr, 0);
+		mutex_unlock(&acp->mtx);
 	}
-	rwlock_unlock(&rpcbaddr_cache_lock);
-	return;
-
- out_free:
-	mem_free(ad_cache->ac_host, 0);	/* XXX */
-	mem_free(ad_cache->ac_netid, 0);
-	mem_free(ad_cache->ac_uaddr, 0);
-	mem_free(ad_cache->ac_taddr, 0);
-	mem_free(ad_cache, 0);
 }
 
 /*
@@ -269,54 +512,48 @@ static CLIENT *getclnthandle(const char *host, const struct netconfig *nconf,
 {
 	CLIENT *client;
 	struct netbuf *addr, taddr;
-	struct netbuf addr_to_delete;
 	struct __rpc_sockinfo si;
 	struct addrinfo hints, *res, *tres;
-	struct address_cache *ad_cache;
+	enum clnt_stat stat;
 	char *tmpaddr;
-
-	memset(&addr_to_delete, '\0', sizeof(addr_to_delete));
-
-/* VARIABLES PROTECTED BY rpcbaddr_cache_lock:  ad_cache */
+	int rc;
 
 	/* Get the address of the rpcbind.  Check cache first */
 	client = NULL;
 	if (targaddr)
 		*targaddr = NULL;
-	addr_to_delete.len = 0;
-	rwlock_rdlock(&rpcbaddr_cache_lock);
-	ad_cache = NULL;
-	if (host != NULL)
-		ad_cache = check_cache(host, nconf->nc_netid);
-	if (ad_cache != NULL) {
-		addr = ad_cache->ac_taddr;
-		client =
-		    clnt_tli_ncreate(RPC_ANYFD, nconf, addr,
-				     (rpcprog_t) RPCBPROG,
-				     (rpcvers_t) RPCBVERS4, 0, 0);
+	if (host != NULL
+	    && check_cache(host, nconf->nc_netid, 0, 0, &addr,
+			   targaddr ? &tmpaddr : NULL, &stat)
+	    != RPCB_CACHE_MISS) {
+		if (stat != RPC_SUCCESS) {
+			rpc_createerr.cf_stat = stat;
+			return (NULL);
+		}
+		/* the lock is not held while connecting */
+		client = (addr) ? clnt_tli_ncreate(RPC_ANYFD, nconf, addr,
+						   (rpcprog_t) RPCBPROG,
+						   (rpcvers_t) RPCBVERS4,
+						   0, 0)
+		    : NULL;
+		if (client && targaddr && !tmpaddr)
+			tmpaddr = taddr2uaddr(nconf, addr);
+		if (addr) {
+			mem_free(addr->buf, addr->len);
+			mem_free(addr, sizeof(struct netbuf));
+		}
 		if (client != NULL) {
 			if (targaddr)
-				*targaddr = rpc_strdup(ad_cache->ac_uaddr);
-			rwlock_unlock(&rpcbaddr_cache_lock);
+				*targaddr = tmpaddr;
 			return (client);
 		}
-		addr_to_delete.len = addr->len;
-		addr_to_delete.buf = (char *)mem_zalloc(addr->len);
-		if (addr_to_delete.buf == NULL)
-			addr_to_delete.len = 0;
-		else
-			memcpy(addr_to_delete.buf, addr->buf, addr->len);
-	}
-	rwlock_unlock(&rpcbaddr_cache_lock);
-	if (addr_to_delete.len != 0) {
+		if (targaddr)
+			mem_free(tmpaddr, 0);
 		/*
 		 * Assume this may be due to cache data being
 		 *  outdated
 		 */
-		rwlock_wrlock(&rpcbaddr_cache_lock);
-		delete_cache(&addr_to_delete);
-		rwlock_unlock(&rpcbaddr_cache_lock);
-		mem_free(addr_to_delete.buf, 0);	/* XXX */
+		delete_cache(host, nconf->nc_netid, 0, 0);
 	}
 	if (!__rpc_nconf2sockinfo(nconf, &si)) {
 		rpc_createerr.cf_stat = RPC_UNKNOWNPROTO;
@@ -353,7 +590,12 @@ static CLIENT *getclnthandle(const char *host, const struct netconfig *nconf,
 			return (client);
 		}
 	} else {
-		if (getaddrinfo(host, "sunrpc", &hints, &res) != 0) {
+		rc = getaddrinfo(host, "sunrpc", &hints, &res);
+		if (rc != 0) {
+			/* only a name that does not exist is remembered */
+			if (host && rc == EAI_NONAME)
+				add_cache(host, nconf->nc_netid, 0, 0, NULL,
+					  NULL, RPC_UNKNOWNHOST);
 			rpc_createerr.cf_stat = RPC_UNKNOWNHOST;
 			assert(client == NULL);
 			goto out_err;
@@ -398,7 +640,9 @@ static CLIENT *getclnthandle(const char *host, const struct netconfig *nconf,
 
 		if (client) {
 			tmpaddr = targaddr ? taddr2uaddr(nconf, &taddr) : NULL;
-			add_cache(host, nconf->nc_netid, &taddr, tmpaddr);
+			if (host)
+				add_cache(host, nconf->nc_netid, 0, 0, &taddr,
+					  tmpaddr, RPC_SUCCESS);
 			if (targaddr)
 				*targaddr = tmpaddr;
 			break;
@@ -831,6 +1075,174 @@ __rpcb_findaddr_timed(rpcprog_t program, rpcvers_t version,
 	return (address);
 }
 
+static inline bool
+rpcb_cache_negative(enum clnt_stat stat)
+{
+	switch (stat) {
+	case RPC_PROGNOTREGISTERED:
+	case RPC_UNKNOWNHOST:
+	case RPC_N2AXLATEFAILURE:
+		return (true);
+	default:
+		return (false);
+	}
+}
+
+/*
+ * Record the outcome of a lookup.  Only authoritative failures are
+ * cached; others leave any existing entry for the next caller.
+ */
+static void
+rpcb_cache_update(rpcprog_t program, rpcvers_t version,
+		  const struct netconfig *nconf, const char *host,
+		  struct netbuf *address)
+{
+	enum clnt_stat stat = rpc_createerr.cf_stat;
+
+	if (address)
+		add_cache(host, nconf->nc_netid, program, version, address,
+			  NULL, RPC_SUCCESS);
+	else if (rpcb_cache_negative(stat))
+		add_cache(host, nconf->nc_netid, program, version, NULL,
+			  NULL, stat);
+	else
+		rpcb_cache_refreshed(host, nconf->nc_netid, program, version);
+}
+
+static void
+rpcb_cache_refresh_run(struct work_pool_entry *wpe)
+{
+	struct rpcb_cache_refresh *rf =
+	    opr_containerof(wpe, struct rpcb_cache_refresh, wpe);
+	struct netconfig *nconf = getnetconfigent(rf->netid);
+	struct netbuf *address;
+
+	if (nconf) {
+		address = __rpcb_findaddr_timed(rf->prog, rf->vers, nconf,
+						rf->host, NULL, NULL);
+		rpcb_cache_update(rf->prog, rf->vers, nconf, rf->host,
+				  address);
+		if (address) {
+			mem_free(address->buf, 0);
+			mem_free(address, 0);
+		}
+		freenetconfigent(nconf);
+	} else
+		rpcb_cache_refreshed(rf->host, rf->netid, rf->prog, rf->vers);
+
+	mem_free(rf, rf->size);
+}
+
+static void *
+rpcb_cache_refresh_thread(void *arg)
+{
+	rpcb_cache_refresh_run(arg);
+	return (NULL);
+}
+
+/*
+ * Refresh a stale entry in the background: on the service threads when
+ * they run, else on a thread of its own, so client-only programs do not
+ * wait for rpcbind either.  If neither can start, the stale address is
+ * used, and the next caller tries again.
+ */
+static void
+rpcb_cache_refresh(rpcprog_t program, rpcvers_t version,
+		   const struct netconfig *nconf, const char *host)
+{
+	struct rpcb_cache_refresh *rf;
+	size_t host_len = strlen(host) + 1;
+	size_t netid_len = strlen(nconf->nc_netid) + 1;
+	pthread_attr_t attr;
+	pthread_t tid;
+	int rc;
+
+	rf = mem_zalloc(sizeof(struct rpcb_cache_refresh) + host_len
+			+ netid_len);
+	if (!rf) {
+		rpcb_cache_refreshed(host, nconf->nc_netid, program, version);
+		return;
+	}
+	rf->size = sizeof(struct rpcb_cache_refresh) + host_len + netid_len;
+	rf->prog = program;
+	rf->vers = version;
+	rf->host = (char *)(rf + 1);
+	memcpy(rf->host, host, host_len);
+	rf->netid = rf->host + host_len;
+	memcpy(rf->netid, nconf->nc_netid, netid_len);
+	rf->wpe.fun = rpcb_cache_refresh_run;
+
+	if (svc_work_pool.params.thrd_max) {
+		work_pool_submit(&svc_work_pool, &rf->wpe);
+		return;
+	}
+
+	(void)pthread_attr_init(&attr);
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	rc = pthread_create(&tid, &attr, rpcb_cache_refresh_thread, &rf->wpe);
+	(void)pthread_attr_destroy(&attr);
+	if (rc) {
+		rpcb_cache_refreshed(host, nconf->nc_netid, program, version);
+		mem_free(rf, rf->size);
+	}
+}
+
+/*
+ * Cached front end of __rpcb_findaddr_timed(), for clnt_tp_ncreate_timed()
+ * only: rpcb_getaddr() and rpcb_find_mapped_addr() always ask rpcbind.
+ * On a hit no client handle is returned in *clpp, and the caller creates
+ * its own.  A stale hit is used as is, while a refresh runs in the
+ * background.
+ *
+ * Only connection-oriented netids are cached: a wrong address is found
+ * out when connecting fails, and __rpcb_cache_invalidate() drops it.
+ * A datagram client is created without contacting the server, so a
+ * stale address would only show up as calls timing out.
+ */
+struct netbuf *
+__rpcb_findaddr_cached(rpcprog_t program, rpcvers_t version,
+		       const struct netconfig *nconf,
+		       const char *host, CLIENT **clpp,
+		       struct timeval *tp)
+{
+	struct netbuf *address;
+	enum clnt_stat stat;
+
+	if (nconf == NULL || host == NULL
+	    || nconf->nc_semantics == NC_TPI_CLTS
+	    || strcmp(nconf->nc_protofmly, NC_LOOPBACK) == 0)
+		return (__rpcb_findaddr_timed(program, version, nconf, host,
+					      clpp, tp));
+
+	switch (check_cache(host, nconf->nc_netid, program, version,
+			    &address, NULL, &stat)) {
+	case RPCB_CACHE_STALE:
+		rpcb_cache_refresh(program, version, nconf, host);
+		break;
+	case RPCB_CACHE_HIT:
+		break;
+	case RPCB_CACHE_MISS:
+	default:
+		goto lookup;
+	}
+
+	if (stat != RPC_SUCCESS) {
+		rpc_createerr.cf_stat = stat;
+		return (NULL);
+	}
+	if (address) {
+		if (clpp)
+			*clpp = NULL;
+		return (address);
+	}
+
+ lookup:
+	address = __rpcb_findaddr_timed(program, version, nconf, host, clpp,
+					tp);
+	rpcb_cache_update(program, version, nconf, host, address);
+	return (address);
+}
+
 /*
  * Helper routine to find mapped address (for NLM).
  */
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * span.c
+ * Sampled request spans, kept in an rpc_ring, and their Chrome trace
+ * export.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <misc/abstract_atomic.h>
+#include <rpc/span.h>
+
+#include "rpc_ring.h"
+
+#define SPAN_EXPORT_BATCH 256
+
+uint32_t __ntirpc_span_rate;
+
+static struct rpc_ring span_ring =
+	RPC_RING_INITIALIZER(struct tirpc_span_rec);
+
+static const char *span_names[TIRPC_SPAN_STAGES] = {
+	"receive",
+	"auth",
+	"dispatch",
+	"reply",
+	"flush",
+	"app",
+};
+
+uint64_t
+tirpc_span_now(void)
+{
+	return (rpc_now_ns());
+}
+
+void
+tirpc_span_emit(u_int stage, const char *name, const void *xprt,
+		uint32_t xid, uint32_t arg, uint64_t start, uint64_t end)
+{
+	struct tirpc_span_rec *rec;
+	uint64_t pos;
+
+	if (unlikely(!rpc_ring_ready(&span_ring)))
+		return;
+
+	rec = rpc_ring_claim(&span_ring, &pos);
+	rec->start = start;
+	rec->end = end;
+	rec->xprt = xprt;
+	rec->name = name;
+	rec->stage = stage;
+	rec->xid = xid;
+	rec->arg = arg;
+	rec->tid = rpc_gettid();
+	rpc_ring_publish(rec, pos);
+}
+
+bool
+tirpc_span_enable(u_int rate, u_int nrecs)
+{
+	if (!rate)
+		return (false);
+
+	/* allocated before any request is sampled */
+	if (!rpc_ring_alloc(&span_ring, nrecs))
+		return (false);
+	atomic_store_uint32_t(&__ntirpc_span_rate, rate);
+	return (true);
+}
+
+void
+tirpc_span_disable(void)
+{
+	atomic_store_uint32_t(&__ntirpc_span_rate, 0);
+}
+
+u_int
+tirpc_span_read(struct tirpc_span_rec *recs, u_int max, uint64_t *cursor)
+{
+	return (rpc_ring_read(&span_ring, recs, max, cursor));
+}
+
+/* complete ("X") events, times in microseconds */
+u_int
+tirpc_span_export(FILE *fp, uint64_t *cursor)
+{
+	struct tirpc_span_rec recs[SPAN_EXPORT_BATCH];
+	struct tirpc_span_rec *rec;
+	uint64_t head = rpc_ring_head(&span_ring);
+	int pid = getpid();
+	u_int total = 0;
+	u_int n, ix;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	/* stop at the head as of now, however busy the writers */
+	while (*cursor < head
+	       && (n = tirpc_span_read(recs, SPAN_EXPORT_BATCH, cursor))) {
+		for (ix = 0; ix < n; ++ix) {
+			rec = &recs[ix];
+			fprintf(fp, "%s\n{\"name\":\"%s\",\"cat\":\"%s\","
+				"\"ph\":\"X\",\"ts\":%" PRIu64 ".%03u,"
+				"\"dur\":%" PRIu64 ".%03u,\"pid\":%d,"
+				"\"tid\":%" PRIu32 ",\"args\":{"
+				"\"xid\":\"0x%08" PRIx32 "\","
+				"\"xprt\":\"%p\",\"arg\":%" PRIu32 "}}",
+				total ? "," : "",
+				(rec->name) ? rec->name
+					    : span_names[rec->stage
+						% TIRPC_SPAN_STAGES],
+				(rec->stage == TIRPC_SPAN_APP) ? "app"
+							       : "ntirpc",
+				rec->start / 1000,
+				(u_int)(rec->start % 1000),
+				(rec->end - rec->start) / 1000,
+				(u_int)((rec->end - rec->start) % 1000),
+				pid, rec->tid, rec->xid, rec->xprt, rec->arg);
+			total++;
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	return (total);
+}
@@ -67,9 +67,14 @@
 
 #include "clnt_internal.h"
 #include "svc_internal.h"
+#include "rpc_ring.h"
 #include "svc_xprt.h"
 #include "rpc_dplx_internal.h"
 #include <rpc/svc_rqst.h>
+#include <rpc/trace.h>
+#include <rpc/span.h>
+#include <rpc/svc_slow.h>
+#include <rpc/svc_mem.h>
 #ifdef USE_RPC_RDMA
 #include "rpc_rdma.h"
 #endif
@@ -114,6 +119,48 @@ extern rwlock_t svc_fd_lock;
 static struct svc_callout *svc_find(rpcprog_t, rpcvers_t, struct svc_callout **,
 				    char *);
 
+/*
+ * The dispatch index
+ * An immutable, sorted snapshot of the callout list, rebuilt under
+ * svc_lock whenever the list changes and published by pointer swap, so
+ * svc_lookup() takes no lock and does no list walk.  Version ranges for
+ * PROG_MISMATCH replies are computed once per program at rebuild.
+ *
+ * Readers pin a snapshot with svc_dispatch_get(), which counts them in
+ * svc_dispatch_pinning while it takes the snapshot's reference.  A
+ * superseded snapshot is retired, and freed once it has no references
+ * and no reader is between loading the pointer and taking one: by the
+ * put that drops its last reference, or by the next rebuild.
+ */
+struct svc_dispatch_prog {
+	rpcprog_t prog;
+	svc_vers_range_t vrange;
+	uint32_t first;		/* into recs, ordered by vers */
+	uint32_t count;
+};
+
+struct svc_dispatch_index {
+	struct svc_dispatch_index *retired;
+	int32_t refcnt;		/* readers, plus one while published */
+	uint32_t nprogs;
+	uint32_t nrecs;
+	struct svc_dispatch_prog *progs;	/* ordered by prog */
+	svc_rec_t *recs;
+};
+
+static struct svc_dispatch_index *svc_dispatch_index;
+static struct svc_dispatch_index *svc_dispatch_retired;
+static uint32_t svc_dispatch_pinning;
+static mutex_t svc_dispatch_mtx = MUTEX_INITIALIZER;	/* retired list */
+
+static void svc_dispatch_rebuild(void);
+static void svc_dispatch_retire(struct svc_dispatch_index *);
+static void svc_dispatch_shutdown(void);
+static bool svc_reg_rec(SVCXPRT *, const rpcprog_t, const rpcvers_t,
+			void (*)(struct svc_req *, SVCXPRT *),
+			const struct svc_proc_desc *, const u_int,
+			const struct netconfig *);
+
 struct work_pool svc_work_pool;
 
 static int
@@ -216,6 +263,93 @@ svc_init(svc_init_params *params)
 	else
 		__svc_params->gss.max_gc = 200;
 
+	/* intern AUTH_SYS credentials */
+	if (params->flags & SVC_INIT_AUTHUNIX_CACHE)
+		__svc_params->flags |= SVC_FLAG_AUTHUNIX_CACHE;
+
+	/* issue AUTH_SHORT handles for them */
+	if (params->flags & SVC_INIT_AUTHUNIX_SHORT)
+		__svc_params->flags |=
+		    (SVC_FLAG_AUTHUNIX_CACHE | SVC_FLAG_AUTHUNIX_SHORT);
+
+	/* service counters, see svc_stats.h */
+	if (params->flags & SVC_INIT_STATS)
+		__svc_params->flags |= SVC_FLAG_STATS;
+
+	/* latency histograms, see svc_hist.h */
+	if (params->flags & SVC_INIT_HISTOGRAMS)
+		__svc_params->flags |= SVC_FLAG_HISTOGRAMS;
+
+	/* slow request watchdog, see svc_slow.h */
+	if ((params->flags & SVC_INIT_SLOW_REQUESTS)
+	    && svc_slow_init(params->slow_request_msec
+			     ? params->slow_request_msec : 5000))
+		__svc_params->flags |= SVC_FLAG_SLOW_REQUESTS;
+
+	/* exactly sized reply buffers */
+	if (params->flags & SVC_INIT_REPLY_SIZED)
+		__svc_params->flags |= SVC_FLAG_REPLY_SIZED;
+
+	/* zero copy only pays for itself with larger segments */
+	if (params->flags & SVC_INIT_ZEROCOPY)
+		__svc_params->flags |= SVC_FLAG_ZEROCOPY;
+
+	if (params->ioq_zerocopy_min)
+		__svc_params->ioq.zerocopy_min = params->ioq_zerocopy_min;
+	else
+		__svc_params->ioq.zerocopy_min = 16384;
+
+	/* coalesce replies queued together, TCP_NODELAY otherwise */
+	if (params->flags & SVC_INIT_COALESCE)
+		__svc_params->flags |= SVC_FLAG_COALESCE;
+
+	if (params->ioq_coalesce_usec)
+		__svc_params->ioq.coalesce_usec = params->ioq_coalesce_usec;
+	else
+		__svc_params->ioq.coalesce_usec = 500;
+
+	/* stop reading from clients that stop reading their replies */
+	if (params->flags & SVC_INIT_IOQ_BACKLOG)
+		__svc_params->flags |= SVC_FLAG_IOQ_BACKLOG;
+
+	if (params->ioq_backlog_bytes)
+		__svc_params->ioq.backlog_bytes = params->ioq_backlog_bytes;
+	else
+		__svc_params->ioq.backlog_bytes = 64 * 1024 * 1024;
+
+	if (params->ioq_backlog_count)
+		__svc_params->ioq.backlog_count = params->ioq_backlog_count;
+	else
+		__svc_params->ioq.backlog_count = 1024;
+
+	/* stop reading and accepting past the request memory budget */
+	if ((params->flags & SVC_INIT_MEM_BUDGET)
+	    && svc_mem_init(params->mem_budget
+			    ? params->mem_budget : 1024ULL * 1024 * 1024))
+		__svc_params->flags |= SVC_FLAG_MEM_BUDGET;
+
+	if (params->authunix_hash_partitions)
+		__svc_params->authunix.hash_partitions =
+		    params->authunix_hash_partitions;
+	else
+		__svc_params->authunix.hash_partitions = 13;
+
+	if (params->authunix_max_cred)
+		__svc_params->authunix.max_cred = params->authunix_max_cred;
+	else
+		__svc_params->authunix.max_cred = 4096;
+
+	if (params->authunix_short_max)
+		__svc_params->authunix.short_max = params->authunix_short_max;
+	else
+		__svc_params->authunix.short_max =
+		    __svc_params->authunix.max_cred;
+
+	if (params->authunix_short_ttl)
+		__svc_params->authunix.short_ttl = params->authunix_short_ttl;
+	else
+		__svc_params->authunix.short_ttl = 600;
+
 #ifdef USE_RPC_RDMA
 	rpc_rdma_internals_init();
 #endif
@@ -224,6 +358,9 @@ svc_init(svc_init_params *params)
 
 	mutex_unlock(&__svc_params->mtx);
 
+	if (params->flags & SVC_INIT_STATS)
+		(void)svc_stats_listen(params->stats_path);
+
 #if defined(_SC_IOV_MAX) /* IRIX, MacOS X, FreeBSD, Solaris, ... */
 	__svc_maxiov = sysconf(_SC_IOV_MAX);
 #endif
@@ -237,7 +374,9 @@ alloc_rpc_msg(void)
 	if (!msg)
 		goto out;
 
+	svc_mem_add(SVC_MEM_RPC_MSG, sizeof(struct rpc_msg));
 	TAILQ_INIT_ENTRY(msg, msg_q);
+	msg->rm_slow = 0;
 
 	/* avoid separate alloc/free */
 	msg->rm_call.cb_cred.oa_base = msg->cb_cred_body;
@@ -255,6 +394,10 @@ alloc_rpc_msg(void)
 void
 free_rpc_msg(struct rpc_msg *msg)
 {
+	/* no reply was queued */
+	if (unlikely(msg->rm_slow))
+		svc_slow_end(msg->rm_slow);
+	svc_mem_add(SVC_MEM_RPC_MSG, -(int64_t)sizeof(struct rpc_msg));
 	mem_free(msg, sizeof(struct rpc_msg));
 }
 
@@ -262,8 +405,7 @@ static inline void
 free_req_rpc_msg(struct svc_req *req)
 {
 	if (req->rq_msg) {
-		struct rpc_msg *msg = req->rq_msg;
-		mem_free(msg, sizeof(struct rpc_msg));
+		free_rpc_msg(req->rq_msg);
 		req->rq_msg = NULL;
 	}
 }
@@ -314,6 +456,31 @@ bool
 svc_reg(SVCXPRT *xprt, const rpcprog_t prog, const rpcvers_t vers,
 	void (*dispatch) (struct svc_req *req, SVCXPRT *xprt),
 	const struct netconfig *nconf)
+{
+	return (svc_reg_rec(xprt, prog, vers, dispatch, NULL, 0, nconf));
+}
+
+/*
+ * Add a service program to the callout list, as a table of procedures.
+ * Arguments are decoded and results encoded by the library, see
+ * struct svc_proc_desc.
+ */
+bool
+svc_reg_procs(SVCXPRT *xprt, const rpcprog_t prog, const rpcvers_t vers,
+	      const struct svc_proc_desc *procs, const u_int nprocs,
+	      const struct netconfig *nconf)
+{
+	if (!procs || !nprocs)
+		return (false);
+	return (svc_reg_rec(xprt, prog, vers, svc_proc_dispatch_default,
+			    procs, nprocs, nconf));
+}
+
+static bool
+svc_reg_rec(SVCXPRT *xprt, const rpcprog_t prog, const rpcvers_t vers,
+	    void (*dispatch) (struct svc_req *req, SVCXPRT *xprt),
+	    const struct svc_proc_desc *procs, const u_int nprocs,
+	    const struct netconfig *nconf)
 {
 	bool dummy;
 	struct svc_callout *prev;
@@ -345,7 +512,8 @@ svc_reg(SVCXPRT *xprt, const rpcprog_t prog, const rpcvers_t vers,
 	if (s) {
 		if (netid)
 			mem_free(netid, 0);
-		if (s->rec.sc_dispatch == dispatch)
+		if (s->rec.sc_dispatch == dispatch
+		    && (!procs || svc_proc_tbl_match(s->rec.sc_procs, procs)))
 			goto rpcb_it;	/* he is registering another xptr */
 		rwlock_unlock(&svc_lock);
 		return (false);
@@ -362,8 +530,20 @@ svc_reg(SVCXPRT *xprt, const rpcprog_t prog, const rpcvers_t vers,
 	s->rec.sc_vers = vers;
 	s->rec.sc_dispatch = dispatch;
 	s->rec.sc_netid = netid;
+	s->rec.sc_procs = NULL;
+	if (procs) {
+		s->rec.sc_procs = svc_proc_tbl_create(procs, nprocs);
+		if (!s->rec.sc_procs) {
+			if (netid)
+				mem_free(netid, 0);
+			mem_free(s, sizeof(struct svc_callout));
+			rwlock_unlock(&svc_lock);
+			return (false);
+		}
+	}
 	s->sc_next = svc_head;
 	svc_head = s;
+	svc_dispatch_rebuild();
 
 	if ((xprt->xp_netid == NULL) && (flag == 1) && netid)
 		((SVCXPRT *) xprt)->xp_netid = rpc_strdup(netid);
@@ -401,8 +581,12 @@ svc_unreg(const rpcprog_t prog, const rpcvers_t vers)
 		s->sc_next = NULL;
 		if (s->rec.sc_netid)
 			mem_free(s->rec.sc_netid, sizeof(s->rec.sc_netid) + 1);
+		/* dispatch indexes in use may still reference it */
+		if (s->rec.sc_procs)
+			svc_proc_tbl_put(s->rec.sc_procs);
 		mem_free(s, sizeof(struct svc_callout));
 	}
+	svc_dispatch_rebuild();
 	rwlock_unlock(&svc_lock);
 }
 
@@ -425,20 +609,31 @@ svc_register(SVCXPRT *xprt, u_long prog, u_long vers,
 	assert(xprt != NULL);
 	assert(dispatch != NULL);
 
+	rwlock_wrlock(&svc_lock);
 	s = svc_find((rpcprog_t) prog, (rpcvers_t) vers, &prev, NULL);
 	if (s) {
-		if (s->rec.sc_dispatch == dispatch)
+		/* compared locked, svc_unregister() may free it */
+		bool same = (s->rec.sc_dispatch == dispatch);
+
+		rwlock_unlock(&svc_lock);
+		if (same)
 			goto pmap_it;	/* he is registering another xprt */
 		return (false);
 	}
 	s = mem_alloc(sizeof(struct svc_callout));
-	if (!s)
+	if (!s) {
+		rwlock_unlock(&svc_lock);
 		return (false);
+	}
 	s->rec.sc_prog = (rpcprog_t) prog;
 	s->rec.sc_vers = (rpcvers_t) vers;
 	s->rec.sc_dispatch = dispatch;
+	s->rec.sc_netid = NULL;
+	s->rec.sc_procs = NULL;
 	s->sc_next = svc_head;
 	svc_head = s;
+	svc_dispatch_rebuild();
+	rwlock_unlock(&svc_lock);
 
  pmap_it:
 	/* now register the information with the local binder service */
@@ -457,15 +652,20 @@ svc_unregister(u_long prog, u_long vers)
 	struct svc_callout *prev;
 	struct svc_callout *s;
 
+	rwlock_wrlock(&svc_lock);
 	s = svc_find((rpcprog_t) prog, (rpcvers_t) vers, &prev, NULL);
-	if (!s)
+	if (!s) {
+		rwlock_unlock(&svc_lock);
 		return;
+	}
 	if (prev == NULL)
 		svc_head = s->sc_next;
 	else
 		prev->sc_next = s->sc_next;
 	s->sc_next = NULL;
 	mem_free(s, sizeof(struct svc_callout));
+	svc_dispatch_rebuild();
+	rwlock_unlock(&svc_lock);
 	/* now unregister the information with the local binder service */
 	(void)pmap_unset(prog, vers);
 }
@@ -495,15 +695,194 @@ svc_find(rpcprog_t prog, rpcvers_t vers,
 	return (s);
 }
 
-/* An exported search routing similar to svc_find, but with error reporting
- * needed by svc_getreq routines. */
-svc_lookup_result_t
-svc_lookup(svc_rec_t **rec, svc_vers_range_t *vrange,
-	   rpcprog_t prog, rpcvers_t vers, char *netid,
-	   u_int flags)
+static int
+svc_dispatch_rec_cmpf(const void *lhs, const void *rhs)
+{
+	const svc_rec_t *lk = lhs, *rk = rhs;
+
+	if (lk->sc_prog != rk->sc_prog)
+		return ((lk->sc_prog < rk->sc_prog) ? -1 : 1);
+	if (lk->sc_vers != rk->sc_vers)
+		return ((lk->sc_vers < rk->sc_vers) ? -1 : 1);
+	return (0);
+}
+
+/*
+ * Snapshot the callout list into a new dispatch index, and publish it.
+ * Called with svc_lock held for writing.
+ */
+static void
+svc_dispatch_rebuild(void)
+{
+	struct svc_dispatch_index *idx, *old;
+	struct svc_dispatch_prog *dp;
+	struct svc_callout *s;
+	svc_rec_t *rec;
+	size_t len, netid_len = 0;
+	uint32_t nrecs = 0, nprogs = 0, ix;
+	char *netid;
+
+	for (s = svc_head; s != NULL; s = s->sc_next) {
+		++nrecs;
+		if (s->rec.sc_netid)
+			netid_len += strlen(s->rec.sc_netid) + 1;
+	}
+
+	/* one block: header, programs, records, netids */
+	len = sizeof(struct svc_dispatch_index)
+	    + nrecs * sizeof(struct svc_dispatch_prog)
+	    + nrecs * sizeof(svc_rec_t)
+	    + netid_len;
+	idx = mem_zalloc(len);
+	if (idx) {
+		idx->progs = (struct svc_dispatch_prog *)(idx + 1);
+		idx->recs = (svc_rec_t *) (idx->progs + nrecs);
+		netid = (char *)(idx->recs + nrecs);
+
+		/* svc_head is newest first; keep oldest first among equals */
+		ix = nrecs;
+		for (s = svc_head; s != NULL; s = s->sc_next) {
+			rec = &idx->recs[--ix];
+			*rec = s->rec;
+			if (rec->sc_procs)
+				svc_proc_tbl_get(rec->sc_procs);
+			if (s->rec.sc_netid) {
+				len = strlen(s->rec.sc_netid) + 1;
+				memcpy(netid, s->rec.sc_netid, len);
+				rec->sc_netid = netid;
+				netid += len;
+			}
+		}
+		/* insertion sort is stable, and lists are short */
+		for (ix = 1; ix < nrecs; ++ix) {
+			svc_rec_t tmp = idx->recs[ix];
+			uint32_t jx = ix;
+
+			while (jx > 0
+			       && svc_dispatch_rec_cmpf(&idx->recs[jx - 1],
+							&tmp) > 0) {
+				idx->recs[jx] = idx->recs[jx - 1];
+				--jx;
+			}
+			idx->recs[jx] = tmp;
+		}
+
+		/* per-program record ranges and supported versions */
+		dp = NULL;
+		for (ix = 0; ix < nrecs; ++ix) {
+			rec = &idx->recs[ix];
+			if (!dp || dp->prog != rec->sc_prog) {
+				dp = &idx->progs[nprogs++];
+				dp->prog = rec->sc_prog;
+				dp->first = ix;
+				dp->vrange.lowvers = rec->sc_vers;
+			}
+			dp->vrange.highvers = rec->sc_vers;
+			++(dp->count);
+		}
+		idx->nprogs = nprogs;
+		idx->nrecs = nrecs;
+	} else {
+		__warnx(TIRPC_DEBUG_FLAG_SVC,
+			"%s: dispatch index alloc failed, using callout list",
+			__func__);
+	}
+
+	if (idx)
+		idx->refcnt = 1;
+	old = atomic_fetch_voidptr((void **)&svc_dispatch_index);
+	atomic_store_voidptr((void **)&svc_dispatch_index, idx);
+	svc_dispatch_retire(old);
+}
+
+static void
+svc_dispatch_free(struct svc_dispatch_index *idx)
+{
+	uint32_t ix;
+
+	for (ix = 0; ix < idx->nrecs; ++ix)
+		if (idx->recs[ix].sc_procs)
+			svc_proc_tbl_put(idx->recs[ix].sc_procs);
+	mem_free(idx, 0);
+}
+
+/* free retired snapshots no reader holds, or may still be taking */
+static void
+svc_dispatch_reclaim(void)
+{
+	struct svc_dispatch_index **idxp, *idx;
+
+	mutex_lock(&svc_dispatch_mtx);
+	idxp = &svc_dispatch_retired;
+	while (!atomic_fetch_uint32_t(&svc_dispatch_pinning)
+	       && (idx = *idxp) != NULL) {
+		if (atomic_fetch_int32_t(&idx->refcnt)) {
+			idxp = &idx->retired;
+			continue;
+		}
+		*idxp = idx->retired;
+		svc_dispatch_free(idx);
+	}
+	mutex_unlock(&svc_dispatch_mtx);
+}
+
+/* unpublished: drop the published reference, and free it if unused */
+static void
+svc_dispatch_retire(struct svc_dispatch_index *idx)
+{
+	if (!idx)
+		return;
+	mutex_lock(&svc_dispatch_mtx);
+	idx->retired = svc_dispatch_retired;
+	svc_dispatch_retired = idx;
+	mutex_unlock(&svc_dispatch_mtx);
+	(void)atomic_dec_int32_t(&idx->refcnt);
+	svc_dispatch_reclaim();
+}
+
+/*
+ * Pin the current dispatch index, if any.  Records found in it by
+ * svc_lookup() stay valid until svc_dispatch_put().
+ */
+struct svc_dispatch_index *
+svc_dispatch_get(void)
+{
+	struct svc_dispatch_index *idx;
+
+	atomic_inc_uint32_t(&svc_dispatch_pinning);
+	idx = atomic_fetch_voidptr((void **)&svc_dispatch_index);
+	if (idx)
+		atomic_inc_int32_t(&idx->refcnt);
+	atomic_dec_uint32_t(&svc_dispatch_pinning);
+	return (idx);
+}
+
+void
+svc_dispatch_put(struct svc_dispatch_index *idx)
+{
+	/* only a retired snapshot drops to zero */
+	if (idx && !atomic_dec_int32_t(&idx->refcnt))
+		svc_dispatch_reclaim();
+}
+
+static void
+svc_dispatch_shutdown(void)
+{
+	struct svc_dispatch_index *idx;
+
+	rwlock_wrlock(&svc_lock);
+	idx = atomic_fetch_voidptr((void **)&svc_dispatch_index);
+	atomic_store_voidptr((void **)&svc_dispatch_index, NULL);
+	svc_dispatch_retire(idx);
+	rwlock_unlock(&svc_lock);
+}
+
+/* The callout list walk, used only when there is no dispatch index. */
+static svc_lookup_result_t
+svc_lookup_list(svc_rec_t **rec, svc_vers_range_t *vrange,
+		rpcprog_t prog, rpcvers_t vers, char *netid)
 {
 	struct svc_callout *s, *p;
-	svc_lookup_result_t code = SVC_LKP_ERR;
 	bool prog_found, vers_found, netid_found;
 
 	p = NULL;
@@ -512,12 +891,12 @@ svc_lookup(svc_rec_t **rec, svc_vers_range_t *vrange,
 
 	for (s = svc_head; s != NULL; s = s->sc_next) {
 		if (s->rec.sc_prog == prog) {
-			prog_found = true;
 			/* track supported versions for SVC_LKP_VERS_NOTFOUND */
-			if (s->rec.sc_vers > vrange->highvers)
+			if (!prog_found || s->rec.sc_vers > vrange->highvers)
 				vrange->highvers = s->rec.sc_vers;
-			if (vrange->lowvers < s->rec.sc_vers)
+			if (!prog_found || s->rec.sc_vers < vrange->lowvers)
 				vrange->lowvers = s->rec.sc_vers;
+			prog_found = true;
 			/* vers match */
 			if (s->rec.sc_vers == vers) {
 				vers_found = true;
@@ -533,27 +912,73 @@ svc_lookup(svc_rec_t **rec, svc_vers_range_t *vrange,
 
 	if (p != NULL) {
 		*rec = &(p->rec);
-		code = SVC_LKP_SUCCESS;
-		goto out;
+		return (SVC_LKP_SUCCESS);
 	}
+	if (!prog_found)
+		return (SVC_LKP_PROG_NOTFOUND);
+	if (!vers_found)
+		return (SVC_LKP_VERS_NOTFOUND);
+	if ((netid != NULL) && (!netid_found))
+		return (SVC_LKP_NETID_NOTFOUND);
+	return (SVC_LKP_ERR);
+}
 
-	if (!prog_found) {
-		code = SVC_LKP_PROG_NOTFOUND;
-		goto out;
-	}
+/* An exported search routing similar to svc_find, but with error reporting
+ * needed by svc_getreq routines.  idx is from svc_dispatch_get(). */
+svc_lookup_result_t
+svc_lookup(struct svc_dispatch_index *idx, svc_rec_t **rec,
+	   svc_vers_range_t *vrange, rpcprog_t prog, rpcvers_t vers,
+	   char *netid, u_int flags)
+{
+	struct svc_dispatch_prog *dp;
+	svc_rec_t *r, *end;
+	uint32_t lo, hi, mid;
+	bool vers_found = false;
 
-	if (!vers_found) {
-		code = SVC_LKP_VERS_NOTFOUND;
-		goto out;
-	}
+	if (unlikely(!idx))
+		return (svc_lookup_list(rec, vrange, prog, vers, netid));
 
-	if ((netid != NULL) && (!netid_found)) {
-		code = SVC_LKP_NETID_NOTFOUND;
-		goto out;
+	vrange->lowvers = vrange->highvers = 0;
+
+	/* programs */
+	lo = 0;
+	hi = idx->nprogs;
+	dp = NULL;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (idx->progs[mid].prog < prog)
+			lo = mid + 1;
+		else if (idx->progs[mid].prog > prog)
+			hi = mid;
+		else {
+			dp = &idx->progs[mid];
+			break;
+		}
+	}
+	if (!dp)
+		return (SVC_LKP_PROG_NOTFOUND);
+
+	*vrange = dp->vrange;
+	if (vers < dp->vrange.lowvers || vers > dp->vrange.highvers)
+		return (SVC_LKP_VERS_NOTFOUND);
+
+	/* versions (few), then netid */
+	r = &idx->recs[dp->first];
+	for (end = r + dp->count; r < end && r->sc_vers <= vers; ++r) {
+		if (r->sc_vers != vers)
+			continue;
+		vers_found = true;
+		if ((netid == NULL) || (r->sc_netid == NULL)
+		    || (strcmp(netid, r->sc_netid) == 0)) {
+			*rec = r;
+			return (SVC_LKP_SUCCESS);
+		}
 	}
 
- out:
-	return (code);
+	if (!vers_found)
+		return (SVC_LKP_VERS_NOTFOUND);
+
+	return (SVC_LKP_NETID_NOTFOUND);
 }
 
 /* ******************* REPLY GENERATION ROUTINES  ************ */
@@ -860,6 +1285,34 @@ svc_validate_xprt_list(SVCXPRT *xprt)
 extern enum auth_stat
 svc_auth_authenticate(struct svc_req *, struct rpc_msg *, bool *);
 
+/* timed for the histograms and spans, when enabled */
+static inline void
+svc_rec_dispatch_timed(svc_rec_t *rec, struct svc_req *req, SVCXPRT *xprt)
+{
+	uint64_t span = tirpc_span_begin(req->rq_xid);
+
+	if (unlikely(req->rq_msg && req->rq_msg->rm_slow))
+		svc_slow_mark(req->rq_msg->rm_slow, SVC_SLOW_DISPATCHED);
+	if (unlikely(__svc_params->flags & SVC_FLAG_HISTOGRAMS)) {
+		uint64_t start = rpc_now_ns();
+
+		svc_hist_dispatch(rec, req);
+		svc_rec_dispatch(rec, req, xprt);
+		svc_hist_serviced(xprt, req, start);
+	} else
+		svc_rec_dispatch(rec, req, xprt);
+	TIRPC_SPAN_END(TIRPC_SPAN_DISPATCH, xprt, req->rq_xid, req->rq_proc,
+		       span);
+}
+
+/* drop what authentication holds for req, e.g. an interned credential */
+static inline void
+svc_req_auth_release(struct svc_req *req)
+{
+	if (req->rq_auth)
+		SVCAUTH_RELEASE(req->rq_auth, req);
+}
+
 void
 svc_dispatch_default(SVCXPRT *xprt, struct rpc_msg **ind_msg)
 {
@@ -868,29 +1321,42 @@ svc_dispatch_default(SVCXPRT *xprt, struct rpc_msg **ind_msg)
 	svc_vers_range_t vrange;
 	svc_lookup_result_t lkp_res;
 	svc_rec_t *svc_rec;
+	struct svc_dispatch_index *idx;
 	enum auth_stat why;
 	bool no_dispatch = false;
+	uint64_t span;
 
 	r.rq_xprt = xprt;
+	r.rq_msg = msg;
 	r.rq_prog = msg->rm_call.cb_prog;
 	r.rq_vers = msg->rm_call.cb_vers;
 	r.rq_proc = msg->rm_call.cb_proc;
 	r.rq_cred = msg->rm_call.cb_cred;
 	r.rq_xid = msg->rm_xid;
+	r.rq_auth = NULL;
 
 	/* first authenticate the message */
+	span = tirpc_span_begin(r.rq_xid);
 	why = svc_auth_authenticate(&r, msg, &no_dispatch);
+	TIRPC_TRACE(TIRPC_TRACE_AUTH, xprt, r.rq_xid, why);
+	TIRPC_SPAN_END(TIRPC_SPAN_AUTH, xprt, r.rq_xid, why, span);
 	if ((why != AUTH_OK) || no_dispatch) {
+		if (why != AUTH_OK)
+			svc_stats_add(SVC_STAT_AUTH_ERRORS, 1);
 		svcerr_auth(xprt, &r, why);
+		svc_req_auth_release(&r);
 		return;
 	}
 
-	lkp_res = svc_lookup(&svc_rec, &vrange, r.rq_prog, r.rq_vers, NULL, 0);
+	idx = svc_dispatch_get();
+	lkp_res = svc_lookup(idx, &svc_rec, &vrange, r.rq_prog, r.rq_vers,
+			     NULL, 0);
 	switch (lkp_res) {
 	case SVC_LKP_SUCCESS:
 		/* call it */
-		(*svc_rec->sc_dispatch) (&r, xprt);
-		return;
+		TIRPC_TRACE(TIRPC_TRACE_DISPATCH, xprt, r.rq_xid, r.rq_proc);
+		svc_rec_dispatch_timed(svc_rec, &r, xprt);
+		break;
 	case SVC_LKP_VERS_NOTFOUND:
 		svcerr_progvers(xprt, &r, vrange.lowvers, vrange.highvers);
 		break;
@@ -898,6 +1364,8 @@ svc_dispatch_default(SVCXPRT *xprt, struct rpc_msg **ind_msg)
 		svcerr_noprog(xprt, &r);
 		break;
 	}
+	svc_dispatch_put(idx);
+	svc_req_auth_release(&r);
 }
 
 bool
@@ -917,23 +1385,34 @@ svc_getreq_default(SVCXPRT *xprt)
 			svc_vers_range_t vrange;
 			svc_lookup_result_t lkp_res;
 			svc_rec_t *svc_rec;
+			struct svc_dispatch_index *idx;
 			enum auth_stat why;
+			uint64_t span = tirpc_span_begin(req.rq_xid);
 
 			/* first authenticate the message */
 			why =
 			    svc_auth_authenticate(&req, req.rq_msg,
 						  &no_dispatch);
+			TIRPC_TRACE(TIRPC_TRACE_AUTH, xprt, req.rq_xid, why);
+			TIRPC_SPAN_END(TIRPC_SPAN_AUTH, xprt, req.rq_xid, why,
+				       span);
 			if ((why != AUTH_OK) || no_dispatch) {
+				if (why != AUTH_OK)
+					svc_stats_add(SVC_STAT_AUTH_ERRORS, 1);
 				svcerr_auth(xprt, &req, why);
 				goto call_done;
 			}
 
+			idx = svc_dispatch_get();
 			lkp_res =
-			    svc_lookup(&svc_rec, &vrange, req.rq_prog,
+			    svc_lookup(idx, &svc_rec, &vrange, req.rq_prog,
 				       req.rq_vers, NULL, 0);
 			switch (lkp_res) {
 			case SVC_LKP_SUCCESS:
-				(*svc_rec->sc_dispatch) (&req, xprt);
+				TIRPC_TRACE(TIRPC_TRACE_DISPATCH, xprt,
+					    req.rq_xid, req.rq_proc);
+				svc_rec_dispatch_timed(svc_rec, &req, xprt);
+				svc_dispatch_put(idx);
 				goto call_done;
 				break;
 			case SVC_LKP_VERS_NOTFOUND:
@@ -950,6 +1429,7 @@ svc_getreq_default(SVCXPRT *xprt)
 				svcerr_noprog(xprt, &req);
 				break;
 			}
+			svc_dispatch_put(idx);
 
 			/* dispose RPC header */
 			free_req_rpc_msg(&req);
@@ -958,7 +1438,8 @@ svc_getreq_default(SVCXPRT *xprt)
 		/* SVC_RECV again? */
  call_done:
 
-		/* dispose RPC header */
+		/* dispose credential and RPC header */
+		svc_req_auth_release(&req);
 		free_req_rpc_msg(&req); /* SAFE */
 
 		stat = SVC_STAT(xprt);
@@ -1065,6 +1546,9 @@ svc_shutdown(u_long flags)
 {
 	int code = 0;
 
+	/* stop serving snapshots first, they walk the xprts */
+	svc_stats_shutdown();
+
 #ifdef USE_RPC_RDMA
 	/* wait until RDMA control threads have finished */
 	rpc_rdma_internals_fini();
@@ -1073,6 +1557,12 @@ svc_shutdown(u_long flags)
 	/* finalize ioq */
 	work_pool_shutdown(&svc_work_pool);
 
+	/* release dispatch index snapshots */
+	svc_dispatch_shutdown();
+	svc_hist_shutdown();
+	svc_slow_shutdown();
+	svc_mem_shutdown();
+
 	/* dispose all xprts and support */
 	svc_xprt_shutdown();
 
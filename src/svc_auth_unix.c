@@ -32,7 +32,7 @@
  * There are two svc auth implementations here: AUTH_UNIX and AUTH_SHORT.
  * _svcauth_unix does full blown unix style uid,gid+gids auth,
  * _svcauth_short uses a shorthand auth to index into a cache of longhand auths.
- * Note: the shorthand has been gutted for efficiency.
+ * Shorthands are only issued with SVC_INIT_AUTHUNIX_SHORT.
  *
  * Copyright (C) 1984, Sun Microsystems, Inc.
  */
@@ -46,39 +46,73 @@
 #include <rpc/svc.h>
 #include <rpc/svc_auth.h>
 
+#include "svc_internal.h"
+#include "authunix_internal.h"
+
 extern SVCAUTH svc_auth_none;
 
+static bool svcauth_unix_wrap(SVCAUTH *, struct svc_req *, XDR *, xdrproc_t,
+			      caddr_t);
+static bool svcauth_unix_release(SVCAUTH *, struct svc_req *);
+static bool svcauth_unix_destroy(SVCAUTH *);
+
+static struct svc_auth_ops svc_auth_unix_ops = {
+	svcauth_unix_wrap,
+	svcauth_unix_wrap,
+	svcauth_unix_release,
+	svcauth_unix_destroy
+};
+
+/* installed when rq_clntcred references an interned credential */
+static SVCAUTH svc_auth_unix = {
+	&svc_auth_unix_ops,
+	NULL,
+};
+
+/* aka, unwrap */
+static bool
+svcauth_unix_wrap(SVCAUTH * __attribute__ ((unused)) auth,
+		  struct svc_req * __attribute__ ((unused)) req, XDR *xdrs,
+		  xdrproc_t xdr_func, caddr_t xdr_ptr)
+{
+	return ((*xdr_func) (xdrs, xdr_ptr));
+}
+
+static bool
+svcauth_unix_release(SVCAUTH * __attribute__ ((unused)) auth,
+		     struct svc_req *req)
+{
+	struct svc_rpc_unix_cred *uc = req->rq_ap1;
+
+	req->rq_auth = &svc_auth_none;
+	req->rq_ap1 = NULL;
+	req->rq_clntcred = NULL;
+	if (uc)
+		authunix_cred_unref(uc);
+	return (true);
+}
+
+static bool
+svcauth_unix_destroy(SVCAUTH *auth)
+{
+	return (true);
+}
+
 /*
- * Unix longhand authenticator
+ * Decode the AUTH_SYS body into aup, whose aup_machname and aup_gids
+ * must already point to MAX_MACHINE_NAME + 1 and NGRPS sized storage.
  */
 enum auth_stat
-_svcauth_unix(struct svc_req *req, struct rpc_msg *msg)
+svcauth_unix_decode(struct authunix_parms *aup, caddr_t oa_base,
+		    u_int auth_len)
 {
-	enum auth_stat stat;
+	enum auth_stat stat = AUTH_OK;
 	XDR xdrs;
-	struct authunix_parms *aup;
 	int32_t *buf;
-	struct area {
-		struct authunix_parms area_aup;
-		char area_machname[MAX_MACHINE_NAME + 1];
-		gid_t area_gids[NGRPS];
-	} *area;
-	u_int auth_len;
 	size_t str_len, gid_len;
 	u_int i;
 
-	assert(req != NULL);
-	assert(msg != NULL);
-
-	req->rq_auth = &svc_auth_none;
-
-	area = (struct area *)req->rq_clntcred;
-	aup = &area->area_aup;
-	aup->aup_machname = area->area_machname;
-	aup->aup_gids = area->area_gids;
-	auth_len = (u_int) msg->rm_call.cb_cred.oa_length;
-	xdrmem_create(&xdrs, msg->rm_call.cb_cred.oa_base, auth_len,
-		      XDR_DECODE);
+	xdrmem_create(&xdrs, oa_base, auth_len, XDR_DECODE);
 	buf = XDR_INLINE(&xdrs, auth_len);
 	if (buf != NULL) {
 		aup->aup_time = IXDR_GET_INT32(buf);
@@ -120,6 +154,90 @@ _svcauth_unix(struct svc_req *req, struct rpc_msg *msg)
 		stat = AUTH_BADCRED;
 		goto done;
 	}
+ done:
+	XDR_DESTROY(&xdrs);
+
+	return (stat);
+}
+
+/*
+ * Encode an AUTH_SHORT response verifier (struct short_hand_verf) for
+ * the interned credential of req.  The cooked credential area in msg is
+ * unused when credentials are interned, and lives until the reply is
+ * encoded, so the verifier body is marshalled there.
+ */
+static bool
+svcauth_unix_short_verf(struct svc_req *req, struct rpc_msg *msg)
+{
+	struct short_hand_verf shv;
+	uint64_t handle;
+	XDR xdrs;
+	bool rslt;
+
+	if (!authunix_short_issue(req->rq_ap1, &handle))
+		return (false);
+
+	shv.new_cred.oa_flavor = AUTH_SHORT;
+	shv.new_cred.oa_base = (caddr_t) &handle;
+	shv.new_cred.oa_length = sizeof(handle);
+
+	xdrmem_create(&xdrs, msg->rq_cred_body, MAX_AUTH_BYTES, XDR_ENCODE);
+	rslt = xdr_opaque_auth(&xdrs, &shv.new_cred);
+	if (rslt) {
+		req->rq_verf.oa_flavor = AUTH_SHORT;
+		req->rq_verf.oa_base = msg->rq_cred_body;
+		req->rq_verf.oa_length = XDR_GETPOS(&xdrs);
+	}
+	XDR_DESTROY(&xdrs);
+
+	return (rslt);
+}
+
+/*
+ * Unix longhand authenticator
+ */
+enum auth_stat
+_svcauth_unix(struct svc_req *req, struct rpc_msg *msg)
+{
+	enum auth_stat stat;
+	struct svc_rpc_unix_cred *uc;
+	struct authunix_parms *aup;
+	struct area {
+		struct authunix_parms area_aup;
+		char area_machname[MAX_MACHINE_NAME + 1];
+		gid_t area_gids[NGRPS];
+	} *area;
+
+	assert(req != NULL);
+	assert(msg != NULL);
+
+	req->rq_auth = &svc_auth_none;
+
+	if (__svc_params->flags & SVC_FLAG_AUTHUNIX_CACHE) {
+		/* decoded once per distinct credential */
+		uc = authunix_cred_hash_get(msg->rm_call.cb_cred.oa_base,
+					    msg->rm_call.cb_cred.oa_length);
+		if (!uc)
+			return (AUTH_BADCRED);
+		req->rq_clntcred = &uc->aup;
+		req->rq_ap1 = uc;
+		req->rq_auth = &svc_auth_unix;
+	} else {
+		area = (struct area *)req->rq_clntcred;
+		aup = &area->area_aup;
+		aup->aup_machname = area->area_machname;
+		aup->aup_gids = area->area_gids;
+		stat = svcauth_unix_decode(aup, msg->rm_call.cb_cred.oa_base,
+					   msg->rm_call.cb_cred.oa_length);
+		if (stat != AUTH_OK)
+			return (stat);
+	}
+
+	/* offer a shorthand for this credential */
+	if ((__svc_params->flags & SVC_FLAG_AUTHUNIX_SHORT)
+	    && msg->rm_call.cb_verf.oa_flavor == AUTH_NULL
+	    && svcauth_unix_short_verf(req, msg))
+		return (AUTH_OK);
 
 	/* get the verifier */
 	if ((u_int) msg->rm_call.cb_verf.oa_length) {
@@ -130,11 +248,42 @@ _svcauth_unix(struct svc_req *req, struct rpc_msg *msg)
 		req->rq_verf.oa_flavor = AUTH_NULL;
 		req->rq_verf.oa_length = 0;
 	}
-	stat = AUTH_OK;
- done:
-	XDR_DESTROY(&xdrs);
 
-	return (stat);
+	return (AUTH_OK);
+}
+
+/*
+ * Application data attached to an interned AUTH_SYS credential, e.g.
+ * the result of identity mapping.  NULL if none was attached, or the
+ * request credential is not interned.
+ */
+void *
+svcauth_unix_get_private(struct svc_req *req)
+{
+	struct svc_rpc_unix_cred *uc;
+
+	if (req->rq_auth != &svc_auth_unix)
+		return (NULL);
+	uc = req->rq_ap1;
+	return (atomic_fetch_voidptr(&uc->priv));
+}
+
+/*
+ * Attach application data to the interned credential of req.  The
+ * first caller wins; priv_free (may be NULL) is called when the
+ * credential is finally released.  Returns false if priv was not
+ * attached, in which case the caller retains ownership of it.
+ */
+bool
+svcauth_unix_set_private(struct svc_req *req, void *priv,
+			 void (*priv_free) (void *))
+{
+	bool set = false;
+
+	if (req->rq_auth != &svc_auth_unix)
+		return (false);
+	authunix_cred_set_private(req->rq_ap1, priv, priv_free, &set);
+	return (set);
 }
 
 /*
@@ -145,6 +294,27 @@ _svcauth_unix(struct svc_req *req, struct rpc_msg *msg)
 enum auth_stat
 _svcauth_short(struct svc_req *req, struct rpc_msg *msg)
 {
+	struct svc_rpc_unix_cred *uc;
+	uint64_t handle;
+
 	req->rq_auth = &svc_auth_none;
-	return (AUTH_REJECTEDCRED);
+
+	/* unknown or expired shorthand; the client falls back to AUTH_SYS */
+	if (!(__svc_params->flags & SVC_FLAG_AUTHUNIX_SHORT)
+	    || msg->rm_call.cb_cred.oa_length != sizeof(handle))
+		return (AUTH_REJECTEDCRED);
+
+	memcpy(&handle, msg->rm_call.cb_cred.oa_base, sizeof(handle));
+	uc = authunix_short_get(handle);
+	if (!uc)
+		return (AUTH_REJECTEDCRED);
+
+	req->rq_clntcred = &uc->aup;
+	req->rq_ap1 = uc;
+	req->rq_auth = &svc_auth_unix;
+
+	req->rq_verf.oa_flavor = AUTH_NULL;
+	req->rq_verf.oa_length = 0;
+
+	return (AUTH_OK);
 }
@@ -58,12 +58,17 @@
 
 #include "rpc_com.h"
 #include "svc_internal.h"
+#include "rpc_ring.h"
 #include "clnt_internal.h"
 #include "svc_xprt.h"
 #include "rpc_dplx_internal.h"
 #include <rpc/svc_rqst.h>
 #include <misc/city.h>
 #include <rpc/rpc_cksum.h>
+#include <rpc/trace.h>
+#include <rpc/span.h>
+#include <rpc/svc_slow.h>
+#include <rpc/svc_mem.h>
 
 extern tirpc_pkg_params __ntirpc_pkg_params;
 extern struct svc_params __svc_params[1];
@@ -253,6 +258,10 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 	struct iovec iov;
 	size_t replylen;
 	ssize_t rlen;
+	uint64_t span = 0;
+
+	if (unlikely(__ntirpc_span_rate))
+		span = rpc_now_ns();
 
 	memset(&ss, 0xff, sizeof(struct sockaddr_storage));
 
@@ -280,8 +289,12 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 
 	if (rlen == -1 && errno == EINTR)
 		goto again;
-	if (rlen == -1 || (rlen < (ssize_t) (4 * sizeof(u_int32_t))))
+	if (rlen == -1 || (rlen < (ssize_t) (4 * sizeof(u_int32_t)))) {
+		svc_stats_add(SVC_STAT_RECV_ERRORS, 1);
 		return (false);
+	}
+	TIRPC_TRACE(TIRPC_TRACE_RECV, xprt, 0, rlen);
+	svc_stats_add(SVC_STAT_RX_BYTES, rlen);
 
 	__rpc_set_address(&xprt->xp_remote, &ss, mesgp->msg_namelen);
 
@@ -295,8 +308,10 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 
 	xdrs->x_op = XDR_DECODE;
 	XDR_SETPOS(xdrs, 0);
-	if (!xdr_callmsg(xdrs, req->rq_msg))
+	if (!xdr_callmsg(xdrs, req->rq_msg)) {
+		svc_stats_add(SVC_STAT_RECV_ERRORS, 1);
 		return (false);
+	}
 
 	req->rq_xprt = xprt;
 	req->rq_prog = req->rq_msg->rm_call.cb_prog;
@@ -304,6 +319,15 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 	req->rq_proc = req->rq_msg->rm_call.cb_proc;
 	req->rq_xid = req->rq_msg->rm_xid;
 	req->rq_clntcred = req->rq_msg->rq_cred_body;
+	TIRPC_TRACE(TIRPC_TRACE_DECODE, xprt, req->rq_xid, req->rq_proc);
+	if (unlikely(span) && tirpc_span_sampled(req->rq_xid))
+		TIRPC_SPAN_END(TIRPC_SPAN_RECEIVE, xprt, req->rq_xid,
+			       req->rq_proc, span);
+	svc_stats_add(SVC_STAT_REQUESTS, 1);
+	if (unlikely(__svc_params->flags & SVC_FLAG_SLOW_REQUESTS))
+		svc_slow_start(xprt, req);
+	if (unlikely(__svc_params->flags & SVC_FLAG_HISTOGRAMS))
+		svc_hist_received(xprt, req);
 
 	/* save remote address */
 	req->rq_raddr_len = xprt->xp_remote.nb.len;
@@ -321,6 +345,7 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 	su->su_xid = req->rq_msg->rm_xid;
 	if (su->su_cache != NULL) {
 		if (svc_dg_cache_get(xprt, req->rq_msg, &reply, &replylen)) {
+			svc_stats_add(SVC_STAT_DRC_HITS, 1);
 			iov.iov_base = reply;
 			iov.iov_len = replylen;
 
@@ -341,6 +366,7 @@ svc_dg_recv(SVCXPRT *xprt, struct svc_req *req)
 			(void)sendmsg(xprt->xp_fd, mesgp, 0);
 			return (false);
 		}
+		svc_stats_add(SVC_STAT_DRC_MISSES, 1);
 	}
 	return (true);
 }
@@ -356,6 +382,12 @@ svc_dg_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 	xdrproc_t xdr_results;
 	caddr_t xdr_location;
 	bool has_args;
+	uint64_t start = 0;
+	uint64_t span = tirpc_span_begin(req->rq_xid);
+	uint32_t slow = req->rq_msg ? req->rq_msg->rm_slow : 0;
+
+	if (unlikely(__svc_params->flags & SVC_FLAG_HISTOGRAMS))
+		start = rpc_now_ns();
 
 	if (msg->rm_reply.rp_stat == MSG_ACCEPTED
 	    && msg->rm_reply.rp_acpt.ar_stat == SUCCESS) {
@@ -397,11 +429,30 @@ svc_dg_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 			msg->msg_controllen = CMSG_ALIGN(cmsg->cmsg_len);
 		}
 
+		TIRPC_TRACE(TIRPC_TRACE_REPLY, xprt, req->rq_xid, true);
+		TIRPC_SPAN_END(TIRPC_SPAN_REPLY, xprt, req->rq_xid, true, span);
+		if (unlikely(span))
+			span = rpc_now_ns();
+		if (unlikely(slow))
+			svc_slow_mark(slow, SVC_SLOW_REPLIED);
 		if (sendmsg(xprt->xp_fd, msg, 0) == (ssize_t) slen) {
+			TIRPC_TRACE(TIRPC_TRACE_FLUSH, xprt, 0, slen);
+			TIRPC_SPAN_END(TIRPC_SPAN_FLUSH, xprt, req->rq_xid, 0,
+				       span);
+			if (unlikely(slow))
+				svc_slow_mark(slow, SVC_SLOW_FLUSHED);
+			svc_stats_add(SVC_STAT_TX_BYTES, slen);
+			if (start)
+				svc_hist_sent(xprt, req, start);
 			stat = true;
 			if (su->su_cache)
 				svc_dg_cache_set(xprt, slen);
-		}
+		} else
+			svc_stats_add(SVC_STAT_SEND_ERRORS, 1);
+	}
+	if (unlikely(slow)) {
+		req->rq_msg->rm_slow = 0;
+		svc_slow_end(slow);
 	}
 	return (stat);
 }
@@ -481,6 +532,7 @@ svc_dg_destroy(SVCXPRT *xprt, u_int flags, const char *tag, const int line)
 	if (xprt->blkin.svc_name)
 		mem_free(xprt->blkin.svc_name, 2*INET6_ADDRSTRLEN);
 #endif
+	svc_hist_xprt_destroy(xprt);
 	(void)mem_free(xprt, sizeof(SVCXPRT));
 }
 
@@ -687,6 +739,9 @@ svc_dg_cache_set(SVCXPRT *xprt, size_t replylen)
 			mutex_unlock(&dupreq_lock);
 			return;
 		}
+		/* entries are reused, never freed */
+		svc_mem_add(SVC_MEM_DRC,
+			    sizeof(struct cache_node) + su->su_iosz);
 	}
 
 	/*
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * svc_hist.c
+ * Latency histograms per transport and per procedure.
+ *
+ * Each recording thread claims one of SVC_HIST_THREADS slots, and has a
+ * shard of its own in every histogram set it records into, allocated on
+ * first use.  Only the owner writes a shard, with plain stores; readers
+ * sum the shards.  Threads past the last slot share one more shard, with
+ * atomic adds.  Procedure histograms are found in a hash table that is
+ * only ever added to, so lookups take no lock.  A procedure gets one
+ * only once its service is found registered, and at most
+ * SVC_HIST_PROCS_MAX are kept; others are recorded per transport only.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/svc_hist.h>
+#include <rpc/xdr_ioq.h>
+#include <misc/abstract_atomic.h>
+
+#include "svc_internal.h"
+#include "rpc_ring.h"
+
+#define SVC_HIST_THREADS 64	/* slots, bits of svc_hist_slots */
+#define SVC_HIST_SHARED SVC_HIST_THREADS
+#define SVC_HIST_PROC_HASH 1024
+#define SVC_HIST_PROCS_MAX 1024
+
+struct svc_hist_shard {
+	struct {
+		uint64_t count;
+		uint64_t sum;
+		uint64_t bucket[SVC_HIST_BUCKETS];
+	} kind[SVC_HIST_KINDS];
+};
+
+struct svc_hist_set {
+	struct svc_hist_shard *shard[SVC_HIST_THREADS + 1];
+};
+
+struct svc_hist_proc {
+	struct svc_hist_proc *next;
+	rpcprog_t prog;
+	rpcvers_t vers;
+	rpcproc_t proc;
+	struct svc_hist_set set;
+};
+
+static mutex_t svc_hist_mtx = MUTEX_INITIALIZER;
+static struct svc_hist_proc *svc_hist_procs[SVC_HIST_PROC_HASH];
+static u_int svc_hist_nprocs;	/* under svc_hist_mtx */
+static uint64_t svc_hist_slots;	/* claimed by live threads */
+static __thread uint32_t svc_hist_slot = UINT32_MAX;
+static pthread_key_t svc_hist_key;
+static pthread_once_t svc_hist_once = PTHREAD_ONCE_INIT;
+
+static inline u_int
+svc_hist_index(uint64_t usec)
+{
+	u_int msb;
+
+	if (usec < 4)
+		return (usec);
+	msb = 63 - __builtin_clzll(usec);
+	if (msb > SVC_HIST_BUCKETS / 4)
+		return (SVC_HIST_BUCKETS - 1);
+	return (4 * (msb - 1) + ((usec >> (msb - 2)) & 3));
+}
+
+uint64_t
+svc_hist_bucket_usec(u_int ix)
+{
+	if (ix < 4)
+		return (ix);
+	return ((uint64_t)(4 + (ix & 3)) << (ix / 4 - 1));
+}
+
+uint64_t
+svc_hist_percentile(const struct svc_hist *hist, double pct)
+{
+	uint64_t want = hist->count * pct / 100;
+	uint64_t seen = 0;
+	u_int ix;
+
+	for (ix = 0; ix < SVC_HIST_BUCKETS; ++ix) {
+		seen += hist->bucket[ix];
+		if (seen > want || (seen == hist->count && seen))
+			return (svc_hist_bucket_usec(ix));
+	}
+	return (0);
+}
+
+/* thread exit, the slot's shards pass to the next thread claiming it */
+static void
+svc_hist_slot_release(void *arg)
+{
+	uint32_t slot = (uintptr_t)arg - 1;
+
+	(void)__sync_fetch_and_and(&svc_hist_slots, ~(1ULL << slot));
+}
+
+static void
+svc_hist_key_init(void)
+{
+	(void)pthread_key_create(&svc_hist_key, svc_hist_slot_release);
+}
+
+static uint32_t
+svc_hist_slot_claim(void)
+{
+	uint64_t slots;
+	uint32_t slot;
+
+	(void)pthread_once(&svc_hist_once, svc_hist_key_init);
+	do {
+		slots = atomic_fetch_uint64_t(&svc_hist_slots);
+		if (!~slots)
+			return (SVC_HIST_SHARED);
+		slot = __builtin_ctzll(~slots);
+	} while (!__sync_bool_compare_and_swap(&svc_hist_slots, slots,
+					       slots | (1ULL << slot)));
+
+	if (pthread_setspecific(svc_hist_key, (void *)(uintptr_t)(slot + 1))) {
+		svc_hist_slot_release((void *)(uintptr_t)(slot + 1));
+		return (SVC_HIST_SHARED);
+	}
+	return (slot);
+}
+
+/* only the owning thread writes, so no read-modify-write is needed */
+static inline void
+svc_hist_bump(uint64_t *var, uint64_t n, bool shared)
+{
+	if (unlikely(shared))
+		(void)atomic_add_uint64_t(var, n);
+	else
+		__atomic_store_n(var, __atomic_load_n(var, __ATOMIC_RELAXED)
+				 + n, __ATOMIC_RELAXED);
+}
+
+static void
+svc_hist_add(struct svc_hist_set *set, enum svc_hist_kind kind,
+	     uint64_t nsec)
+{
+	struct svc_hist_shard *shard;
+	uint64_t usec = nsec / 1000;
+	bool shared;
+
+	if (unlikely(svc_hist_slot == UINT32_MAX))
+		svc_hist_slot = svc_hist_slot_claim();
+	shared = (svc_hist_slot == SVC_HIST_SHARED);
+
+	shard = atomic_fetch_voidptr((void **)&set->shard[svc_hist_slot]);
+	if (unlikely(!shard)) {
+		shard = mem_zalloc(sizeof(struct svc_hist_shard));
+		if (!shard)
+			return;
+		if (!__sync_bool_compare_and_swap(&set->shard[svc_hist_slot],
+						  NULL, shard)) {
+			mem_free(shard, sizeof(struct svc_hist_shard));
+			shard = set->shard[svc_hist_slot];
+		}
+	}
+
+	svc_hist_bump(&shard->kind[kind].count, 1, shared);
+	svc_hist_bump(&shard->kind[kind].sum, usec, shared);
+	svc_hist_bump(&shard->kind[kind].bucket[svc_hist_index(usec)], 1,
+		      shared);
+}
+
+static void
+svc_hist_merge(struct svc_hist_set *set, enum svc_hist_kind kind,
+	       struct svc_hist *hist)
+{
+	struct svc_hist_shard *shard;
+	u_int sx, ix;
+
+	memset(hist, 0, sizeof(*hist));
+	for (sx = 0; sx <= SVC_HIST_THREADS; ++sx) {
+		shard = atomic_fetch_voidptr((void **)&set->shard[sx]);
+		if (!shard)
+			continue;
+		hist->count += atomic_fetch_uint64_t(&shard->kind[kind].count);
+		hist->sum += atomic_fetch_uint64_t(&shard->kind[kind].sum);
+		for (ix = 0; ix < SVC_HIST_BUCKETS; ++ix)
+			hist->bucket[ix] += atomic_fetch_uint64_t(
+				&shard->kind[kind].bucket[ix]);
+	}
+}
+
+static void
+svc_hist_set_free(struct svc_hist_set *set)
+{
+	u_int sx;
+
+	for (sx = 0; sx <= SVC_HIST_THREADS; ++sx) {
+		if (set->shard[sx])
+			mem_free(set->shard[sx], sizeof(struct svc_hist_shard));
+	}
+}
+
+static struct svc_hist_set *
+svc_hist_xprt(SVCXPRT *xprt)
+{
+	struct svc_hist_set *set = atomic_fetch_voidptr((void **)&xprt->xp_hist);
+
+	if (likely(set))
+		return (set);
+	if (!(__svc_params->flags & SVC_FLAG_HISTOGRAMS))
+		return (NULL);
+
+	set = mem_zalloc(sizeof(struct svc_hist_set));
+	if (!set)
+		return (NULL);
+	if (!__sync_bool_compare_and_swap(&xprt->xp_hist, NULL, set)) {
+		mem_free(set, sizeof(struct svc_hist_set));
+		set = xprt->xp_hist;
+	}
+	return (set);
+}
+
+static inline u_int
+svc_hist_proc_hash(rpcprog_t prog, rpcvers_t vers, rpcproc_t proc)
+{
+	return ((prog * 31 + vers) * 31 + proc) % SVC_HIST_PROC_HASH;
+}
+
+static struct svc_hist_proc *
+svc_hist_proc_lookup(rpcprog_t prog, rpcvers_t vers, rpcproc_t proc)
+{
+	struct svc_hist_proc *hp;
+
+	hp = atomic_fetch_voidptr((void **)
+		&svc_hist_procs[svc_hist_proc_hash(prog, vers, proc)]);
+	for (; hp; hp = hp->next) {
+		if (hp->prog == prog && hp->vers == vers && hp->proc == proc)
+			return (hp);
+	}
+	return (NULL);
+}
+
+static struct svc_hist_set *
+svc_hist_proc(rpcprog_t prog, rpcvers_t vers, rpcproc_t proc)
+{
+	struct svc_hist_proc *hp = svc_hist_proc_lookup(prog, vers, proc);
+	u_int ix;
+
+	if (likely(hp))
+		return (&hp->set);
+
+	mutex_lock(&svc_hist_mtx);
+	hp = svc_hist_proc_lookup(prog, vers, proc);
+	if (!hp && svc_hist_nprocs < SVC_HIST_PROCS_MAX) {
+		hp = mem_zalloc(sizeof(struct svc_hist_proc));
+		if (hp) {
+			svc_hist_nprocs++;
+			ix = svc_hist_proc_hash(prog, vers, proc);
+			hp->prog = prog;
+			hp->vers = vers;
+			hp->proc = proc;
+			hp->next = svc_hist_procs[ix];
+			atomic_store_voidptr((void **)&svc_hist_procs[ix], hp);
+		}
+	}
+	mutex_unlock(&svc_hist_mtx);
+	return (hp ? &hp->set : NULL);
+}
+
+static void
+svc_hist_record(SVCXPRT *xprt, struct svc_req *req, enum svc_hist_kind kind,
+		uint64_t nsec)
+{
+	struct svc_hist_set *set;
+
+	set = svc_hist_xprt(xprt);
+	if (set)
+		svc_hist_add(set, kind, nsec);
+	set = req->rq_msg ? req->rq_msg->rm_hist : NULL;
+	if (set)
+		svc_hist_add(set, kind, nsec);
+}
+
+/* called by the event channel, before xp_getreq */
+void
+svc_hist_wakeup(SVCXPRT *xprt)
+{
+	xprt->xp_wakeup = rpc_now_ns();
+}
+
+/*
+ * called with each decoded call, the first after a wakeup is timed.  The
+ * call header is not validated yet, so only the transport records it.
+ */
+void
+svc_hist_received(SVCXPRT *xprt, struct svc_req *req)
+{
+	uint64_t wakeup = xprt->xp_wakeup;
+	struct svc_hist_set *set;
+
+	req->rq_msg->rm_hist = NULL;
+	req->rq_msg->rm_queued = 0;
+	if (!wakeup)
+		return;
+	xprt->xp_wakeup = 0;
+	req->rq_msg->rm_queued = rpc_now_ns() - wakeup;
+	set = svc_hist_xprt(xprt);
+	if (set)
+		svc_hist_add(set, SVC_HIST_QUEUE, req->rq_msg->rm_queued);
+}
+
+/* called once svc_lookup() has found the service, before dispatch */
+void
+svc_hist_dispatch(svc_rec_t *rec, struct svc_req *req)
+{
+	struct rpc_msg *msg = req->rq_msg;
+	struct svc_hist_set *set;
+
+	if (!msg
+	    || (rec->sc_procs && !svc_proc_tbl_has(rec->sc_procs,
+						   req->rq_proc)))
+		return;
+	set = svc_hist_proc(req->rq_prog, req->rq_vers, req->rq_proc);
+	msg->rm_hist = set;
+	if (set && msg->rm_queued)
+		svc_hist_add(set, SVC_HIST_QUEUE, msg->rm_queued);
+}
+
+void
+svc_hist_serviced(SVCXPRT *xprt, struct svc_req *req, uint64_t start)
+{
+	svc_hist_record(xprt, req, SVC_HIST_SERVICE, rpc_now_ns() - start);
+}
+
+/* datagram replies are sent at once */
+void
+svc_hist_sent(SVCXPRT *xprt, struct svc_req *req, uint64_t start)
+{
+	svc_hist_record(xprt, req, SVC_HIST_FLUSH, rpc_now_ns() - start);
+}
+
+/* stamps the reply stream, so svc_hist_flushed() can find the procedure */
+void
+svc_hist_enqueued(struct svc_req *req, XDR *xdrs)
+{
+	struct xdr_ioq *xioq = XIOQ(xdrs);
+
+	xioq->ioq_hist = req->rq_msg ? req->rq_msg->rm_hist : NULL;
+	xioq->ioq_ts = rpc_now_ns();
+}
+
+void
+svc_hist_flushed(SVCXPRT *xprt, struct xdr_ioq *xioq)
+{
+	struct svc_hist_set *set;
+	uint64_t nsec;
+
+	if (!xioq->ioq_ts)
+		return;
+	nsec = rpc_now_ns() - xioq->ioq_ts;
+	set = svc_hist_xprt(xprt);
+	if (set)
+		svc_hist_add(set, SVC_HIST_FLUSH, nsec);
+	if (xioq->ioq_hist)
+		svc_hist_add(xioq->ioq_hist, SVC_HIST_FLUSH, nsec);
+}
+
+void
+svc_hist_xprt_destroy(SVCXPRT *xprt)
+{
+	if (xprt->xp_hist) {
+		svc_hist_set_free(xprt->xp_hist);
+		mem_free(xprt->xp_hist, sizeof(struct svc_hist_set));
+		xprt->xp_hist = NULL;
+	}
+}
+
+void
+svc_hist_shutdown(void)
+{
+	struct svc_hist_proc *hp;
+	u_int ix;
+
+	mutex_lock(&svc_hist_mtx);
+	svc_hist_nprocs = 0;
+	for (ix = 0; ix < SVC_HIST_PROC_HASH; ++ix) {
+		while ((hp = svc_hist_procs[ix])) {
+			svc_hist_procs[ix] = hp->next;
+			svc_hist_set_free(&hp->set);
+			mem_free(hp, sizeof(struct svc_hist_proc));
+		}
+	}
+	mutex_unlock(&svc_hist_mtx);
+}
+
+bool
+svc_hist_xprt_get(SVCXPRT *xprt, enum svc_hist_kind kind,
+		  struct svc_hist *hist)
+{
+	struct svc_hist_set *set = atomic_fetch_voidptr((void **)&xprt->xp_hist);
+
+	if (!set || kind >= SVC_HIST_KINDS)
+		return (false);
+	svc_hist_merge(set, kind, hist);
+	return (true);
+}
+
+bool
+svc_hist_proc_get(const rpcprog_t prog, const rpcvers_t vers,
+		  const rpcproc_t proc, enum svc_hist_kind kind,
+		  struct svc_hist *hist)
+{
+	struct svc_hist_proc *hp = svc_hist_proc_lookup(prog, vers, proc);
+
+	if (!hp || kind >= SVC_HIST_KINDS)
+		return (false);
+	svc_hist_merge(&hp->set, kind, hist);
+	return (true);
+}
@@ -27,6 +27,7 @@
 #define TIRPC_SVC_INTERNAL_H
 
 #include <misc/os_epoll.h>
+#include <rpc/svc_stats.h>
 
 extern int __svc_maxiov;
 extern int __svc_maxrec;
@@ -70,7 +71,18 @@ struct svc_params {
 
 	struct {
 		u_int thrd_max;
+		u_int zerocopy_min;
+		u_int coalesce_usec;
+		u_int backlog_bytes;	/* receive paused at or over */
+		u_int backlog_count;	/* either, until both are halved */
 	} ioq;
+
+	struct {
+		int hash_partitions;
+		int max_cred;
+		int short_max;
+		int short_ttl;
+	} authunix;
 };
 
 extern struct svc_params __svc_params[1];
@@ -214,4 +226,48 @@ extern void __rpc_set_blkin_endpoint(SVCXPRT *xprt, const char *tag);
 
 void svc_rqst_shutdown(void);
 
+struct svc_dispatch_index;
+struct svc_dispatch_index *svc_dispatch_get(void);
+void svc_dispatch_put(struct svc_dispatch_index *);
+svc_lookup_result_t svc_lookup(struct svc_dispatch_index *, svc_rec_t **,
+				svc_vers_range_t *, rpcprog_t, rpcvers_t, char *,
+				u_int);
+
+/* svc_proc.c */
+struct svc_proc_tbl *svc_proc_tbl_create(const struct svc_proc_desc *,
+					 u_int);
+bool svc_proc_tbl_match(struct svc_proc_tbl *, const struct svc_proc_desc *);
+bool svc_proc_tbl_has(struct svc_proc_tbl *, rpcproc_t);
+void svc_proc_tbl_get(struct svc_proc_tbl *);
+void svc_proc_tbl_put(struct svc_proc_tbl *);
+void svc_proc_dispatch_default(struct svc_req *, SVCXPRT *);
+
+/* svc_hist.c, with SVC_FLAG_HISTOGRAMS */
+struct xdr_ioq;
+void svc_hist_wakeup(SVCXPRT *);
+void svc_hist_received(SVCXPRT *, struct svc_req *);
+void svc_hist_dispatch(svc_rec_t *, struct svc_req *);
+void svc_hist_serviced(SVCXPRT *, struct svc_req *, uint64_t);
+void svc_hist_sent(SVCXPRT *, struct svc_req *, uint64_t);
+void svc_hist_enqueued(struct svc_req *, XDR *);
+void svc_hist_flushed(SVCXPRT *, struct xdr_ioq *);
+void svc_hist_xprt_destroy(SVCXPRT *);
+void svc_hist_shutdown(void);
+
+/* svc_slow.c, with SVC_FLAG_SLOW_REQUESTS; slots are rm_slow */
+bool svc_slow_init(u_int);
+void svc_slow_start(SVCXPRT *, struct svc_req *);
+void svc_slow_mark(uint32_t, u_int);
+void svc_slow_end(uint32_t);
+void svc_slow_shutdown(void);
+
+/* svc_mem.c, the budget with SVC_FLAG_MEM_BUDGET */
+bool svc_mem_init(uint64_t);
+bool svc_mem_over(void);
+bool svc_mem_pause_rearm(SVCXPRT *);
+void svc_mem_shutdown(void);
+
+/* svc_stats.c */
+void svc_stats_shutdown(void);
+
 #endif				/* TIRPC_SVC_INTERNAL_H */
@@ -32,8 +32,14 @@
 #include <sys/un.h>
 #include <sys/time.h>
 #include <sys/uio.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#ifdef HAVE_LINUX_ERRQUEUE_H
+#include <linux/errqueue.h>
+#endif
 
 #include <assert.h>
 #include <err.h>
@@ -62,15 +68,23 @@
 #include <rpc/svc_rqst.h>
 #include <rpc/xdr_inrec.h>
 #include <rpc/xdr_ioq.h>
+#include <rpc/trace.h>
+#include <rpc/span.h>
+#include <rpc/svc_slow.h>
 #include <getpeereid.h>
 #include <misc/opr.h>
 #include "svc_ioq.h"
 
+#if defined(HAVE_LINUX_ERRQUEUE_H) && defined(SO_ZEROCOPY) \
+	&& defined(MSG_ZEROCOPY)
+#define IOQ_ZEROCOPY 1
+#endif
 
 static inline void
 cfconn_set_dead(SVCXPRT *xprt, struct x_vc_data *xd)
 {
-	mutex_lock(&xprt->xp_lock);
+	svc_stats_add(SVC_STAT_SEND_ERRORS, 1);
+	TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 	xd->sx.strm_stat = XPRT_DIED;
 	mutex_unlock(&xprt->xp_lock);
 }
@@ -78,12 +92,451 @@ cfconn_set_dead(SVCXPRT *xprt, struct x_vc_data *xd)
 #define LAST_FRAG ((u_int32_t)(1 << 31))
 #define MAXALLOCA (256)
 
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+/* writev, with send(2) flags */
+static inline ssize_t
+ioq_sendv(SVCXPRT *xprt, struct iovec *iov, int iovcnt, int flags)
+{
+	struct msghdr msg;
+
+	if (!flags)
+		return (writev(xprt->xp_fd, iov, iovcnt));
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+	return (sendmsg(xprt->xp_fd, &msg, flags));
+}
+
+/* blocking write of all of iov, flags for send(2) */
+static bool
+ioq_writev_all(SVCXPRT *xprt, struct iovec *iov, int iovcnt, int flags)
+{
+	ssize_t result;
+
+	while (iovcnt > 0) {
+		result = ioq_sendv(xprt, iov, iovcnt, flags);
+		if (unlikely(result < 0)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s() writev failed (%d)\n",
+				__func__, errno);
+			return (false);
+		}
+		for (; iovcnt > 0 && result >= iov->iov_len; ++iov, --iovcnt)
+			result -= iov->iov_len;
+		if (iovcnt > 0) {
+			iov->iov_base += result;
+			iov->iov_len -= result;
+		}
+	}
+	return (true);
+}
+
+/* blocking write of a file range, from the page cache where possible */
+static bool
+ioq_sendfile(SVCXPRT *xprt, int fd, off_t offset, size_t len)
+{
+	ssize_t result;
+#ifndef HAVE_SYS_SENDFILE_H
+	char buf[8192];
+	struct iovec iov;
+#endif
+
+	while (len > 0) {
+#ifdef HAVE_SYS_SENDFILE_H
+		result = sendfile(xprt->xp_fd, fd, &offset, len);
+#else
+		result = pread(fd, buf, (len < sizeof(buf)) ? len : sizeof(buf),
+			       offset);
+		if (result > 0) {
+			iov.iov_base = buf;
+			iov.iov_len = result;
+			if (!ioq_writev_all(xprt, &iov, 1, 0))
+				return (false);
+			offset += result;
+		}
+#endif
+		/* the file may not be shorter than promised */
+		if (unlikely(result <= 0)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s() fd %d failed (%d)\n",
+				__func__, fd, result ? errno : 0);
+			return (false);
+		}
+		len -= result;
+	}
+	return (true);
+}
+
+static inline u_int32_t
+ioq_frag_header(u_int32_t fbytes, size_t remaining)
+{
+	return (htonl(fbytes | ((fbytes == remaining) ? LAST_FRAG : 0)));
+}
+
+/*
+ * As ioq_flushv(), for streams with UIO_FLAG_FD segments.  Each file
+ * range is a record fragment of its own, its header written with the
+ * memory segments before it (with MSG_MORE, as the range follows), then
+ * its data by ioq_sendfile().  Only the memory segments ending the
+ * record are sent with flags.
+ */
+static void
+ioq_flushv_fd(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq,
+	      int flags)
+{
+	struct iovec *iov;
+	struct poolq_entry *have;
+	struct xdr_ioq_uv *data;
+	u_int32_t frag_header[2];
+	u_int32_t fbytes = 0;
+	size_t remaining = 0;	/* file ranges may total over 4GB */
+	u_int32_t len;
+	int maxiov = (__svc_maxiov > 3) ? __svc_maxiov : 3;
+	int iw = 1;		/* after the fragment header */
+
+	iov = mem_alloc(maxiov * sizeof(struct iovec));
+	if (unlikely(iov == NULL)) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s() malloc failed (%d)\n",
+			__func__, errno);
+		cfconn_set_dead(xprt, xd);
+		return;
+	}
+
+	TAILQ_FOREACH(have, &(xioq->ioq_uv.uvqh.qh), q)
+		remaining += ioquv_length(IOQ_(have));
+	TIRPC_TRACE(TIRPC_TRACE_FLUSH, xprt, 0, remaining);
+	svc_stats_add(SVC_STAT_TX_BYTES, remaining);
+
+	TAILQ_FOREACH(have, &(xioq->ioq_uv.uvqh.qh), q) {
+		data = IOQ_(have);
+		len = ioquv_length(data);
+		if (!len)
+			continue;
+
+		if (!(data->u.uio_flags & UIO_FLAG_FD)) {
+			/* leave room for a file range header */
+			if (iw >= maxiov - 1 || fbytes + len >= LAST_FRAG) {
+				frag_header[0] =
+					ioq_frag_header(fbytes, remaining);
+				iov[0].iov_base = &frag_header[0];
+				iov[0].iov_len = sizeof(u_int32_t);
+				if (!ioq_writev_all(xprt, iov, iw, MSG_MORE))
+					goto dead;
+				remaining -= fbytes;
+				fbytes = 0;
+				iw = 1;
+			}
+			iov[iw].iov_base = data->v.vio_head;
+			iov[iw].iov_len = len;
+			iw++;
+			fbytes += len;
+			continue;
+		}
+
+		if (fbytes) {
+			frag_header[0] = ioq_frag_header(fbytes, remaining);
+			iov[0].iov_base = &frag_header[0];
+			iov[0].iov_len = sizeof(u_int32_t);
+			remaining -= fbytes;
+		}
+		frag_header[1] = ioq_frag_header(len, remaining);
+		iov[iw].iov_base = &frag_header[1];
+		iov[iw].iov_len = sizeof(u_int32_t);
+		iw++;
+		if (!ioq_writev_all(xprt, fbytes ? iov : iov + 1,
+				    fbytes ? iw : iw - 1, MSG_MORE)
+		    || !ioq_sendfile(xprt, xdr_uio_fd(&data->u),
+				     xdr_vio_offset(&data->v), len))
+			goto dead;
+		remaining -= len;
+		fbytes = 0;
+		iw = 1;
+	}
+
+	if (fbytes) {
+		frag_header[0] = ioq_frag_header(fbytes, remaining);
+		iov[0].iov_base = &frag_header[0];
+		iov[0].iov_len = sizeof(u_int32_t);
+		if (!ioq_writev_all(xprt, iov, iw, flags))
+			goto dead;
+	}
+	mem_free(iov, maxiov * sizeof(struct iovec));
+	return;
+
+ dead:
+	cfconn_set_dead(xprt, xd);
+	mem_free(iov, maxiov * sizeof(struct iovec));
+}
+
+/*
+ * The segments of a record sent with MSG_ZEROCOPY, each holding a
+ * reference until the kernel reports all of its sends complete.
+ */
+struct ioq_zc_ent {
+	struct poolq_entry q;	/*** 1st ***/
+	uint32_t lo;		/* first send */
+	uint32_t sends;		/* UINT32_MAX while sending */
+	uint32_t done;		/* completed */
+	u_int count;
+	struct xdr_ioq_uv *uv[];
+};
+
+#define ioq_zc_size(count) \
+	(sizeof(struct ioq_zc_ent) + (count) * sizeof(struct xdr_ioq_uv *))
+
+static void
+ioq_zc_free(struct ioq_zc_ent *zc)
+{
+	u_int ix;
+
+	for (ix = 0; ix < zc->count; ++ix)
+		xdr_ioq_uv_release(zc->uv[ix]);
+	mem_free(zc, ioq_zc_size(zc->count));
+}
+
+#ifdef IOQ_ZEROCOPY
+/*
+ * Only records with a segment of at least ioq.zerocopy_min are worth
+ * it.  Returns NULL to send by copying.
+ */
+static struct ioq_zc_ent *
+ioq_zc_open(struct x_vc_data *xd, struct xdr_ioq *xioq)
+{
+	struct ioq_zc_ent *zc;
+	struct poolq_entry *have;
+	u_int count = xioq->ioq_uv.uvqh.qcount;
+
+	TAILQ_FOREACH(have, &(xioq->ioq_uv.uvqh.qh), q) {
+		if (ioquv_length(IOQ_(have)) >= __svc_params->ioq.zerocopy_min)
+			break;
+	}
+	if (!have)
+		return (NULL);
+
+	zc = mem_alloc(ioq_zc_size(count));
+	if (unlikely(!zc))
+		return (NULL);
+
+	zc->count = 0;
+	TAILQ_FOREACH(have, &(xioq->ioq_uv.uvqh.qh), q) {
+		atomic_inc_int32_t(&IOQ_(have)->u.uio_references);
+		zc->uv[zc->count++] = IOQ_(have);
+	}
+	zc->done = 0;
+	zc->sends = UINT32_MAX;
+
+	/* queued first, completions may be reaped before the send returns */
+	mutex_lock(&xd->shared.zcq.qmutex);
+	zc->lo = xd->shared.zcseq;
+	TAILQ_INSERT_TAIL(&xd->shared.zcq.qh, &zc->q, q);
+	(xd->shared.zcq.qcount)++;
+	mutex_unlock(&xd->shared.zcq.qmutex);
+	return (zc);
+}
+
+static void
+ioq_zc_close(struct x_vc_data *xd, struct ioq_zc_ent *zc)
+{
+	mutex_lock(&xd->shared.zcq.qmutex);
+	zc->sends = xd->shared.zcseq - zc->lo;
+	if (zc->done < zc->sends) {
+		mutex_unlock(&xd->shared.zcq.qmutex);
+		return;
+	}
+	TAILQ_REMOVE(&xd->shared.zcq.qh, &zc->q, q);
+	(xd->shared.zcq.qcount)--;
+	mutex_unlock(&xd->shared.zcq.qmutex);
+	ioq_zc_free(zc);
+}
+
+/* sends lo through hi (inclusive, and wrapping) are complete */
+static void
+ioq_zc_complete(struct x_vc_data *xd, uint32_t lo, uint32_t hi)
+{
+	struct q_head done = TAILQ_HEAD_INITIALIZER(done);
+	struct poolq_entry *have, *next;
+	struct ioq_zc_ent *zc;
+	uint32_t first, last;
+
+	mutex_lock(&xd->shared.zcq.qmutex);
+	TAILQ_FOREACH_SAFE(have, &xd->shared.zcq.qh, q, next) {
+		zc = (struct ioq_zc_ent *)have;
+
+		/* relative to the first send of this record */
+		if ((int32_t)(hi - zc->lo) < 0)
+			break;
+		first = ((int32_t)(lo - zc->lo) < 0) ? 0 : lo - zc->lo;
+		last = hi - zc->lo;
+		if (last >= zc->sends)
+			last = zc->sends - 1;
+		if (first > last)
+			continue;
+
+		zc->done += last - first + 1;
+		if (zc->done >= zc->sends) {
+			TAILQ_REMOVE(&xd->shared.zcq.qh, have, q);
+			(xd->shared.zcq.qcount)--;
+			TAILQ_INSERT_TAIL(&done, have, q);
+		}
+	}
+	mutex_unlock(&xd->shared.zcq.qmutex);
+
+	while ((have = TAILQ_FIRST(&done))) {
+		TAILQ_REMOVE(&done, have, q);
+		ioq_zc_free((struct ioq_zc_ent *)have);
+	}
+}
+
+static bool
+ioq_zc_reap(SVCXPRT *xprt, struct x_vc_data *xd)
+{
+	char control[128];
+	struct msghdr msg;
+	struct cmsghdr *cm;
+	struct sock_extended_err *serr;
+	bool found = false;
+
+	for (;;) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (recvmsg(xprt->xp_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)
+		    < 0)
+			break;
+
+		for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!(cm->cmsg_level == SOL_IP
+			      && cm->cmsg_type == IP_RECVERR)
+			    && !(cm->cmsg_level == SOL_IPV6
+				 && cm->cmsg_type == IPV6_RECVERR))
+				continue;
+			serr = (struct sock_extended_err *)CMSG_DATA(cm);
+			if (serr->ee_errno
+			    || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+
+			/* the kernel had to copy, so stop paying for it */
+			if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				xd->shared.zccopied = true;
+			ioq_zc_complete(xd, serr->ee_info, serr->ee_data);
+			found = true;
+		}
+	}
+	return (found);
+}
+
+/* a MSG_ZEROCOPY send counts whether or not it wrote everything */
+static inline ssize_t
+ioq_zc_writev(SVCXPRT *xprt, struct x_vc_data *xd, struct iovec *iov,
+	      int iovcnt, int flags)
+{
+	ssize_t result;
+
+	result = ioq_sendv(xprt, iov, iovcnt, flags | MSG_ZEROCOPY);
+	if (result >= 0) {
+		mutex_lock(&xd->shared.zcq.qmutex);
+		(xd->shared.zcseq)++;
+		mutex_unlock(&xd->shared.zcq.qmutex);
+	} else if (errno == ENOBUFS) {
+		/* out of optmem for notifications */
+		result = ioq_sendv(xprt, iov, iovcnt, flags);
+	}
+	return (result);
+}
+#endif /* IOQ_ZEROCOPY */
+
+/*
+ * Called for accepted connections with SVC_INIT_ZEROCOPY.
+ */
+bool
+svc_ioq_zerocopy_enable(int fd)
+{
+#ifdef IOQ_ZEROCOPY
+	int one = 1;
+
+	return (!setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)));
+#else
+	return (false);
+#endif
+}
+
+/*
+ * Called by the event channel when the socket signals an error, which
+ * is how MSG_ZEROCOPY completions arrive.  Returns true if any were
+ * found, false if the error is something else for the caller.
+ */
+bool
+svc_ioq_zerocopy_reap(SVCXPRT *xprt)
+{
+#ifdef IOQ_ZEROCOPY
+	struct x_vc_data *xd = (struct x_vc_data *)xprt->xp_p1;
+
+	if (xprt->xp_type == XPRT_TCP && xd->shared.zerocopy)
+		return (ioq_zc_reap(xprt, xd));
+#endif
+	return (false);
+}
+
+/*
+ * Called just before the socket is closed.  A graceful close would go on
+ * sending whatever is queued, from segments svc_ioq_zerocopy_destroy()
+ * is about to free, so reset the connection while completions are
+ * outstanding; that discards the unsent data with the socket.
+ */
+void
+svc_ioq_zerocopy_linger(struct x_vc_data *xd, int fd)
+{
+#ifdef IOQ_ZEROCOPY
+	struct linger lg = { 1, 0 };
+	int pending;
+
+	if (!xd->shared.zerocopy || fd < 0)
+		return;
+
+	mutex_lock(&xd->shared.zcq.qmutex);
+	pending = xd->shared.zcq.qcount;
+	mutex_unlock(&xd->shared.zcq.qmutex);
+
+	if (pending > 0)
+		(void)setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+#endif
+}
+
+/*
+ * Called after the socket was closed, with svc_ioq_zerocopy_linger()
+ * having reset it if any sends were still in flight, so the kernel has
+ * dropped what it had queued from these segments.
+ */
+void
+svc_ioq_zerocopy_destroy(struct x_vc_data *xd)
+{
+	struct poolq_entry *have;
+
+	while ((have = TAILQ_FIRST(&xd->shared.zcq.qh))) {
+		TAILQ_REMOVE(&xd->shared.zcq.qh, have, q);
+		ioq_zc_free((struct ioq_zc_ent *)have);
+	}
+	xd->shared.zcq.qcount = 0;
+}
+
+/*
+ * flags are for send(2), MSG_MORE while more replies are queued
+ */
 static inline void
-ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq)
+ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq,
+	   int flags)
 {
 	struct iovec *iov, *tiov, *wiov;
 	struct poolq_entry *have;
 	struct xdr_ioq_uv *data;
+#ifdef IOQ_ZEROCOPY
+	struct ioq_zc_ent *zc = NULL;
+#endif
 	ssize_t result;
 	u_int32_t frag_header;
 	u_int32_t fbytes;
@@ -112,6 +565,10 @@ ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq)
 	/* build list after initial fragment header (ix = 1 above) */
 	TAILQ_FOREACH(have, &(xioq->ioq_uv.uvqh.qh), q) {
 		data = IOQ_(have);
+		if (unlikely(data->u.uio_flags & UIO_FLAG_FD)) {
+			ioq_flushv_fd(xprt, xd, xioq, flags);
+			goto out;
+		}
 		tiov = iov + ix;
 		tiov->iov_base = data->v.vio_head;
 		tiov->iov_len = ioquv_length(data);
@@ -119,6 +576,14 @@ ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq)
 		ix++;
 	}
 
+#ifdef IOQ_ZEROCOPY
+	if (xd->shared.zerocopy && !xd->shared.zccopied)
+		zc = ioq_zc_open(xd, xioq);
+#endif
+
+	TIRPC_TRACE(TIRPC_TRACE_FLUSH, xprt, 0, remaining);
+	svc_stats_add(SVC_STAT_TX_BYTES, remaining);
+
 	while (remaining > 0) {
 		if (iw == 0) {
 			/* new fragment header, determine last iov */
@@ -151,7 +616,12 @@ ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq)
 		}
 
 		/* blocking write */
-		result = writev(xprt->xp_fd, wiov, iw);
+#ifdef IOQ_ZEROCOPY
+		if (zc)
+			result = ioq_zc_writev(xprt, xd, wiov, iw, flags);
+		else
+#endif
+			result = ioq_sendv(xprt, wiov, iw, flags);
 		remaining -= result;
 
 		if (result == fbytes) {
@@ -181,6 +651,14 @@ ioq_flushv(SVCXPRT *xprt, struct x_vc_data *xd, struct xdr_ioq *xioq)
 		} /* for */
 	} /* while */
 
+#ifdef IOQ_ZEROCOPY
+	if (zc)
+		ioq_zc_close(xd, zc);
+	if (xd->shared.zcq.qcount)
+		(void)ioq_zc_reap(xprt, xd);
+#endif
+
+ out:
 	if (unlikely(vsize > MAXALLOCA)) {
 		mem_free(iov, vsize);
 	}
@@ -193,6 +671,10 @@ svc_ioq_callback(struct work_pool_entry *wpe)
 	SVCXPRT *xprt = (SVCXPRT *)wpe->arg;
 	struct poolq_entry *have;
 	struct xdr_ioq *xioq;
+	struct timespec since, now;
+	bool corked = false;
+	bool rearm = false;
+	int flags;
 
 	/* qmutex more fine grained than xp_lock */
 	for (;;) {
@@ -207,15 +689,60 @@ svc_ioq_callback(struct work_pool_entry *wpe)
 
 		TAILQ_REMOVE(&xd->shared.ioq.qh, have, q);
 		(xd->shared.ioq.qcount)--;
+		xioq = _IOQ(have);
+		xd->shared.ioq_bytes -= xioq->ioq_backlog;
+		if (unlikely(xd->shared.throttled)
+		    && xd->shared.ioq.qcount
+		       <= __svc_params->ioq.backlog_count / 2
+		    && xd->shared.ioq_bytes
+		       <= __svc_params->ioq.backlog_bytes / 2) {
+			xd->shared.throttled = false;
+			rearm = xd->shared.rearm_deferred;
+			xd->shared.rearm_deferred = false;
+		}
+		flags = (xd->shared.ioq.qcount
+			 && (__svc_params->flags & SVC_FLAG_COALESCE))
+			? MSG_MORE : 0;
 		/* do i/o unlocked */
 		mutex_unlock(&xd->shared.ioq.qmutex);
-		xioq = _IOQ(have);
+
+		if (unlikely(rearm)) {
+			rearm = false;
+			svc_stats_add(SVC_STAT_IOQ_RESUMED, 1);
+			(void)svc_rqst_rearm_events(xprt, SVC_RQST_FLAG_NONE);
+		}
+
+		/* hold back partial segments for the replies queued
+		 * behind this one, but not past the latency cap */
+		if (flags) {
+			(void)clock_gettime(CLOCK_MONOTONIC, &now);
+			if (!corked) {
+				since = now;
+				corked = true;
+			} else if ((now.tv_sec - since.tv_sec) * 1000000
+				   + (now.tv_nsec - since.tv_nsec) / 1000
+				   >= __svc_params->ioq.coalesce_usec) {
+				flags = 0;
+				corked = false;
+			}
+		} else {
+			corked = false;
+		}
 
 		if (svc_work_pool.params.thrd_max
 		 && !(xprt->xp_flags & SVC_XPRT_FLAG_DESTROYED)) {
 			/* all systems are go! */
-			ioq_flushv(xprt, xd, xioq);
+			ioq_flushv(xprt, xd, xioq, flags);
+			if (xioq->ioq_ts)
+				svc_hist_flushed(xprt, xioq);
+			TIRPC_SPAN_END(TIRPC_SPAN_FLUSH, xprt, xioq->ioq_xid,
+				       0, xioq->ioq_span);
+			if (unlikely(xioq->ioq_slow))
+				svc_slow_mark(xioq->ioq_slow,
+					      SVC_SLOW_FLUSHED);
 		}
+		if (unlikely(xioq->ioq_slow))
+			svc_slow_end(xioq->ioq_slow);
 		XDR_DESTROY(xioq->xdrs);
 	}
 
@@ -225,17 +752,33 @@ svc_ioq_callback(struct work_pool_entry *wpe)
 void
 svc_ioq_append(SVCXPRT *xprt, struct x_vc_data *xd, XDR *xdrs)
 {
+	struct xdr_ioq *xioq = XIOQ(xdrs);
+
 	if (unlikely(!svc_work_pool.params.thrd_max
 		  || (xprt->xp_flags & SVC_XPRT_FLAG_DESTROYED))) {
 		/* discard */
+		if (unlikely(XIOQ(xdrs)->ioq_slow))
+			svc_slow_end(XIOQ(xdrs)->ioq_slow);
 		XDR_DESTROY(xdrs);
 		return;
 	}
 
+	if (unlikely(__svc_params->flags & SVC_FLAG_IOQ_BACKLOG))
+		xioq->ioq_backlog = XDR_GETPOS(xdrs);
+
 	/* qmutex more fine grained than xp_lock */
 	mutex_lock(&xd->shared.ioq.qmutex);
 	(xd->shared.ioq.qcount)++;
-	TAILQ_INSERT_TAIL(&xd->shared.ioq.qh, &(XIOQ(xdrs)->ioq_s), q);
+	TAILQ_INSERT_TAIL(&xd->shared.ioq.qh, &(xioq->ioq_s), q);
+
+	xd->shared.ioq_bytes += xioq->ioq_backlog;
+	if (unlikely(xioq->ioq_backlog) && !xd->shared.throttled
+	    && (xd->shared.ioq.qcount >= __svc_params->ioq.backlog_count
+		|| xd->shared.ioq_bytes >= __svc_params->ioq.backlog_bytes)) {
+		/* receive events are no longer re-armed */
+		xd->shared.throttled = true;
+		svc_stats_add(SVC_STAT_IOQ_THROTTLED, 1);
+	}
 
 	if (!xd->shared.active) {
 		xd->shared.active = true;
@@ -249,3 +792,21 @@ svc_ioq_append(SVCXPRT *xprt, struct x_vc_data *xd, XDR *xdrs)
 		mutex_unlock(&xd->shared.ioq.qmutex);
 	}
 }
+
+/* with SVC_FLAG_IOQ_BACKLOG, true if the re-arm waits for the backlog */
+bool
+svc_ioq_throttle_rearm(SVCXPRT *xprt)
+{
+	struct x_vc_data *xd = (struct x_vc_data *)xprt->xp_p1;
+	bool throttled;
+
+	mutex_lock(&xd->shared.ioq.qmutex);
+	throttled = xd->shared.throttled;
+	if (throttled)
+		xd->shared.rearm_deferred = true;
+	mutex_unlock(&xd->shared.ioq.qmutex);
+
+	if (throttled)
+		svc_stats_add(SVC_STAT_IOQ_DEFERRED, 1);
+	return (throttled);
+}
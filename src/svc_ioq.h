@@ -31,5 +31,10 @@
 #include "clnt_internal.h"
 
 void svc_ioq_append(SVCXPRT *, struct x_vc_data *, XDR *);
+bool svc_ioq_throttle_rearm(SVCXPRT *);
+bool svc_ioq_zerocopy_enable(int);
+bool svc_ioq_zerocopy_reap(SVCXPRT *);
+void svc_ioq_zerocopy_linger(struct x_vc_data *, int);
+void svc_ioq_zerocopy_destroy(struct x_vc_data *);
 
 #endif				/* SVC_IOQ_H */
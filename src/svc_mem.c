@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * svc_mem.c
+ * Request memory accounting and budget.
+ *
+ * Each thread adds into its own deltas, and folds a category into the
+ * shared gauges once it has moved SVC_MEM_BATCH bytes, or as it exits,
+ * so the allocation paths rarely touch a shared cache line.  The thread
+ * that folds the total across the budget sets the over flag; whoever
+ * next sees the folded total back under 7/8 of it clears the flag.
+ *
+ * Re-arms that find the flag set leave their transport armed only for
+ * hangups, and park it here.  A timer thread re-arms the parked
+ * transports once the flag clears, and every SVC_MEM_PROBE_MSEC while
+ * it stays set, so memory the deltas have not folded yet, or receive
+ * buffers that alone fill the budget, cannot stall the server.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <misc/timespec.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/svc_mem.h>
+#include <rpc/svc_rqst.h>
+#include <rpc/svc_stats.h>
+#include <misc/abstract_atomic.h>
+
+#include "svc_internal.h"
+
+#define SVC_MEM_TICK_MSEC 100
+#define SVC_MEM_PROBE_MSEC 1000
+
+static int64_t svc_mem_bytes[SVC_MEM_CATS];
+static int64_t svc_mem_total;
+static __thread int64_t svc_mem_delta[SVC_MEM_CATS];
+static __thread bool svc_mem_keyed;
+
+static pthread_key_t svc_mem_key;
+static pthread_once_t svc_mem_once = PTHREAD_ONCE_INIT;
+
+static const char *svc_mem_names[SVC_MEM_CATS] = {
+	"inrec",
+	"ioq",
+	"rpc_msg",
+	"drc",
+};
+
+struct svc_mem_parked {
+	SVCXPRT **xprts;	/* each holds a reference */
+	u_int count;
+	u_int max;
+};
+
+static struct {
+	mutex_t mtx;
+	cond_t cv;
+	pthread_t thread;
+	struct svc_mem_parked parked;
+	uint64_t budget;
+	uint32_t over;
+	uint32_t running;
+} svc_mem_st = {
+	MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+};
+
+/* set or clear the over flag for a folded total */
+static bool
+svc_mem_check(int64_t total)
+{
+	uint64_t budget = svc_mem_st.budget;
+
+	if (!budget)
+		return (false);
+
+	if (total >= (int64_t)budget) {
+		if (!atomic_fetch_uint32_t(&svc_mem_st.over)
+		    && __sync_bool_compare_and_swap(&svc_mem_st.over, 0, 1)) {
+			svc_stats_add(SVC_STAT_MEM_OVER, 1);
+			__warnx(TIRPC_DEBUG_FLAG_EVENT,
+				"%s() %" PRId64 " bytes over budget %" PRIu64,
+				__func__, total, budget);
+		}
+		return (true);
+	}
+
+	if (!atomic_fetch_uint32_t(&svc_mem_st.over))
+		return (false);
+	if (total > (int64_t)(budget - budget / 8))
+		return (true);
+
+	/* the timer thread re-arms what was parked */
+	if (__sync_bool_compare_and_swap(&svc_mem_st.over, 1, 0)) {
+		mutex_lock(&svc_mem_st.mtx);
+		cond_signal(&svc_mem_st.cv);
+		mutex_unlock(&svc_mem_st.mtx);
+	}
+	return (false);
+}
+
+static void
+svc_mem_fold(enum svc_mem_cat cat, int64_t delta)
+{
+	(void)atomic_add_int64_t(&svc_mem_bytes[cat], delta);
+	(void)svc_mem_check(atomic_add_int64_t(&svc_mem_total, delta));
+}
+
+/* thread exit, what this thread has not folded would be lost */
+static void
+svc_mem_thread_exit(void *arg)
+{
+	int64_t *delta = arg;
+	int ix;
+
+	for (ix = 0; ix < SVC_MEM_CATS; ix++) {
+		if (delta[ix]) {
+			svc_mem_fold(ix, delta[ix]);
+			delta[ix] = 0;
+		}
+	}
+}
+
+static void
+svc_mem_key_init(void)
+{
+	(void)pthread_key_create(&svc_mem_key, svc_mem_thread_exit);
+}
+
+void
+svc_mem_add(enum svc_mem_cat cat, int64_t bytes)
+{
+	int64_t delta;
+
+	if (unlikely(cat >= SVC_MEM_CATS))
+		return;
+
+	if (unlikely(!svc_mem_keyed)) {
+		(void)pthread_once(&svc_mem_once, svc_mem_key_init);
+		(void)pthread_setspecific(svc_mem_key, svc_mem_delta);
+		svc_mem_keyed = true;
+	}
+
+	delta = (svc_mem_delta[cat] += bytes);
+	if (delta >= SVC_MEM_BATCH || delta <= -SVC_MEM_BATCH) {
+		svc_mem_delta[cat] = 0;
+		svc_mem_fold(cat, delta);
+	}
+}
+
+bool
+svc_mem_over(void)
+{
+	if (likely(!atomic_fetch_uint32_t(&svc_mem_st.over)))
+		return (false);
+	return (svc_mem_check(atomic_fetch_int64_t(&svc_mem_total)));
+}
+
+/* with SVC_FLAG_MEM_BUDGET, true if the re-arm waits for svc_mem */
+bool
+svc_mem_pause_rearm(SVCXPRT *xprt)
+{
+	struct svc_mem_parked *parked = &svc_mem_st.parked;
+	SVCXPRT **xprts;
+	u_int max;
+
+	if (!svc_mem_over())
+		return (false);
+
+	mutex_lock(&svc_mem_st.mtx);
+	if (!svc_mem_st.running) {
+		mutex_unlock(&svc_mem_st.mtx);
+		return (false);
+	}
+
+	if (parked->count == parked->max) {
+		max = parked->max ? parked->max * 2 : 64;
+		xprts = mem_alloc(max * sizeof(SVCXPRT *));
+		if (!xprts) {
+			/* re-armed after all */
+			mutex_unlock(&svc_mem_st.mtx);
+			return (false);
+		}
+		if (parked->xprts) {
+			memcpy(xprts, parked->xprts,
+			       parked->count * sizeof(SVCXPRT *));
+			mem_free(parked->xprts,
+				 parked->max * sizeof(SVCXPRT *));
+		}
+		parked->xprts = xprts;
+		parked->max = max;
+	}
+
+	SVC_REF(xprt, SVC_REF_FLAG_NONE);
+	parked->xprts[(parked->count)++] = xprt;
+	mutex_unlock(&svc_mem_st.mtx);
+
+	svc_stats_add(SVC_STAT_MEM_PAUSED, 1);
+	return (true);
+}
+
+/* called locked, drops the lock while re-arming */
+static void
+svc_mem_resume(bool rearm)
+{
+	struct svc_mem_parked parked = svc_mem_st.parked;
+	u_int ix;
+
+	memset(&svc_mem_st.parked, 0, sizeof(svc_mem_st.parked));
+	mutex_unlock(&svc_mem_st.mtx);
+
+	for (ix = 0; ix < parked.count; ix++) {
+		if (rearm)
+			(void)svc_rqst_rearm_events(parked.xprts[ix],
+						SVC_RQST_FLAG_MEM_RESUME);
+		SVC_RELEASE(parked.xprts[ix], SVC_RELEASE_FLAG_NONE);
+	}
+	if (parked.xprts)
+		mem_free(parked.xprts, parked.max * sizeof(SVCXPRT *));
+
+	mutex_lock(&svc_mem_st.mtx);
+}
+
+static void *
+svc_mem_thread(void *arg)
+{
+	struct timespec ts;
+	u_int ticks = 0;
+
+	mutex_lock(&svc_mem_st.mtx);
+	while (svc_mem_st.running) {
+		(void)clock_gettime(CLOCK_REALTIME, &ts);
+		timespec_addms(&ts, SVC_MEM_TICK_MSEC);
+		(void)cond_timedwait(&svc_mem_st.cv, &svc_mem_st.mtx, &ts);
+
+		if (!svc_mem_st.running || !svc_mem_st.parked.count) {
+			ticks = 0;
+			continue;
+		}
+
+		mutex_unlock(&svc_mem_st.mtx);
+		if (svc_mem_over()
+		    && ++ticks < SVC_MEM_PROBE_MSEC / SVC_MEM_TICK_MSEC) {
+			mutex_lock(&svc_mem_st.mtx);
+			continue;
+		}
+		if (ticks)
+			svc_stats_add(SVC_STAT_MEM_PROBED, 1);
+		ticks = 0;
+		mutex_lock(&svc_mem_st.mtx);
+		svc_mem_resume(true);
+	}
+	mutex_unlock(&svc_mem_st.mtx);
+	return (NULL);
+}
+
+void
+svc_mem_get(struct svc_mem_stats *st)
+{
+	int ix;
+
+	for (ix = 0; ix < SVC_MEM_CATS; ix++)
+		st->bytes[ix] = atomic_fetch_int64_t(&svc_mem_bytes[ix]);
+	st->total = atomic_fetch_int64_t(&svc_mem_total);
+	st->budget = svc_mem_st.budget;
+	st->over = atomic_fetch_uint32_t(&svc_mem_st.over) != 0;
+}
+
+const char *
+svc_mem_name(enum svc_mem_cat cat)
+{
+	if (cat >= SVC_MEM_CATS)
+		return ("unknown");
+	return (svc_mem_names[cat]);
+}
+
+bool
+svc_mem_init(uint64_t budget)
+{
+	int rc;
+
+	mutex_lock(&svc_mem_st.mtx);
+	if (svc_mem_st.running) {
+		svc_mem_st.budget = budget;
+		mutex_unlock(&svc_mem_st.mtx);
+		return (true);
+	}
+
+	svc_mem_st.running = 1;
+	rc = pthread_create(&svc_mem_st.thread, NULL, svc_mem_thread, NULL);
+	if (rc) {
+		svc_mem_st.running = 0;
+		mutex_unlock(&svc_mem_st.mtx);
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s() timer thread failed: %s (%d)",
+			__func__, strerror(rc), rc);
+		return (false);
+	}
+	svc_mem_st.budget = budget;
+	mutex_unlock(&svc_mem_st.mtx);
+	return (true);
+}
+
+void
+svc_mem_shutdown(void)
+{
+	mutex_lock(&svc_mem_st.mtx);
+	if (svc_mem_st.running) {
+		atomic_store_uint32_t(&svc_mem_st.running, 0);
+		cond_signal(&svc_mem_st.cv);
+		mutex_unlock(&svc_mem_st.mtx);
+		pthread_join(svc_mem_st.thread, NULL);
+		mutex_lock(&svc_mem_st.mtx);
+	}
+	svc_mem_st.budget = 0;
+	atomic_store_uint32_t(&svc_mem_st.over, 0);
+	svc_mem_resume(false);
+	mutex_unlock(&svc_mem_st.mtx);
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * svc_proc.c
+ * Per-procedure dispatch for services registered with svc_reg_procs().
+ *
+ * Each procedure keeps a small free list of argument/result buffers,
+ * sized for that procedure, so the common path neither allocates nor
+ * walks an application switch on rq_proc.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <misc/abstract_atomic.h>
+
+#include "svc_internal.h"
+
+/* buffers retained per procedure */
+#define SVC_PROC_POOL_MAX 64
+
+struct svc_proc_buf {
+	struct svc_proc_buf *next;
+};
+
+struct svc_proc_ent {
+	struct svc_proc_desc desc;
+	size_t res_off;		/* results follow arguments */
+	size_t buf_size;
+	mutex_t mtx;		/* free list */
+	struct svc_proc_buf *free;
+	uint32_t nfree;
+	struct svc_proc_stats stats;
+};
+
+struct svc_proc_tbl {
+	int32_t refcnt;		/* the callout, and each dispatch index */
+	const struct svc_proc_desc *procs;	/* as registered */
+	u_int nprocs;
+	struct svc_proc_ent ent[];
+};
+
+#define SVC_PROC_ALIGN(x) (((x) + 7) & ~((size_t) 7))
+
+struct svc_proc_tbl *
+svc_proc_tbl_create(const struct svc_proc_desc *procs, u_int nprocs)
+{
+	struct svc_proc_tbl *tbl;
+	struct svc_proc_ent *ent;
+	u_int ix;
+
+	tbl = mem_zalloc(sizeof(struct svc_proc_tbl)
+			 + nprocs * sizeof(struct svc_proc_ent));
+	if (!tbl)
+		return (NULL);
+
+	tbl->refcnt = 1;
+	tbl->procs = procs;
+	tbl->nprocs = nprocs;
+	for (ix = 0; ix < nprocs; ++ix) {
+		ent = &tbl->ent[ix];
+		ent->desc = procs[ix];
+		if (!ent->desc.sp_xdr_args)
+			ent->desc.sp_xdr_args = (xdrproc_t) xdr_void;
+		if (!ent->desc.sp_xdr_res)
+			ent->desc.sp_xdr_res = (xdrproc_t) xdr_void;
+		ent->res_off = SVC_PROC_ALIGN(ent->desc.sp_args_size);
+		ent->buf_size = ent->res_off
+		    + SVC_PROC_ALIGN(ent->desc.sp_res_size);
+		/* room for the free list link */
+		if (ent->buf_size < sizeof(struct svc_proc_buf))
+			ent->buf_size = sizeof(struct svc_proc_buf);
+		mutex_init(&ent->mtx, NULL);
+	}
+	return (tbl);
+}
+
+bool
+svc_proc_tbl_match(struct svc_proc_tbl *tbl,
+		   const struct svc_proc_desc *procs)
+{
+	return (tbl && tbl->procs == procs);
+}
+
+/* whether proc has a handler, as svc_proc_dispatch() checks */
+bool
+svc_proc_tbl_has(struct svc_proc_tbl *tbl, rpcproc_t proc)
+{
+	return (proc < tbl->nprocs && tbl->ent[proc].desc.sp_handler);
+}
+
+static void
+svc_proc_tbl_free(struct svc_proc_tbl *tbl)
+{
+	struct svc_proc_ent *ent;
+	struct svc_proc_buf *buf;
+	u_int ix;
+
+	for (ix = 0; ix < tbl->nprocs; ++ix) {
+		ent = &tbl->ent[ix];
+		while ((buf = ent->free)) {
+			ent->free = buf->next;
+			mem_free(buf, ent->buf_size);
+		}
+		mutex_destroy(&ent->mtx);
+	}
+	mem_free(tbl, sizeof(struct svc_proc_tbl)
+		 + tbl->nprocs * sizeof(struct svc_proc_ent));
+}
+
+/*
+ * Taken by each dispatch index that copies the record, so the table is
+ * freed with the last of the callout and the indexes dispatchers hold.
+ */
+void
+svc_proc_tbl_get(struct svc_proc_tbl *tbl)
+{
+	(void)atomic_inc_int32_t(&tbl->refcnt);
+}
+
+void
+svc_proc_tbl_put(struct svc_proc_tbl *tbl)
+{
+	if (!atomic_dec_int32_t(&tbl->refcnt))
+		svc_proc_tbl_free(tbl);
+}
+
+static inline void *
+svc_proc_buf_get(struct svc_proc_ent *ent)
+{
+	struct svc_proc_buf *buf;
+
+	mutex_lock(&ent->mtx);
+	buf = ent->free;
+	if (buf) {
+		ent->free = buf->next;
+		--(ent->nfree);
+	}
+	mutex_unlock(&ent->mtx);
+
+	if (!buf)
+		return (mem_zalloc(ent->buf_size));
+
+	memset(buf, 0, ent->buf_size);
+	return (buf);
+}
+
+static inline void
+svc_proc_buf_put(struct svc_proc_ent *ent, void *ptr)
+{
+	struct svc_proc_buf *buf = ptr;
+
+	mutex_lock(&ent->mtx);
+	if (ent->nfree < SVC_PROC_POOL_MAX) {
+		buf->next = ent->free;
+		ent->free = buf;
+		++(ent->nfree);
+		buf = NULL;
+	}
+	mutex_unlock(&ent->mtx);
+
+	if (buf)
+		mem_free(buf, ent->buf_size);
+}
+
+/*
+ * Decode arguments, call the procedure, and encode its results
+ */
+void
+svc_proc_dispatch(struct svc_proc_tbl *tbl, struct svc_req *req,
+		  SVCXPRT *xprt)
+{
+	struct svc_proc_ent *ent;
+	char *buf;
+	void *args, *res;
+
+	if (unlikely(req->rq_proc >= tbl->nprocs)
+	    || unlikely(!tbl->ent[req->rq_proc].desc.sp_handler)) {
+		svcerr_noproc(xprt, req);
+		return;
+	}
+	ent = &tbl->ent[req->rq_proc];
+
+	buf = svc_proc_buf_get(ent);
+	if (unlikely(!buf)) {
+		svcerr_systemerr(xprt, req);
+		return;
+	}
+	args = buf;
+	res = buf + ent->res_off;
+
+	/* on failure, the transport has freed any partial arguments */
+	if (!SVC_GETARGS(xprt, req, ent->desc.sp_xdr_args, args, NULL)) {
+		atomic_inc_uint64_t(&ent->stats.garbage_args);
+		svcerr_decode(xprt, req);
+		svc_proc_buf_put(ent, buf);
+		return;
+	}
+
+	atomic_inc_uint64_t(&ent->stats.calls);
+	if (ent->desc.sp_handler(req, xprt, args, res)
+	    && !svc_sendreply(xprt, req, ent->desc.sp_xdr_res, res))
+		atomic_inc_uint64_t(&ent->stats.send_errors);
+
+	/* zeroed before the call, so partial results free as well */
+	(void)xdr_free(ent->desc.sp_xdr_res, res);
+
+	SVC_FREEARGS(xprt, req, ent->desc.sp_xdr_args, args);
+	svc_proc_buf_put(ent, buf);
+}
+
+/*
+ * sc_dispatch of svc_reg_procs() records, for callers that invoke the
+ * dispatch routine directly rather than by svc_rec_dispatch()
+ */
+void
+svc_proc_dispatch_default(struct svc_req *req, SVCXPRT *xprt)
+{
+	struct svc_dispatch_index *idx = svc_dispatch_get();
+	svc_vers_range_t vrange;
+	svc_rec_t *rec;
+
+	if (svc_lookup(idx, &rec, &vrange, req->rq_prog, req->rq_vers,
+		       xprt->xp_netid, 0) != SVC_LKP_SUCCESS
+	    || !rec->sc_procs)
+		svcerr_noprog(xprt, req);
+	else
+		svc_proc_dispatch(rec->sc_procs, req, xprt);
+	svc_dispatch_put(idx);
+}
+
+/*
+ * Counters for one procedure of a svc_reg_procs() service
+ */
+bool
+svc_proc_stats_get(const rpcprog_t prog, const rpcvers_t vers,
+		   const rpcproc_t proc, struct svc_proc_stats *stats)
+{
+	struct svc_dispatch_index *idx = svc_dispatch_get();
+	svc_vers_range_t vrange;
+	svc_rec_t *rec;
+	struct svc_proc_ent *ent;
+
+	if (svc_lookup(idx, &rec, &vrange, prog, vers, NULL, 0)
+	    != SVC_LKP_SUCCESS
+	    || !rec->sc_procs || proc >= rec->sc_procs->nprocs) {
+		svc_dispatch_put(idx);
+		return (false);
+	}
+
+	ent = &rec->sc_procs->ent[proc];
+	stats->calls = atomic_fetch_uint64_t(&ent->stats.calls);
+	stats->garbage_args = atomic_fetch_uint64_t(&ent->stats.garbage_args);
+	stats->send_errors = atomic_fetch_uint64_t(&ent->stats.send_errors);
+	svc_dispatch_put(idx);
+	return (true);
+}
@@ -52,6 +52,7 @@
 #include "svc_internal.h"
 #include <rpc/svc_rqst.h>
 #include "svc_xprt.h"
+#include "svc_ioq.h"
 
 /*
  * The TI-RPC instance should be able to reach every registered
@@ -226,14 +227,14 @@ svc_rqst_lookup_chan(uint32_t chan_id, struct rbtree_x_part **ref_t,
 	t = rbtx_partition_of_scalar(&svc_rqst_set.xt, trec.id_k);
 	*ref_t = t;
 
-	mutex_lock(&t->mtx);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
 
 	ns = rbtree_x_cached_lookup(&svc_rqst_set.xt, t, &trec.node_k,
 				    trec.id_k);
 	if (ns) {
 		sr_rec = opr_containerof(ns, struct svc_rqst_rec, node_k);
 		if (!(flags & SVC_RQST_FLAG_SREC_LOCKED))
-			mutex_lock(&sr_rec->mtx);
+			TIRPC_MUTEX_LOCK(&sr_rec->mtx, TIRPC_LOCK_EVCHAN);
 		++(sr_rec->refcnt);
 		if (flags & SVC_RQST_FLAG_SREC_UNLOCK)
 			mutex_unlock(&sr_rec->mtx);
@@ -349,7 +350,7 @@ svc_rqst_new_evchan(uint32_t *chan_id /* OUT */, void *u_data, uint32_t flags)
 	TAILQ_INIT(&sr_rec->xprt_q);
 
 	t = rbtx_partition_of_scalar(&svc_rqst_set.xt, sr_rec->id_k);
-	mutex_lock(&t->mtx);
+	TIRPC_MUTEX_LOCK(&t->mtx, TIRPC_LOCK_RBTX);
 	rslt =
 	    rbtree_x_cached_insert(&svc_rqst_set.xt, t, &sr_rec->node_k,
 				   sr_rec->id_k);
@@ -376,10 +377,10 @@ static inline void
 evchan_unreg_impl(struct svc_rqst_rec *sr_rec, SVCXPRT *xprt, uint32_t flags)
 {
 	if (!(flags & SVC_RQST_FLAG_SREC_LOCKED))
-		mutex_lock(&sr_rec->mtx);
+		TIRPC_MUTEX_LOCK(&sr_rec->mtx, TIRPC_LOCK_EVCHAN);
 
 	if (!(flags & SVC_RQST_FLAG_LOCKED))
-		mutex_lock(&xprt->xp_lock);
+		TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	TAILQ_REMOVE(&sr_rec->xprt_q, xprt, xp_evq);
 
@@ -444,7 +445,7 @@ sr_rec_release(struct svc_rqst_rec *sr_rec, uint32_t flags)
 	uint32_t refcnt;
 
 	if (!(flags & SVC_RQST_FLAG_SREC_LOCKED))
-		mutex_lock(&sr_rec->mtx);
+		TIRPC_MUTEX_LOCK(&sr_rec->mtx, TIRPC_LOCK_EVCHAN);
 
 	refcnt = --(sr_rec->refcnt);
 
@@ -562,7 +563,7 @@ svc_rqst_evchan_reg(uint32_t chan_id, SVCXPRT *xprt, uint32_t flags)
 		goto out;
 	}
 
-	mutex_lock(&xprt->xp_lock);
+	TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	if (flags & SVC_RQST_FLAG_XPRT_UREG) {
 		if (chan_id != __svc_params->ev_u.evchan.id) {
@@ -684,9 +685,10 @@ svc_rqst_unhook_events(SVCXPRT *xprt /* LOCKED */ ,
 }
 
 int
-svc_rqst_rearm_events(SVCXPRT *xprt, uint32_t __attribute__ ((unused)) flags)
+svc_rqst_rearm_events(SVCXPRT *xprt, uint32_t flags)
 {
 	struct svc_rqst_rec *sr_rec;
+	bool parked = false;
 	int code;
 
 	cond_init_svc_rqst();
@@ -700,7 +702,19 @@ svc_rqst_rearm_events(SVCXPRT *xprt, uint32_t __attribute__ ((unused)) flags)
 	/* MUST follow the destroyed check above */
 	assert(sr_rec);
 
-	mutex_lock(&sr_rec->mtx);
+	/* replies backlogged, re-armed by svc_ioq once they drain */
+	if (unlikely(__svc_params->flags & SVC_FLAG_IOQ_BACKLOG)
+	    && xprt->xp_type == XPRT_TCP && svc_ioq_throttle_rearm(xprt))
+		goto out;
+
+	/* over the memory budget, armed only for hangups until svc_mem
+	 * re-arms it */
+	if (unlikely(__svc_params->flags & SVC_FLAG_MEM_BUDGET)
+	    && xprt->xp_type != XPRT_TCP_RENDEZVOUS
+	    && !(flags & SVC_RQST_FLAG_MEM_RESUME))
+		parked = svc_mem_pause_rearm(xprt);
+
+	TIRPC_MUTEX_LOCK(&sr_rec->mtx, TIRPC_LOCK_EVCHAN);
 	if (atomic_fetch_uint16_t(&xprt->xp_flags) & SVC_XPRT_FLAG_ADDED) {
 
 		switch (sr_rec->ev_type) {
@@ -711,7 +725,8 @@ svc_rqst_rearm_events(SVCXPRT *xprt, uint32_t __attribute__ ((unused)) flags)
 
 			/* set up epoll user data */
 			/* ev->data.ptr = xprt; *//* XXX already set */
-			ev->events = EPOLLIN | EPOLLONESHOT;
+			ev->events = (parked ? EPOLLRDHUP : EPOLLIN)
+				   | EPOLLONESHOT;
 
 			/* rearm in epoll vector */
 			code = epoll_ctl(sr_rec->ev_u.epoll.epoll_fd,
@@ -904,6 +919,21 @@ svc_rqst_handle_event(struct svc_rqst_rec *sr_rec, struct epoll_event *ev,
 			/* take extra ref, callout will release */
 			SVC_REF(xprt, SVC_REF_FLAG_NONE);
 
+			/* only MSG_ZEROCOPY completions, nothing to read */
+			if (unlikely(ev->events & EPOLLERR)
+			    && !(ev->events & (EPOLLIN | EPOLLHUP))
+			    && svc_ioq_zerocopy_reap(xprt)) {
+				(void)svc_rqst_rearm_events(xprt,
+							    SVC_RQST_FLAG_NONE);
+				SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+				return;
+			}
+
+			if (unlikely(__svc_params->flags
+				     & (SVC_FLAG_HISTOGRAMS
+					| SVC_FLAG_SLOW_REQUESTS)))
+				svc_hist_wakeup(xprt);
+
 			/* ! LOCKED */
 			code = xprt->xp_ops->xp_getreq(xprt);
 			__warnx(TIRPC_DEBUG_FLAG_REFCNT,
@@ -942,7 +972,7 @@ svc_rqst_thrd_run_epoll(struct svc_rqst_rec *sr_rec, uint32_t
 
 	for (;;) {
 
-		mutex_lock(&sr_rec->mtx);
+		TIRPC_MUTEX_LOCK(&sr_rec->mtx, TIRPC_LOCK_EVCHAN);
 
 		++(wakeups);
 
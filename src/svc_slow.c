@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * svc_slow.c
+ * Slow request watchdog.
+ *
+ * A call claims its slot by hashing the xid and probing a few neighbours
+ * with compare and swap, so workers only meet on a collision.  Stages are
+ * plain stores into the slot.  The watchdog copies a slot, and keeps the
+ * copy only if the slot still holds the same call afterwards.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/svc_slow.h>
+#include <rpc/svc_stats.h>
+#include <misc/abstract_atomic.h>
+
+#include "svc_internal.h"
+#include "rpc_ring.h"
+
+#define SVC_SLOW_SLOTS 4096	/* power of two */
+#define SVC_SLOW_PROBES 8
+
+enum svc_slow_state {
+	SVC_SLOW_FREE,
+	SVC_SLOW_CLAIMED,	/* being filled */
+	SVC_SLOW_READY
+};
+
+struct svc_slow_slot {
+	uint64_t ts[SVC_SLOW_STAGES];	/* monotonic nanoseconds, or 0 */
+	uint64_t reported;	/* received stamp of the call last logged */
+	const void *xprt;	/* logged, never dereferenced */
+	uint32_t state;
+	uint32_t xid;
+	uint32_t prog;
+	uint32_t vers;
+	uint32_t proc;
+	uint32_t tid;		/* dispatched by */
+	int fd;
+} __attribute__ ((aligned(64)));
+
+static struct svc_slow_slot svc_slow_slots[SVC_SLOW_SLOTS];
+
+static struct {
+	mutex_t mtx;
+	pthread_t thread;
+	uint64_t threshold;	/* nanoseconds */
+	u_int period;		/* milliseconds between scans */
+	uint32_t running;
+} svc_slow_st = {
+	MUTEX_INITIALIZER, 0, 0, 0, 0
+};
+
+/* named for the interval that ends at each stage */
+static const char *svc_slow_names[SVC_SLOW_STAGES] = {
+	"-",
+	"queue",
+	"auth",
+	"service",
+	"flush",
+};
+
+/* now is 0 for a completed call, else the open interval runs until now */
+static void
+svc_slow_log(const struct svc_slow_slot *s, uint64_t now)
+{
+	char usec[SVC_SLOW_STAGES][24];
+	const char *state = "done";
+	u_int last = 0;
+	u_int from = SVC_SLOW_QUEUED;
+	u_int ix;
+
+	for (ix = SVC_SLOW_RECEIVED; ix < SVC_SLOW_STAGES; ++ix)
+		if (s->ts[ix])
+			last = ix;
+
+	for (ix = SVC_SLOW_RECEIVED; ix < SVC_SLOW_STAGES; ++ix) {
+		if (s->ts[ix]) {
+			snprintf(usec[ix], sizeof(usec[ix]), "%" PRIu64,
+				 (s->ts[ix] - s->ts[from]) / 1000);
+			from = ix;
+		} else if (now && ix == last + 1) {
+			snprintf(usec[ix], sizeof(usec[ix]), "%" PRIu64,
+				 (now - s->ts[from]) / 1000);
+			state = svc_slow_names[ix];
+		} else {
+			strcpy(usec[ix], "-");
+		}
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_EVENT,
+		"slow request %s xprt %p fd %d xid %" PRIu32 " %" PRIu32
+		"/%" PRIu32 "/%" PRIu32 " queue %s auth %s service %s flush %s"
+		" tid %" PRIu32,
+		state, s->xprt, s->fd, s->xid, s->prog, s->vers, s->proc,
+		usec[SVC_SLOW_RECEIVED], usec[SVC_SLOW_DISPATCHED],
+		usec[SVC_SLOW_REPLIED], usec[SVC_SLOW_FLUSHED], s->tid);
+}
+
+/* called with each decoded call */
+void
+svc_slow_start(SVCXPRT *xprt, struct svc_req *req)
+{
+	struct svc_slow_slot *s;
+	uint64_t now = rpc_now_ns();
+	uint64_t wakeup = xprt->xp_wakeup;
+	uint32_t hash = req->rq_xid * 2654435761U;
+	u_int probe, ix;
+
+	for (probe = 0; probe < SVC_SLOW_PROBES; ++probe) {
+		ix = ((hash >> 20) + probe) & (SVC_SLOW_SLOTS - 1);
+		s = &svc_slow_slots[ix];
+		if (atomic_fetch_uint32_t(&s->state) == SVC_SLOW_FREE
+		    && __sync_bool_compare_and_swap(&s->state, SVC_SLOW_FREE,
+						    SVC_SLOW_CLAIMED))
+			goto claimed;
+	}
+	svc_stats_add(SVC_STAT_SLOW_UNTRACKED, 1);
+	return;
+
+ claimed:
+	/* the first call after a wakeup, and any batched behind it */
+	s->ts[SVC_SLOW_QUEUED] = (wakeup && wakeup <= now) ? wakeup : now;
+	s->ts[SVC_SLOW_RECEIVED] = now;
+	s->ts[SVC_SLOW_DISPATCHED] = 0;
+	s->ts[SVC_SLOW_REPLIED] = 0;
+	s->ts[SVC_SLOW_FLUSHED] = 0;
+	s->xprt = xprt;
+	s->fd = xprt->xp_fd;
+	s->xid = req->rq_xid;
+	s->prog = req->rq_prog;
+	s->vers = req->rq_vers;
+	s->proc = req->rq_proc;
+	s->tid = 0;
+	atomic_store_uint32_t(&s->state, SVC_SLOW_READY);
+	req->rq_msg->rm_slow = ix + 1;
+}
+
+void
+svc_slow_mark(uint32_t slot, u_int stage)
+{
+	struct svc_slow_slot *s = &svc_slow_slots[slot - 1];
+
+	if (stage == SVC_SLOW_DISPATCHED)
+		s->tid = rpc_gettid();
+	atomic_store_uint64_t(&s->ts[stage], rpc_now_ns());
+}
+
+void
+svc_slow_stage(struct svc_req *req, enum svc_slow_stage stage)
+{
+	if (req->rq_msg && req->rq_msg->rm_slow && stage < SVC_SLOW_STAGES)
+		svc_slow_mark(req->rq_msg->rm_slow, stage);
+}
+
+void
+svc_slow_end(uint32_t slot)
+{
+	struct svc_slow_slot *s = &svc_slow_slots[slot - 1];
+
+	if (unlikely(rpc_now_ns() - s->ts[SVC_SLOW_QUEUED]
+		     >= svc_slow_st.threshold)) {
+		/* counted once, here or by the watchdog */
+		if (atomic_fetch_uint64_t(&s->reported)
+		    != s->ts[SVC_SLOW_RECEIVED])
+			svc_stats_add(SVC_STAT_SLOW_REQUESTS, 1);
+		svc_slow_log(s, 0);
+	}
+	atomic_store_uint32_t(&s->state, SVC_SLOW_FREE);
+}
+
+static void
+svc_slow_scan(uint64_t now)
+{
+	struct svc_slow_slot copy;
+	struct svc_slow_slot *s;
+	uint64_t received;
+	u_int ix;
+
+	for (ix = 0; ix < SVC_SLOW_SLOTS; ++ix) {
+		s = &svc_slow_slots[ix];
+		if (atomic_fetch_uint32_t(&s->state) != SVC_SLOW_READY)
+			continue;
+		received = atomic_fetch_uint64_t(&s->ts[SVC_SLOW_RECEIVED]);
+		if (s->reported == received)
+			continue;
+
+		memcpy(&copy, s, sizeof(copy));
+		if (atomic_fetch_uint32_t(&s->state) != SVC_SLOW_READY
+		    || atomic_fetch_uint64_t(&s->ts[SVC_SLOW_RECEIVED])
+		       != received)
+			continue;	/* completed, or another call */
+
+		/* started after this scan did */
+		if (copy.ts[SVC_SLOW_QUEUED] >= now
+		    || now - copy.ts[SVC_SLOW_QUEUED] < svc_slow_st.threshold)
+			continue;
+
+		atomic_store_uint64_t(&s->reported, received);
+		svc_stats_add(SVC_STAT_SLOW_REQUESTS, 1);
+		svc_slow_log(&copy, now);
+	}
+}
+
+static void *
+svc_slow_thread(void *arg)
+{
+	while (atomic_fetch_uint32_t(&svc_slow_st.running)) {
+		(void)poll(NULL, 0, svc_slow_st.period);
+		svc_slow_scan(rpc_now_ns());
+	}
+	return (NULL);
+}
+
+bool
+svc_slow_init(u_int msec)
+{
+	int rc;
+
+	mutex_lock(&svc_slow_st.mtx);
+	if (svc_slow_st.running) {
+		mutex_unlock(&svc_slow_st.mtx);
+		return (true);
+	}
+
+	memset(svc_slow_slots, 0, sizeof(svc_slow_slots));
+	svc_slow_st.threshold = msec * 1000000ULL;
+
+	/* a call is logged within a quarter of the threshold past it */
+	svc_slow_st.period = msec / 4;
+	if (svc_slow_st.period < 10)
+		svc_slow_st.period = 10;
+	else if (svc_slow_st.period > 1000)
+		svc_slow_st.period = 1000;
+
+	svc_slow_st.running = 1;
+	rc = pthread_create(&svc_slow_st.thread, NULL, svc_slow_thread, NULL);
+	if (rc) {
+		svc_slow_st.running = 0;
+		mutex_unlock(&svc_slow_st.mtx);
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s() watchdog thread failed: %s (%d)",
+			__func__, strerror(rc), rc);
+		return (false);
+	}
+	mutex_unlock(&svc_slow_st.mtx);
+	return (true);
+}
+
+void
+svc_slow_shutdown(void)
+{
+	mutex_lock(&svc_slow_st.mtx);
+	if (svc_slow_st.running) {
+		atomic_store_uint32_t(&svc_slow_st.running, 0);
+		pthread_join(svc_slow_st.thread, NULL);
+	}
+	mutex_unlock(&svc_slow_st.mtx);
+}
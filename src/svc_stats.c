@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * svc_stats.c
+ * Service counters, and the Unix socket that serves them.
+ *
+ * Each CPU adds into its own cache line, so the hot paths never share
+ * one; a thread that migrates between getting its CPU and adding only
+ * costs a contended add.  Gauges are read when a snapshot is taken.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/svc_stats.h>
+#include <rpc/svc_mem.h>
+#include <rpc/lock_stat.h>
+#include <rpc/work_pool.h>
+#include <misc/abstract_atomic.h>
+
+#include "clnt_internal.h"
+#include "svc_internal.h"
+#include "svc_xprt.h"
+
+#define SVC_STATS_CPUS 64
+#define SVC_STATS_POLL_MS 1000
+
+struct svc_stats_cpu {
+	uint64_t counter[SVC_STAT_COUNTERS];
+} __attribute__ ((aligned(64)));
+
+static struct svc_stats_cpu svc_stats_cpu[SVC_STATS_CPUS];
+
+static const char *svc_stats_names[SVC_STAT_COUNTERS] = {
+	"requests",
+	"rx_bytes",
+	"tx_bytes",
+	"recv_errors",
+	"auth_errors",
+	"send_errors",
+	"drc_hits",
+	"drc_misses",
+	"gss_hits",
+	"gss_misses",
+	"slow_requests",
+	"slow_untracked",
+	"ioq_throttled",
+	"ioq_rearm_deferred",
+	"ioq_rearm_resumed",
+	"mem_over_budget",
+	"mem_rearm_paused",
+	"mem_conn_shed",
+	"mem_rearm_probed",
+};
+
+static struct {
+	mutex_t mtx;
+	pthread_t thread;
+	int fd;
+	uint32_t running;
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+} svc_stats_st = {
+	MUTEX_INITIALIZER, 0, -1, 0, ""
+};
+
+#ifndef HAVE_SCHED_GETCPU
+static uint32_t svc_stats_threads;
+static __thread uint32_t svc_stats_slot = UINT32_MAX;
+#endif
+
+void
+svc_stats_add(enum svc_stat stat, uint64_t n)
+{
+	u_int slot;
+#ifdef HAVE_SCHED_GETCPU
+	int cpu;
+#endif
+
+	if (likely(!(__svc_params->flags & SVC_FLAG_STATS)))
+		return;
+
+#ifdef HAVE_SCHED_GETCPU
+	cpu = sched_getcpu();
+
+	slot = (cpu < 0) ? 0 : cpu % SVC_STATS_CPUS;
+#else
+	if (unlikely(svc_stats_slot == UINT32_MAX))
+		svc_stats_slot = atomic_inc_uint32_t(&svc_stats_threads)
+				 % SVC_STATS_CPUS;
+	slot = svc_stats_slot;
+#endif
+	atomic_add_uint64_t(&svc_stats_cpu[slot].counter[stat], n);
+}
+
+const char *
+svc_stats_name(enum svc_stat stat)
+{
+	if (stat >= SVC_STAT_COUNTERS)
+		return (NULL);
+	return (svc_stats_names[stat]);
+}
+
+/* from svc_xprt_foreach_locked(), which keeps xp_p1 alive */
+static struct x_vc_data *
+svc_stats_xprt_vc(SVCXPRT *xprt)
+{
+	if (xprt->xp_type != XPRT_TCP || !xprt->xp_p1)
+		return (NULL);
+	return ((struct x_vc_data *)xprt->xp_p1);
+}
+
+static uint32_t
+svc_stats_each(SVCXPRT *xprt, void *arg)
+{
+	struct svc_stats *stats = arg;
+	struct x_vc_data *xd = svc_stats_xprt_vc(xprt);
+
+	stats->xprts++;
+	if (!xd)
+		return (SVC_XPRT_FOREACH_NONE);
+
+	stats->ioq_queued += xd->shared.ioq.qcount;
+	if (xd->shared.ioq.qcount > stats->ioq_max)
+		stats->ioq_max = xd->shared.ioq.qcount;
+	stats->ioq_bytes += xd->shared.ioq_bytes;
+	if (xd->shared.throttled)
+		stats->ioq_throttled++;
+	return (SVC_XPRT_FOREACH_NONE);
+}
+
+void
+svc_stats_get(struct svc_stats *stats)
+{
+	struct work_pool *pool = &svc_work_pool;
+	int32_t qcount;
+	u_int cx, sx;
+
+	memset(stats, 0, sizeof(*stats));
+	for (cx = 0; cx < SVC_STATS_CPUS; ++cx)
+		for (sx = 0; sx < SVC_STAT_COUNTERS; ++sx)
+			stats->counter[sx] += atomic_fetch_uint64_t(
+				&svc_stats_cpu[cx].counter[sx]);
+
+	/* negative for idle workers, positive for queued tasks */
+	pthread_mutex_lock(&pool->pqh.qmutex);
+	qcount = pool->pqh.qcount;
+	stats->pool_threads = pool->n_threads;
+	pthread_mutex_unlock(&pool->pqh.qmutex);
+	if (qcount < 0)
+		stats->pool_idle = -qcount;
+	else
+		stats->pool_queued = qcount;
+
+	svc_xprt_foreach_locked(svc_stats_each, stats);
+}
+
+static uint32_t
+svc_stats_print_xprt(SVCXPRT *xprt, void *arg)
+{
+	static const char *types[] = {
+		"unknown", "udp", "tcp", "tcp_rendezvous", "sctp", "rdma"
+	};
+	struct x_vc_data *xd = svc_stats_xprt_vc(xprt);
+
+	fprintf((FILE *)arg, "xprt %d %s %" PRIu32 " %" PRIu64 " %d\n",
+		xprt->xp_fd,
+		(xprt->xp_type <= XPRT_RDMA) ? types[xprt->xp_type] : "unknown",
+		xd ? (uint32_t)xd->shared.ioq.qcount : 0,
+		xd ? xd->shared.ioq_bytes : 0,
+		xd ? xd->shared.throttled : 0);
+	return (SVC_XPRT_FOREACH_NONE);
+}
+
+static void
+svc_stats_send(int fd)
+{
+	struct svc_stats stats;
+	struct svc_mem_stats mem;
+	char *buf = NULL;
+	size_t len = 0;
+	size_t off;
+	ssize_t n;
+	FILE *fp;
+	u_int ix;
+
+	fp = open_memstream(&buf, &len);
+	if (!fp)
+		return;
+
+	svc_stats_get(&stats);
+	for (ix = 0; ix < SVC_STAT_COUNTERS; ++ix)
+		fprintf(fp, "%s %" PRIu64 "\n", svc_stats_names[ix],
+			stats.counter[ix]);
+	fprintf(fp, "xprts %" PRIu32 "\n"
+		"work_pool_threads %" PRIu32 "\n"
+		"work_pool_idle %" PRIu32 "\n"
+		"work_pool_queued %" PRIu32 "\n"
+		"ioq_queued %" PRIu32 "\n"
+		"ioq_max %" PRIu32 "\n"
+		"ioq_bytes %" PRIu64 "\n"
+		"xprts_throttled %" PRIu32 "\n",
+		stats.xprts, stats.pool_threads, stats.pool_idle,
+		stats.pool_queued, stats.ioq_queued, stats.ioq_max,
+		stats.ioq_bytes, stats.ioq_throttled);
+
+	svc_mem_get(&mem);
+	for (ix = 0; ix < SVC_MEM_CATS; ++ix)
+		fprintf(fp, "mem_%s %" PRId64 "\n", svc_mem_name(ix),
+			mem.bytes[ix]);
+	fprintf(fp, "mem_total %" PRId64 "\n"
+		"mem_budget %" PRIu64 "\n"
+		"mem_over %d\n",
+		mem.total, mem.budget, mem.over);
+	svc_xprt_foreach_locked(svc_stats_print_xprt, fp);
+	tirpc_lock_stat_dump(fp);
+	fclose(fp);
+
+	for (off = 0; off < len; off += n) {
+		n = write(fd, buf + off, len - off);
+		if (n < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			break;
+		}
+	}
+	free(buf);
+}
+
+/**
+ * svc_stats_thread: unix socket thread
+ *
+ * One snapshot per connection.
+ */
+static void *
+svc_stats_thread(void *arg)
+{
+	struct pollfd pfd;
+	int childfd;
+	int n;
+
+	pfd.fd = svc_stats_st.fd;
+	pfd.events = POLLIN;
+
+	while (atomic_fetch_uint32_t(&svc_stats_st.running)) {
+		pfd.revents = 0;
+		n = poll(&pfd, 1, SVC_STATS_POLL_MS);
+		if (n <= 0) {
+			if (n == 0 || errno == EINTR)
+				continue;
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s() poll failed: %s (%d)",
+				__func__, strerror(errno), errno);
+			break;
+		}
+
+		childfd = accept(pfd.fd, NULL, NULL);
+		if (childfd == -1) {
+			if (errno != EINTR)
+				__warnx(TIRPC_DEBUG_FLAG_ERROR,
+					"%s() accept on stats socket failed: %s (%d)",
+					__func__, strerror(errno), errno);
+			continue;
+		}
+		svc_stats_send(childfd);
+		close(childfd);
+	}
+
+	return (NULL);
+}
+
+bool
+svc_stats_listen(const char *path)
+{
+	struct sockaddr_un sockaddr;
+	int fd;
+	int rc;
+
+	if (!path || strlen(path) >= sizeof(sockaddr.sun_path))
+		return (false);
+
+	mutex_lock(&svc_stats_st.mtx);
+	if (svc_stats_st.running) {
+		mutex_unlock(&svc_stats_st.mtx);
+		return (false);
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		rc = errno;
+		goto err;
+	}
+
+	memset(&sockaddr, 0, sizeof(sockaddr));
+	sockaddr.sun_family = AF_UNIX;
+	strcpy(sockaddr.sun_path, path);
+	unlink(sockaddr.sun_path);
+
+	if (bind(fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) == -1
+	    || listen(fd, 5) == -1) {
+		rc = errno;
+		close(fd);
+		goto err;
+	}
+
+	svc_stats_st.fd = fd;
+	strcpy(svc_stats_st.path, path);
+	svc_stats_st.running = 1;
+	rc = pthread_create(&svc_stats_st.thread, NULL, svc_stats_thread,
+			    NULL);
+	if (rc) {
+		svc_stats_st.running = 0;
+		svc_stats_st.fd = -1;
+		close(fd);
+		unlink(path);
+		goto err;
+	}
+	/* counting starts now, if svc_init() did not start it */
+	(void)__sync_fetch_and_or(&__svc_params->flags, SVC_FLAG_STATS);
+	mutex_unlock(&svc_stats_st.mtx);
+	return (true);
+
+ err:
+	mutex_unlock(&svc_stats_st.mtx);
+	__warnx(TIRPC_DEBUG_FLAG_ERROR,
+		"%s() stats socket %s failed: %s (%d)",
+		__func__, path, strerror(rc), rc);
+	return (false);
+}
+
+void
+svc_stats_shutdown(void)
+{
+	mutex_lock(&svc_stats_st.mtx);
+	if (svc_stats_st.running) {
+		atomic_store_uint32_t(&svc_stats_st.running, 0);
+		pthread_join(svc_stats_st.thread, NULL);
+		close(svc_stats_st.fd);
+		unlink(svc_stats_st.path);
+		svc_stats_st.fd = -1;
+	}
+	mutex_unlock(&svc_stats_st.mtx);
+}
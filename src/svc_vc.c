@@ -67,12 +67,17 @@
 #include "rpc_com.h"
 #include "clnt_internal.h"
 #include "svc_internal.h"
+#include "rpc_ring.h"
 #include "svc_xprt.h"
 #include "rpc_dplx_internal.h"
 #include "rpc_ctx.h"
 #include <rpc/svc_rqst.h>
 #include <rpc/xdr_inrec.h>
 #include <rpc/xdr_ioq.h>
+#include <rpc/trace.h>
+#include <rpc/span.h>
+#include <rpc/svc_slow.h>
+#include <rpc/svc_mem.h>
 #include <getpeereid.h>
 #include "svc_ioq.h"
 
@@ -541,6 +546,14 @@ rendezvous_request(SVCXPRT *xprt, struct svc_req *req)
 		return (FALSE);
 	}
 
+	/* over the memory budget, shed new connections */
+	if (unlikely(__svc_params->flags & SVC_FLAG_MEM_BUDGET)
+	    && svc_mem_over()) {
+		(void)close(fd);
+		svc_stats_add(SVC_STAT_MEM_SHED, 1);
+		return (FALSE);
+	}
+
 	(void) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &n, sizeof(n));
 
 	/*
@@ -585,6 +598,9 @@ rendezvous_request(SVCXPRT *xprt, struct svc_req *req)
 	xd->shared.sendsz = rdvs->sendsize;
 	xd->sx.maxrec = rdvs->maxrec;
 
+	if (__svc_params->flags & SVC_FLAG_ZEROCOPY)
+		xd->shared.zerocopy = svc_ioq_zerocopy_enable(fd);
+
 #if 0  /* XXX vrec wont support atm (and it seems to need work) */
 	if (cd->maxrec != 0) {
 		flags = fcntl(fd, F_GETFL, 0);
@@ -865,6 +881,14 @@ svc_vc_stat(SVCXPRT *xprt)
 	if (xd->sx.strm_stat == XPRT_DIED)
 		return (XPRT_DIED);
 
+	/* replies backlogged or memory over budget, finish what was read
+	 * but read no more */
+	if (unlikely(xd->shared.throttled)
+	    || (unlikely(__svc_params->flags & SVC_FLAG_MEM_BUDGET)
+		&& svc_mem_over()))
+		return (xdr_inrec_buffered(&(xd->shared.xdrs_in))
+			? XPRT_MOREREQS : XPRT_IDLE);
+
 	if (!xdr_inrec_eof(&(xd->shared.xdrs_in)))
 		return (XPRT_MOREREQS);
 
@@ -876,6 +900,11 @@ svc_vc_recv(SVCXPRT *xprt, struct svc_req *req)
 {
 	struct x_vc_data *xd = (struct x_vc_data *)xprt->xp_p1;
 	XDR *xdrs = &(xd->shared.xdrs_in);	/* recv queue */
+	uint64_t span = 0;
+
+	TIRPC_TRACE(TIRPC_TRACE_RECV, xprt, 0, 0);
+	if (unlikely(__ntirpc_span_rate))
+		span = rpc_now_ns();
 
 	/* XXX assert(! cd->nonblock) */
 	if (xd->shared.nonblock) {
@@ -907,6 +936,18 @@ svc_vc_recv(SVCXPRT *xprt, struct svc_req *req)
 			req->rq_vers = req->rq_msg->rm_call.cb_vers;
 			req->rq_proc = req->rq_msg->rm_call.cb_proc;
 			req->rq_xid = req->rq_msg->rm_xid;
+			TIRPC_TRACE(TIRPC_TRACE_DECODE, xprt, req->rq_xid,
+				    req->rq_proc);
+			if (unlikely(span) && tirpc_span_sampled(req->rq_xid))
+				TIRPC_SPAN_END(TIRPC_SPAN_RECEIVE, xprt,
+					       req->rq_xid, req->rq_proc, span);
+			svc_stats_add(SVC_STAT_REQUESTS, 1);
+			if (unlikely(__svc_params->flags
+				     & SVC_FLAG_SLOW_REQUESTS))
+				svc_slow_start(xprt, req);
+			if (unlikely(__svc_params->flags
+				     & SVC_FLAG_HISTOGRAMS))
+				svc_hist_received(xprt, req);
 			return (TRUE);
 			break;
 		case REPLY:
@@ -923,6 +964,7 @@ svc_vc_recv(SVCXPRT *xprt, struct svc_req *req)
 	}
 	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
 		"%s: xdr_dplx_msg_decode failed (will set dead)", __func__);
+	svc_stats_add(SVC_STAT_RECV_ERRORS, 1);
 	return (FALSE);
 }
 
@@ -956,6 +998,30 @@ svc_vc_getargs(SVCXPRT *xprt, struct svc_req *req,
 	return (rslt);
 }
 
+/*
+ * Encoded length of a reply, by a counting pass over the unwrapped
+ * results.  SVCAUTH_WRAP is never called here: RPCSEC_GSS integrity and
+ * privacy advance sequence and checksum state as they wrap, and their
+ * replies are not sized.  Every other flavor encodes the results as is.
+ * Zero if it could not be sized.
+ */
+static u_int
+svc_vc_reply_size(struct svc_req *req, struct rpc_msg *msg, bool has_args,
+		  xdrproc_t xdr_results, caddr_t xdr_location)
+{
+	XDR xdrs[1];
+	u_int size = 0;
+
+	xdrsize_create(xdrs);
+	if (xdr_replymsg(xdrs, msg)
+	    && (!has_args
+		|| (req->rq_auth
+		    && (*xdr_results) (xdrs, xdr_location))))
+		size = XDR_GETPOS(xdrs);
+	XDR_DESTROY(xdrs);
+	return (size);
+}
+
 static bool
 svc_vc_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 {
@@ -966,6 +1032,7 @@ svc_vc_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 	bool rstat = false;
 	bool has_args;
 	bool gss;
+	uint64_t span = tirpc_span_begin(req->rq_xid);
 
 	if (msg->rm_reply.rp_stat == MSG_ACCEPTED
 	    && msg->rm_reply.rp_acpt.ar_stat == SUCCESS) {
@@ -989,11 +1056,24 @@ svc_vc_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 	 * an equivalent for Windows.
 	 */
 	gss = (req->rq_cred.oa_flavor == RPCSEC_GSS);
-	xdrs_2 = xdr_ioq_create(8192 /* default segment size */ ,
-				__svc_params->svc_ioq_maxbuf + 8192,
-				gss
-				? UIO_FLAG_REALLOC | UIO_FLAG_FREE
-				: UIO_FLAG_FREE);
+	xdrs_2 = NULL;
+	/* sized unwrapped, so never for RPCSEC_GSS */
+	if (!gss && (__svc_params->flags & SVC_FLAG_REPLY_SIZED)) {
+		u_int size = svc_vc_reply_size(req, msg, has_args, xdr_results,
+					       xdr_location);
+
+		if (size)
+			xdrs_2 = xdr_ioq_create_sized(size,
+					8192 /* default segment size */ ,
+					__svc_params->svc_ioq_maxbuf,
+					UIO_FLAG_FREE);
+	}
+	if (!xdrs_2)
+		xdrs_2 = xdr_ioq_create(8192 /* default segment size */ ,
+					__svc_params->svc_ioq_maxbuf + 8192,
+					gss
+					? UIO_FLAG_REALLOC | UIO_FLAG_FREE
+					: UIO_FLAG_FREE);
 	if (xdr_replymsg(xdrs_2, msg)
 	    && (!has_args
 		|| (req->rq_auth
@@ -1001,6 +1081,22 @@ svc_vc_reply(SVCXPRT *xprt, struct svc_req *req, struct rpc_msg *msg)
 				    xdr_location)))) {
 		rstat = TRUE;
 	}
+	TIRPC_TRACE(TIRPC_TRACE_REPLY, xprt, msg->rm_xid, rstat);
+	if (unlikely(__svc_params->flags & SVC_FLAG_HISTOGRAMS))
+		svc_hist_enqueued(req, xdrs_2);
+	if (unlikely(span)) {
+		TIRPC_SPAN_END(TIRPC_SPAN_REPLY, xprt, req->rq_xid, rstat,
+			       span);
+		/* flush span, from here until written */
+		XIOQ(xdrs_2)->ioq_span = rpc_now_ns();
+		XIOQ(xdrs_2)->ioq_xid = req->rq_xid;
+	}
+	if (unlikely(req->rq_msg && req->rq_msg->rm_slow)) {
+		/* ended by the flush */
+		svc_slow_mark(req->rq_msg->rm_slow, SVC_SLOW_REPLIED);
+		XIOQ(xdrs_2)->ioq_slow = req->rq_msg->rm_slow;
+		req->rq_msg->rm_slow = 0;
+	}
 	svc_ioq_append(xprt, xd, xdrs_2);
 	return (rstat);
 }
@@ -1161,7 +1257,7 @@ svc_clean_idle2_func(SVCXPRT *xprt, void *arg)
 	if (!acc->cleanblock)
 		goto out;
 
-	mutex_lock(&xprt->xp_lock);
+	TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	/* invalid xprt (error) */
 	if (xprt->xp_ops == NULL)
@@ -1268,7 +1364,7 @@ clnt_vc_ncreate_svc(SVCXPRT *xprt, const rpcprog_t prog,
 	struct x_vc_data *xd;
 	CLIENT *clnt;
 
-	mutex_lock(&xprt->xp_lock);
+	TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	xd = (struct x_vc_data *)xprt->xp_p1;
 
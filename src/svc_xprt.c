@@ -128,7 +128,7 @@ svc_xprt_get(int fd)
 	sk.xp_fd = fd;
 	t = rbtx_partition_of_scalar(&svc_xprt_fd.xt, fd);
 
-	rwlock_rdlock(&t->lock);
+	TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);
 	nv = opr_rbtree_lookup(&t->t, &sk.xp_fd_node);
 	rwlock_unlock(&t->lock);
 
@@ -149,11 +149,11 @@ svc_xprt_set(SVCXPRT *xprt, uint32_t flags)
 	cond_init_svc_xprt();
 
 	if (!(flags & SVC_XPRT_FLAG_LOCKED))
-		mutex_lock(&xprt->xp_lock);
+		TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	t = rbtx_partition_of_scalar(&svc_xprt_fd.xt, xprt->xp_fd);
 
-	rwlock_wrlock(&t->lock);
+	TIRPC_WRLOCK(&t->lock, TIRPC_LOCK_RBTX);
 
 	nv = opr_rbtree_insert(&t->t, &xprt->xp_fd_node);
 	if (nv) {
@@ -188,12 +188,12 @@ svc_xprt_clear(SVCXPRT *xprt, uint32_t flags)
 	cond_init_svc_xprt();
 
 	if (!(flags & SVC_XPRT_FLAG_LOCKED))
-		mutex_lock(&xprt->xp_lock);
+		TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 
 	if (opr_rbtree_node_valid(&xprt->xp_fd_node)) {
 		t = rbtx_partition_of_scalar(&svc_xprt_fd.xt, xprt->xp_fd);
 
-		rwlock_wrlock(&t->lock);
+		TIRPC_WRLOCK(&t->lock, TIRPC_LOCK_RBTX);
 		opr_rbtree_remove(&t->t, &xprt->xp_fd_node);
 		rwlock_unlock(&t->lock);
 	}
@@ -231,7 +231,7 @@ svc_xprt_foreach(svc_xprt_each_func_t each_f, void *arg)
 			return (1);
 
 		/* start with rlock */
-		rwlock_rdlock(&t->lock);	/* t RLOCKED */
+		TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);	/* t RLOCKED */
 		tgen = t->t.gen;
 		x_ix = 0;
 		n = opr_rbtree_first(&t->t);
@@ -250,7 +250,7 @@ svc_xprt_foreach(svc_xprt_each_func_t each_f, void *arg)
 				goto restart;
 
 			/* validate */
-			rwlock_rdlock(&t->lock);
+			TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);
 
 			if (tgen != t->t.gen) {
 				n = opr_rbtree_lookup(&t->t, &sk.xp_fd_node);
@@ -270,6 +270,33 @@ svc_xprt_foreach(svc_xprt_each_func_t each_f, void *arg)
 	return (0);
 }
 
+/*
+ * Call each_f on every xprt with its partition read locked, so neither
+ * the xprt nor its private data can be destroyed meanwhile.  each_f must
+ * not block, nor take xprt or partition locks; its result is ignored.
+ */
+void
+svc_xprt_foreach_locked(svc_xprt_each_func_t each_f, void *arg)
+{
+	struct rbtree_x_part *t;
+	struct opr_rbtree_node *n;
+	SVCXPRT *xprt;
+	int p_ix;
+
+	cond_init_svc_xprt();
+
+	for (p_ix = 0; p_ix < SVC_XPRT_PARTITIONS; p_ix++) {
+		t = &svc_xprt_fd.xt.tree[p_ix];
+		TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);	/* t RLOCKED */
+		for (n = opr_rbtree_first(&t->t); n != NULL;
+		     n = opr_rbtree_next(n)) {
+			xprt = opr_containerof(n, struct rpc_svcxprt, xp_fd_node);
+			(void)each_f(xprt, arg);
+		}		/* curr partition */
+		rwlock_unlock(&t->lock);	/* t !LOCKED */
+	}			/* SVC_XPRT_PARTITIONS */
+}
+
 void
 svc_xprt_dump_xprts(const char *tag)
 {
@@ -284,7 +311,7 @@ svc_xprt_dump_xprts(const char *tag)
 	p_ix = 0;
 	while (p_ix < SVC_XPRT_PARTITIONS) {
 		t = &svc_xprt_fd.xt.tree[p_ix];
-		rwlock_rdlock(&t->lock);	/* t RLOCKED */
+		TIRPC_RDLOCK(&t->lock, TIRPC_LOCK_RBTX);	/* t RLOCKED */
 		__warnx(TIRPC_DEBUG_FLAG_SVC_XPRT,
 			"xprts at %s: tree %d size %d", tag, p_ix, t->t.size);
 		n = opr_rbtree_first(&t->t);
@@ -324,7 +351,7 @@ svc_xprt_shutdown()
 			n = opr_rbtree_next(n);
 
 			/* prevent repeats, see svc_xprt_clear() */
-			mutex_lock(&xprt->xp_lock);
+			TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 			opr_rbtree_remove(&t->t, &xprt->xp_fd_node);
 			mutex_unlock(&xprt->xp_lock);
 
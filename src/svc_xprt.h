@@ -44,6 +44,7 @@ void svc_xprt_clear(SVCXPRT *, uint32_t);
 
 typedef uint32_t(*svc_xprt_each_func_t) (SVCXPRT *, void *);
 int svc_xprt_foreach(svc_xprt_each_func_t, void *);
+void svc_xprt_foreach_locked(svc_xprt_each_func_t, void *);
 
 void svc_xprt_dump_xprts(const char *);
 void svc_xprt_shutdown();
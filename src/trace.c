@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 The ntirpc Authors (see AUTHORS).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * trace.c
+ * Tracepoint records, kept in an rpc_ring.
+ */
+#include <config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <rpc/types.h>
+#include <reentrant.h>
+#include <misc/portable.h>
+#include <misc/abstract_atomic.h>
+#include <rpc/trace.h>
+
+#include "rpc_ring.h"
+
+uint32_t __ntirpc_trace_mask;
+
+static struct rpc_ring trace_ring =
+	RPC_RING_INITIALIZER(struct tirpc_trace_rec);
+
+void
+tirpc_trace_emit(u_int point, const void *obj, uint32_t xid, uint32_t arg)
+{
+	struct tirpc_trace_rec *rec;
+	uint64_t ts;
+	uint64_t pos;
+
+	if (unlikely(!rpc_ring_ready(&trace_ring)))
+		return;
+
+	ts = rpc_now_ns();
+	rec = rpc_ring_claim(&trace_ring, &pos);
+	rec->ts = ts;
+	rec->obj = obj;
+	rec->point = point;
+	rec->xid = xid;
+	rec->arg = arg;
+	rec->tid = rpc_gettid();
+	rpc_ring_publish(rec, pos);
+}
+
+bool
+tirpc_trace_enable(uint32_t mask, u_int nrecs)
+{
+	/* allocated before any point is enabled */
+	if (!rpc_ring_alloc(&trace_ring, nrecs))
+		return (false);
+	atomic_store_uint32_t(&__ntirpc_trace_mask, mask & TIRPC_TRACE_ALL);
+	return (true);
+}
+
+void
+tirpc_trace_disable(void)
+{
+	atomic_store_uint32_t(&__ntirpc_trace_mask, 0);
+}
+
+u_int
+tirpc_trace_read(struct tirpc_trace_rec *recs, u_int max, uint64_t *cursor)
+{
+	return (rpc_ring_read(&trace_ring, recs, max, cursor));
+}
@@ -51,6 +51,7 @@
 #include "svc_internal.h"
 #include "rpc_dplx_internal.h"
 #include "rpc_ctx.h"
+#include "svc_ioq.h"
 
 static inline int
 clnt_read_vc(XDR *xdrs, void *ctp, void *buf, int len)
@@ -123,7 +124,7 @@ clnt_write_vc(XDR *xdrs, void *ctp, void *buf, int len)
 static inline void
 cfconn_set_dead(SVCXPRT *xprt, struct x_vc_data *xd)
 {
-	mutex_lock(&xprt->xp_lock);
+	TIRPC_MUTEX_LOCK(&xprt->xp_lock, TIRPC_LOCK_XPRT);
 	xd->sx.strm_stat = XPRT_DIED;
 	mutex_unlock(&xprt->xp_lock);
 }
@@ -156,9 +157,11 @@ svc_read_vc(XDR *xdrs, void *ctp, void *buf, int len)
 			else
 				goto fatal_err;
 		}
-		if (len != 0)
+		if (len != 0) {
 			(void)clock_gettime(CLOCK_MONOTONIC_FAST,
 					    &xd->sx.last_recv);
+			svc_stats_add(SVC_STAT_RX_BYTES, len);
+		}
 		return len;
 	}
 
@@ -183,6 +186,7 @@ svc_read_vc(XDR *xdrs, void *ctp, void *buf, int len)
 	len = read(xprt->xp_fd, buf, (size_t) len);
 	if (len > 0) {
 		(void) clock_gettime(CLOCK_MONOTONIC_FAST, &xd->sx.last_recv);
+		svc_stats_add(SVC_STAT_RX_BYTES, len);
 		return (len);
 	}
 
@@ -287,6 +291,7 @@ vc_shared_destroy(struct x_vc_data *xd)
 	/* RECLOCKED */
 
 	if (ct->ct_closeit && ct->ct_fd != RPC_ANYFD) {
+		svc_ioq_zerocopy_linger(xd, ct->ct_fd);
 		(void)close(ct->ct_fd);
 		closed = true;
 	}
@@ -308,8 +313,10 @@ vc_shared_destroy(struct x_vc_data *xd)
 		rec->hdl.xprt = NULL;	/* unreachable */
 
 		if (!closed) {
-			if (xprt->xp_fd != RPC_ANYFD)
+			if (xprt->xp_fd != RPC_ANYFD) {
+				svc_ioq_zerocopy_linger(xd, xprt->xp_fd);
 				(void)close(xprt->xp_fd);
+			}
 		}
 
 		/* request socket */
@@ -328,6 +335,7 @@ vc_shared_destroy(struct x_vc_data *xd)
 			xprt->xp_ops->xp_free_user_data(xprt);
 		}
 
+		svc_hist_xprt_destroy(xprt);
 		mem_free(xprt, sizeof(SVCXPRT));
 	}
 
@@ -339,6 +347,9 @@ vc_shared_destroy(struct x_vc_data *xd)
 	if (xprt)
 		rpc_dplx_unref(rec, RPC_DPLX_FLAG_NONE);
 
+	/* segments still held for MSG_ZEROCOPY */
+	svc_ioq_zerocopy_destroy(xd);
+
 	/* free xd itself */
 	mem_free(xd, sizeof(struct x_vc_data));
 }
@@ -56,6 +56,8 @@
 #include <intrinsic.h>
 
 #include <rpc/work_pool.h>
+#include <rpc/trace.h>
+#include <rpc/lock_stat.h>
 
 #define WORK_POOL_STACK_SIZE MAX(64 * 1024, PTHREAD_STACK_MIN)
 #define WORK_POOL_TIMEOUT_MS (120000)
@@ -190,14 +192,12 @@ work_pool_thread(void *arg)
 				(void)work_pool_spawn(pool);
 			}
 	
-			__warnx(TIRPC_DEBUG_FLAG_EVENT,
-				"%s() %s task %p",
-				__func__, pool->name, wpt->work);
+			TIRPC_TRACE(TIRPC_TRACE_TASK, wpt->work, 0, 0);
 			wpt->work->fun(wpt->work);
 			wpt->work = NULL;
 		}
 
-		pthread_mutex_lock(&pool->pqh.qmutex);
+		TIRPC_MUTEX_LOCK(&pool->pqh.qmutex, TIRPC_LOCK_POOL);
 
 		if (0 < pool->pqh.qcount--) {
 			/* positive for task(s) */
@@ -212,9 +212,7 @@ work_pool_thread(void *arg)
 			 */
 			TAILQ_INSERT_TAIL(&pool->pqh.qh, &wpt->pqe, q);
 
-			__warnx(TIRPC_DEBUG_FLAG_EVENT,
-				"%s() %s waiting for task",
-				__func__, pool->name);
+			TIRPC_TRACE(TIRPC_TRACE_WAIT, pool, 0, 0);
 
 			if (unlikely(work_pool_wait(pool, wpt))) {
 				/* failed, not timeout */
@@ -285,7 +283,7 @@ work_pool_submit(struct work_pool *pool, struct work_pool_entry *work)
 		/* queue is draining */
 		return (0);
 	}
-	pthread_mutex_lock(&pool->pqh.qmutex);
+	TIRPC_MUTEX_LOCK(&pool->pqh.qmutex, TIRPC_LOCK_POOL);
 
 	if (likely(0 > pool->pqh.qcount++)) {
 		/* negative for waiting worker(s) */
@@ -310,7 +308,7 @@ work_pool_shutdown(struct work_pool *pool)
 	pool->params.thrd_max =
 	pool->params.thrd_min = 0;
 
-	pthread_mutex_lock(&pool->pqh.qmutex);
+	TIRPC_MUTEX_LOCK(&pool->pqh.qmutex, TIRPC_LOCK_POOL);
 
 	while (0 > pool->pqh.qcount) {
 		/* unlike _submit, only increment negatives */
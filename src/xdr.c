@@ -41,9 +41,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <rpc/types.h>
 #include <misc/portable.h>
+#include <misc/abstract_atomic.h>
 #include <rpc/xdr.h>
 #include <rpc/xdr_inline.h>
 #include <rpc/rpc.h>
@@ -457,6 +459,7 @@ xdr_opaque(XDR *xdrs, caddr_t cp, u_int cnt)
 {
 	u_int rndup;
 	static int crud[BYTES_PER_XDR_UNIT];
+	void *buf;
 
 	/*
 	 * if no data we are done
@@ -464,6 +467,22 @@ xdr_opaque(XDR *xdrs, caddr_t cp, u_int cnt)
 	if (cnt == 0)
 		return (true);
 
+	/* RNDUP(cnt) would wrap */
+	if (cnt > UINT_MAX - BYTES_PER_XDR_UNIT)
+		return (xdrs->x_op == XDR_FREE);
+
+	/* data and padding in one step */
+	buf = xdr_vio_inline(xdrs, RNDUP(cnt));
+	if (buf != NULL) {
+		if (xdrs->x_op == XDR_DECODE) {
+			memmove(cp, buf, cnt);
+		} else {
+			*(uint32_t *) (buf + RNDUP(cnt) - BYTES_PER_XDR_UNIT) = 0;
+			memmove(buf, cp, cnt);
+		}
+		return (true);
+	}
+
 	/*
 	 * round byte count to full xdr units
 	 */
@@ -504,6 +523,10 @@ xdr_bytes(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize)
 	char *sp = *cpp;	/* sp is the actual string pointer */
 	u_int nodesize;
 
+	if (xdrs->x_op == XDR_ENCODE && *sizep <= maxsize
+	    && inline_xdr_putcounted(xdrs, sp, *sizep))
+		return (true);
+
 	/*
 	 * first deal with the length since xdr bytes are counted
 	 */
@@ -545,6 +568,172 @@ xdr_bytes(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize)
 	return (false);
 }
 
+/*
+ * Decoded copy, where the stream cannot lend its buffers.
+ * The data follows the xdr_uio and its single vector.
+ */
+static void
+xdr_uio_copy_release(xdr_uio *uio, u_int flags)
+{
+	if (atomic_dec_int32_t(&uio->uio_references))
+		return;
+	mem_free(uio, sizeof(xdr_uio) + sizeof(xdr_vio)
+		 + (uintptr_t) uio->uio_u1);
+}
+
+static xdr_uio *
+xdr_uio_copy(XDR *xdrs, u_int cnt)
+{
+	xdr_uio *uio = mem_alloc(sizeof(xdr_uio) + sizeof(xdr_vio) + cnt);
+	char *data;
+
+	if (uio == NULL) {
+		__warnx(TIRPC_DEBUG_FLAG_XDR,
+			"xdr_opaque_uio: out of memory");
+		return (NULL);
+	}
+	data = (char *)&uio->uio_vio[1];
+	if (!XDR_GETBYTES(xdrs, data, cnt)) {
+		mem_free(uio, sizeof(xdr_uio) + sizeof(xdr_vio) + cnt);
+		return (NULL);
+	}
+	memset(uio, 0, sizeof(xdr_uio));
+	uio->uio_release = xdr_uio_copy_release;
+	uio->uio_u1 = (void *)(uintptr_t) cnt;
+	uio->uio_count = 1;
+	uio->uio_references = 1;
+	uio->uio_vio[0].vio_base =
+	uio->uio_vio[0].vio_head = data;
+	uio->uio_vio[0].vio_tail =
+	uio->uio_vio[0].vio_wrap = data + cnt;
+	return (uio);
+}
+
+/*
+ * XDR opaque data by reference
+ * On decode, *uiop is set to an xdr_uio referencing the stream buffers
+ * where the stream can lend them (see XDR_GETBUFS), else a copy; either
+ * way it is released by (*uiop)->uio_release(), or XDR_FREE.
+ * On encode, the vectors of *uiop must total cnt bytes.
+ */
+bool
+xdr_opaque_uio(XDR *xdrs, xdr_uio **uiop, u_int cnt)
+{
+	xdr_uio *uio = *uiop;
+	char crud[BYTES_PER_XDR_UNIT];
+	size_t len, ix;
+	u_int rndup;
+
+	rndup = cnt % BYTES_PER_XDR_UNIT;
+	if (rndup > 0)
+		rndup = BYTES_PER_XDR_UNIT - rndup;
+
+	switch (xdrs->x_op) {
+
+	case XDR_DECODE:
+		if (!cnt || !XDR_GETBUFS(xdrs, uiop, cnt, UIO_FLAG_NONE)) {
+			*uiop = xdr_uio_copy(xdrs, cnt);
+			if (*uiop == NULL)
+				return (false);
+		}
+		if (rndup == 0)
+			return (true);
+		return (XDR_GETBYTES(xdrs, crud, rndup));
+
+	case XDR_ENCODE:
+		for (len = 0, ix = 0; ix < uio->uio_count; ++ix)
+			len += (uintptr_t) uio->uio_vio[ix].vio_tail
+			     - (uintptr_t) uio->uio_vio[ix].vio_head;
+		if (len != cnt)
+			return (false);
+		if (!XDR_PUTBUFS(xdrs, uio, XDR_PUTBUFS_FLAG_NONE))
+			return (false);
+		if (rndup == 0)
+			return (true);
+		return (XDR_PUTBYTES(xdrs, xdr_zero, rndup));
+
+	case XDR_FREE:
+		if (uio != NULL) {
+			uio->uio_release(uio, UIO_FLAG_NONE);
+			*uiop = NULL;
+		}
+		return (true);
+	}
+	/* NOTREACHED */
+	return (false);
+}
+
+/*
+ * x_putbufs for streams that copy:  XDR_PUTBUFS semantics, by way of
+ * XDR_PUTBYTES.
+ */
+bool
+xdr_putbufs_copy(XDR *xdrs, xdr_uio *uio, u_int flags)
+{
+	char buf[8192];
+	size_t ix, len;
+	ssize_t result;
+	off_t offset;
+
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		len = (uintptr_t) uio->uio_vio[ix].vio_tail
+		    - (uintptr_t) uio->uio_vio[ix].vio_head;
+		if (!(uio->uio_flags & UIO_FLAG_FD)) {
+			if (!XDR_PUTBYTES(xdrs, uio->uio_vio[ix].vio_head, len))
+				return (false);
+			continue;
+		}
+		offset = xdr_vio_offset(&uio->uio_vio[ix]);
+		while (len > 0) {
+			result = pread(xdr_uio_fd(uio), buf,
+				       (len < sizeof(buf)) ? len : sizeof(buf),
+				       offset);
+			/* short files are errors, as for any other read */
+			if (result <= 0)
+				return (false);
+			if (!XDR_PUTBYTES(xdrs, buf, result))
+				return (false);
+			offset += result;
+			len -= result;
+		}
+	}
+	xdr_putbufs_release(uio);
+	return (true);
+}
+
+/*
+ * Drop what XDR_PUTBUFS handed over, once the bytes are sent or copied
+ */
+void
+xdr_putbufs_release(xdr_uio *uio)
+{
+	size_t ix;
+
+	if ((uio->uio_flags & (UIO_FLAG_FREE | UIO_FLAG_FD))
+	    == UIO_FLAG_FREE) {
+		for (ix = 0; ix < uio->uio_count; ++ix)
+			mem_free(uio->uio_vio[ix].vio_base,
+				 (uintptr_t) uio->uio_vio[ix].vio_wrap
+				 - (uintptr_t) uio->uio_vio[ix].vio_base);
+	}
+	if ((uio->uio_flags & UIO_FLAG_GIFT) && uio->uio_release)
+		uio->uio_release(uio, UIO_FLAG_NONE);
+}
+
+/*
+ * XDR counted bytes by reference
+ * *uiop is as for xdr_opaque_uio(), *sizep is the count.
+ */
+bool
+xdr_bytes_uio(XDR *xdrs, xdr_uio **uiop, u_int *sizep, u_int maxsize)
+{
+	if (!xdr_u_int(xdrs, sizep))
+		return (false);
+	if ((*sizep > maxsize) && (xdrs->x_op != XDR_FREE))
+		return (false);
+	return (xdr_opaque_uio(xdrs, uiop, *sizep));
+}
+
 /*
  * Implemented here due to commonality of the object.
  */
@@ -628,6 +817,9 @@ xdr_string(XDR *xdrs, char **cpp, u_int maxsize)
 		if (sp == NULL)
 			return false;
 		size = strlen(sp);
+		if (xdrs->x_op == XDR_ENCODE && size <= maxsize
+		    && inline_xdr_putcounted(xdrs, sp, size))
+			return (true);
 		break;
 	case XDR_DECODE:
 		break;
@@ -53,6 +53,10 @@
 #include <rpc/rpc.h>
 #include "un-namespace.h"
 
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
 /*
  * XDR an array of arbitrary elements
  * *addrp is a pointer to the array, *sizep is the number of elements.
@@ -150,3 +154,258 @@ xdr_vector(XDR *xdrs, char *basep, u_int nelem, u_int elemsize,
 	}
 	return (true);
 }
+
+/*
+ * Bulk codecs for arrays of 32- and 64-bit integers.
+ *
+ * Rather than an xdrproc_t call and a getlong/putlong per element, whole
+ * runs are byte swapped directly to or from an XDR_INLINE window.  When
+ * the stream cannot inline the remainder (e.g., at a buffer boundary),
+ * the window is halved until it fits, and an element straddling the
+ * boundary is coded singly.  Streams that never inline fall back to the
+ * element routines.
+ *
+ * The swap is its own inverse, so serves both directions.  SSSE3 or
+ * AVX2 shuffles are used when the library is built for them.
+ */
+
+#if defined(__AVX2__)
+static const uint8_t xdr_bswap32_mask[32] __attribute__ ((aligned(32))) = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+};
+#elif defined(__SSSE3__)
+static const uint8_t xdr_bswap32_mask[16] __attribute__ ((aligned(16))) = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+};
+#endif
+
+/* n 32-bit words, network <-> host order */
+static inline void
+xdr_bswap32_run(uint32_t *dst, const uint32_t *src, u_int n)
+{
+	u_int i = 0;
+
+#if defined(__AVX2__)
+	const __m256i mask =
+	    _mm256_load_si256((const __m256i *)xdr_bswap32_mask);
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_shuffle_epi8(v, mask));
+	}
+#elif defined(__SSSE3__)
+	const __m128i mask =
+	    _mm_load_si128((const __m128i *)xdr_bswap32_mask);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_shuffle_epi8(v, mask));
+	}
+#endif
+	for (; i < n; i++)
+		dst[i] = ntohl(src[i]);
+}
+
+/*
+ * n 64-bit hypers, network <-> host order.  XDR sends the high word
+ * first, so each half is swapped and the halves exchanged.
+ */
+static inline void
+xdr_bswap64_run(uint64_t *dst, const uint32_t *src, u_int n)
+{
+	u_int i = 0;
+
+#if defined(__AVX2__)
+	const __m256i mask =
+	    _mm256_load_si256((const __m256i *)xdr_bswap32_mask);
+
+	for (; i + 4 <= n; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + 2 * i));
+
+		/* swap bytes within words, then words within hypers */
+		v = _mm256_shuffle_epi8(v, mask);
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_shuffle_epi32(v, 0xb1));
+	}
+#elif defined(__SSSE3__)
+	const __m128i mask =
+	    _mm_load_si128((const __m128i *)xdr_bswap32_mask);
+
+	for (; i + 2 <= n; i += 2) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+
+		v = _mm_shuffle_epi8(v, mask);
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_shuffle_epi32(v, 0xb1));
+	}
+#endif
+	for (; i < n; i++)
+		dst[i] = ((uint64_t) ntohl(src[2 * i]) << 32)
+		    | (uint64_t) ntohl(src[2 * i + 1]);
+}
+
+static inline void
+xdr_bswap64_run_enc(uint32_t *dst, const uint64_t *src, u_int n)
+{
+#if defined(__AVX2__) || defined(__SSSE3__)
+	/* the same permutation */
+	xdr_bswap64_run((uint64_t *) dst, (const uint32_t *)src, n);
+#else
+	u_int i;
+
+	for (i = 0; i < n; i++) {
+		dst[2 * i] = htonl((uint32_t) (src[i] >> 32));
+		dst[2 * i + 1] = htonl((uint32_t) src[i]);
+	}
+#endif
+}
+
+bool
+xdr_vector_u32(XDR *xdrs, uint32_t *basep, u_int nelem)
+{
+	int32_t *buf;
+	/* a run's byte length must fit XDR_INLINE()'s u_int */
+	const u_int max = UINT_MAX / BYTES_PER_XDR_UNIT;
+	u_int chunk = MIN(nelem, max);
+	u_int misses = 0;
+
+	if (xdrs->x_op == XDR_FREE)
+		return (true);
+
+	while (nelem) {
+		buf = (misses < 2)
+		    ? XDR_INLINE(xdrs, chunk * BYTES_PER_XDR_UNIT)
+		    : NULL;
+		if (buf) {
+			if (xdrs->x_op == XDR_DECODE)
+				xdr_bswap32_run(basep, (uint32_t *) buf, chunk);
+			else
+				xdr_bswap32_run((uint32_t *) buf, basep, chunk);
+			basep += chunk;
+			nelem -= chunk;
+			chunk = MIN(nelem, max);
+			misses = 0;
+			continue;
+		}
+		if (chunk > 1 && misses < 2) {
+			chunk /= 2;
+			continue;
+		}
+		if (!inline_xdr_u_int32_t(xdrs, basep))
+			return (false);
+		basep++;
+		nelem--;
+		chunk = MIN(nelem, max);
+		misses++;
+	}
+	return (true);
+}
+
+bool
+xdr_vector_u64(XDR *xdrs, uint64_t *basep, u_int nelem)
+{
+	int32_t *buf;
+	/* a run's byte length must fit XDR_INLINE()'s u_int */
+	const u_int max = UINT_MAX / (2 * BYTES_PER_XDR_UNIT);
+	u_int chunk = MIN(nelem, max);
+	u_int misses = 0;
+
+	if (xdrs->x_op == XDR_FREE)
+		return (true);
+
+	while (nelem) {
+		buf = (misses < 2)
+		    ? XDR_INLINE(xdrs, chunk * 2 * BYTES_PER_XDR_UNIT)
+		    : NULL;
+		if (buf) {
+			if (xdrs->x_op == XDR_DECODE)
+				xdr_bswap64_run(basep, (uint32_t *) buf, chunk);
+			else
+				xdr_bswap64_run_enc((uint32_t *) buf, basep,
+						    chunk);
+			basep += chunk;
+			nelem -= chunk;
+			chunk = MIN(nelem, max);
+			misses = 0;
+			continue;
+		}
+		if (chunk > 1 && misses < 2) {
+			chunk /= 2;
+			continue;
+		}
+		if (!inline_xdr_u_int64_t(xdrs, basep))
+			return (false);
+		basep++;
+		nelem--;
+		chunk = MIN(nelem, max);
+		misses++;
+	}
+	return (true);
+}
+
+/*
+ * Counted arrays, as xdr_array() with elsize and elproc implied.
+ */
+static bool
+xdr_array_bulk(XDR *xdrs, caddr_t *addrp, u_int *sizep, u_int maxsize,
+	       u_int elsize)
+{
+	caddr_t target = *addrp;
+	u_int c;
+	u_int nodesize;
+
+	if (!inline_xdr_u_int(xdrs, sizep))
+		return (false);
+	c = *sizep;
+	if ((c > maxsize || UINT_MAX / elsize < c) &&
+	    (xdrs->x_op != XDR_FREE))
+		return (false);
+	nodesize = c * elsize;
+
+	switch (xdrs->x_op) {
+	case XDR_DECODE:
+		if (c == 0)
+			return (true);
+		if (target == NULL) {
+			/* fully overwritten, so need not be zeroed */
+			*addrp = target = mem_alloc(nodesize);
+			if (target == NULL) {
+				__warnx(TIRPC_DEBUG_FLAG_XDR,
+					"%s: out of memory", __func__);
+				return (false);
+			}
+		}
+		break;
+	case XDR_FREE:
+		if (target != NULL) {
+			mem_free(target, nodesize);
+			*addrp = NULL;
+		}
+		return (true);
+	case XDR_ENCODE:
+		break;
+	}
+
+	if (elsize == sizeof(uint32_t))
+		return (xdr_vector_u32(xdrs, (uint32_t *) target, c));
+	return (xdr_vector_u64(xdrs, (uint64_t *) target, c));
+}
+
+bool
+xdr_array_u32(XDR *xdrs, uint32_t **addrp, u_int *sizep, u_int maxsize)
+{
+	return (xdr_array_bulk(xdrs, (caddr_t *) addrp, sizep, maxsize,
+			       sizeof(uint32_t)));
+}
+
+bool
+xdr_array_u64(XDR *xdrs, uint64_t **addrp, u_int *sizep, u_int maxsize)
+{
+	return (xdr_array_bulk(xdrs, (caddr_t *) addrp, sizep, maxsize,
+			       sizeof(uint64_t)));
+}
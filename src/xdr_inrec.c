@@ -64,12 +64,14 @@
 #include <rpc/auth.h>
 #include <rpc/svc_auth.h>
 #include <rpc/svc.h>
+#include <rpc/svc_mem.h>
 #include <rpc/clnt.h>
 #include <stddef.h>
 #include "rpc_com.h"
 #include <misc/city.h>
 #include <rpc/rpc_cksum.h>
 #include <intrinsic.h>
+#include <misc/abstract_atomic.h>
 
 static bool xdr_inrec_getlong(XDR *, long *);
 static bool xdr_inrec_putlong(XDR *, const long *);
@@ -80,12 +82,13 @@ static u_int xdr_inrec_getpos(XDR *);
 static bool xdr_inrec_setpos(XDR *, u_int);
 static int32_t *xdr_inrec_inline(XDR *, u_int);
 static void xdr_inrec_destroy(XDR *);
+static bool xdr_inrec_getbufs(XDR *, xdr_uio **, u_int, u_int);
 static bool xdr_inrec_noop(void);
 
 extern bool xdr_inrec_readahead(XDR *, u_int);
 
 typedef bool (*dummyfunc3) (XDR *, int, void *);
-typedef bool (*dummy_getbufs) (XDR *, xdr_uio *, u_int);
+typedef bool (*dummy_getbufs) (XDR *, xdr_uio **, u_int, u_int);
 typedef bool (*dummy_putbufs) (XDR *, xdr_uio *, u_int);
 
 static const struct  xdr_ops xdr_inrec_ops = {
@@ -98,7 +101,7 @@ static const struct  xdr_ops xdr_inrec_ops = {
 	xdr_inrec_inline,
 	xdr_inrec_destroy,
 	(dummyfunc3) xdr_inrec_noop, /* x_control */
-	(dummy_getbufs) xdr_inrec_noop, /* x_getbufs */
+	xdr_inrec_getbufs,
 	(dummy_putbufs) xdr_inrec_noop  /* x_putbufs */
 };
 
@@ -128,6 +131,7 @@ typedef struct rec_strm {
 	char *in_base;
 	char *in_finger;	/* location of next byte to be had */
 	char *in_boundry;	/* can read up to this location */
+	xdr_uio *in_lent;	/* in_base, once lent by getbufs */
 	int32_t fbtbc;		/* fragment bytes to be consumed */
 	int32_t offset;
 	bool last_frag;
@@ -179,6 +183,7 @@ xdr_inrec_create(XDR *xdrs, u_int recvsize, void *tcp_handle,
 		mem_free(rstrm, sizeof(RECSTREAM));
 		return;
 	}
+	svc_mem_add(SVC_MEM_INREC, recvsize);
 	/*
 	 * now the rest ...
 	 */
@@ -192,6 +197,7 @@ xdr_inrec_create(XDR *xdrs, u_int recvsize, void *tcp_handle,
 	rstrm->tcp_handle = tcp_handle;
 	rstrm->readit = readit;
 	rstrm->in_size = recvsize;
+	rstrm->in_lent = NULL;
 	rstrm->in_boundry = rstrm->in_base;
 	rstrm->in_finger = (rstrm->in_boundry += recvsize);
 	rstrm->fbtbc = 0;
@@ -221,6 +227,20 @@ xdr_inrec_cksum(XDR *xdrs)
 	return (rstrm->cksum);
 }
 
+/* handle checksumming if requested */
+static inline void
+xdr_inrec_cksum_update(XDR *xdrs, RECSTREAM *rstrm)
+{
+	if (xdrs->x_flags & XDR_FLAG_CKSUM) {
+		if (rstrm->cklen) {
+			if (!(rstrm->cksum)) {
+				if (rstrm->offset >= rstrm->cklen)
+					compute_buffer_cksum(rstrm);
+			}
+		}
+	}
+}
+
 /*
  * The routines defined below are the xdr ops which will go into the
  * xdr handle filled in by xdr_inrec_create.
@@ -275,15 +295,7 @@ xdr_inrec_getbytes(XDR *xdrs, char *addr, u_int len)
 		addr += current;
 		rstrm->fbtbc -= current;
 		len -= current;
-		/* handle checksumming if requested */
-		if (xdrs->x_flags & XDR_FLAG_CKSUM) {
-			if (rstrm->cklen) {
-				if (!(rstrm->cksum)) {
-					if (rstrm->offset >= rstrm->cklen)
-						compute_buffer_cksum(rstrm);
-				}
-			}
-		}
+		xdr_inrec_cksum_update(xdrs, rstrm);
 	}
 	return (true);
 }
@@ -385,12 +397,90 @@ xdr_inrec_inline(XDR *xdrs, u_int len)
 	return (buf);
 }
 
+/*
+ * A lent in_base is freed when both the stream and every loan
+ * have released it.
+ */
+static void
+xdr_inrec_base_release(xdr_uio *uio, u_int flags)
+{
+	if (atomic_dec_int32_t(&uio->uio_references))
+		return;
+	svc_mem_add(SVC_MEM_INREC, -(int64_t)(uintptr_t)uio->uio_u1);
+	mem_free(uio->uio_p1, (uintptr_t)uio->uio_u1);
+	mem_free(uio, sizeof(xdr_uio));
+}
+
+static void
+xdr_inrec_loan_release(xdr_uio *uio, u_int flags)
+{
+	if (atomic_dec_int32_t(&uio->uio_references))
+		return;
+	uio->uio_refer->uio_release(uio->uio_refer, UIO_FLAG_NONE);
+	mem_free(uio, sizeof(xdr_uio) + sizeof(xdr_vio));
+}
+
+/*
+ * Lend len bytes of the input buffer, when they are already buffered
+ * and within the current fragment.  The buffer is not refilled in
+ * place after that; fill_input_buf() reads into a fresh one.
+ */
+static bool
+xdr_inrec_getbufs(XDR *xdrs, xdr_uio **uiop, u_int len, u_int flags)
+{
+	RECSTREAM *rstrm = (RECSTREAM *) xdrs->x_private;
+	xdr_uio *uio;
+
+	if ((xdrs->x_op != XDR_DECODE) || !len
+	    || (len > rstrm->fbtbc)
+	    || ((rstrm->in_finger + len) > rstrm->in_boundry))
+		return (false);
+
+	uio = mem_zalloc(sizeof(xdr_uio) + sizeof(xdr_vio));
+	if (!uio)
+		return (false);
+
+	if (!rstrm->in_lent) {
+		rstrm->in_lent = mem_zalloc(sizeof(xdr_uio));
+		if (!rstrm->in_lent) {
+			mem_free(uio, sizeof(xdr_uio) + sizeof(xdr_vio));
+			return (false);
+		}
+		rstrm->in_lent->uio_release = xdr_inrec_base_release;
+		rstrm->in_lent->uio_p1 = rstrm->in_base;
+		rstrm->in_lent->uio_u1 = (void *)(uintptr_t)rstrm->recvsize;
+		rstrm->in_lent->uio_references = 1;	/* the stream's */
+	}
+	atomic_inc_int32_t(&rstrm->in_lent->uio_references);
+
+	uio->uio_refer = rstrm->in_lent;
+	uio->uio_release = xdr_inrec_loan_release;
+	uio->uio_count = 1;
+	uio->uio_references = 1;
+	uio->uio_vio[0].vio_base =
+	uio->uio_vio[0].vio_head = rstrm->in_finger;
+	uio->uio_vio[0].vio_tail =
+	uio->uio_vio[0].vio_wrap = rstrm->in_finger + len;
+
+	rstrm->fbtbc -= len;
+	rstrm->in_finger += len;
+	xdr_inrec_cksum_update(xdrs, rstrm);
+
+	*uiop = uio;
+	return (true);
+}
+
 static void
 xdr_inrec_destroy(XDR *xdrs)
 {
 	RECSTREAM *rstrm = (RECSTREAM *) xdrs->x_private;
 
-	mem_free(rstrm->in_base, rstrm->recvsize);
+	if (rstrm->in_lent)
+		rstrm->in_lent->uio_release(rstrm->in_lent, UIO_FLAG_NONE);
+	else {
+		svc_mem_add(SVC_MEM_INREC, -(int64_t)rstrm->recvsize);
+		mem_free(rstrm->in_base, rstrm->recvsize);
+	}
 	mem_free(rstrm, sizeof(RECSTREAM));
 }
 
@@ -444,6 +534,14 @@ xdr_inrec_eof(XDR *xdrs)
 	return (false);
 }
 
+bool
+xdr_inrec_buffered(XDR *xdrs)
+{
+	RECSTREAM *rstrm = (RECSTREAM *) (xdrs->x_private);
+
+	return (rstrm->in_finger != rstrm->in_boundry);
+}
+
 static bool
 fill_input_buf(RECSTREAM *rstrm, int32_t maxreadahead)
 {
@@ -451,6 +549,17 @@ fill_input_buf(RECSTREAM *rstrm, int32_t maxreadahead)
 	u_int32_t i;
 	int len;
 
+	if (rstrm->in_lent) {
+		/* do not overwrite lent bytes */
+		where = mem_alloc(rstrm->recvsize);
+		if (!where)
+			return (false);
+		svc_mem_add(SVC_MEM_INREC, rstrm->recvsize);
+		rstrm->in_lent->uio_release(rstrm->in_lent, UIO_FLAG_NONE);
+		rstrm->in_lent = NULL;
+		rstrm->in_base = where;
+	}
+
 	where = rstrm->in_base;
 	i = (u_int32_t) (PtrToUlong(rstrm->in_boundry) % BYTES_PER_XDR_UNIT);
 	where += i;
@@ -31,6 +31,7 @@
 #include <err.h>
 #endif
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -42,6 +43,7 @@
 #include <rpc/auth.h>
 #include <rpc/svc_auth.h>
 #include <rpc/svc.h>
+#include <rpc/svc_mem.h>
 #include <rpc/clnt.h>
 #include <stddef.h>
 #include <assert.h>
@@ -84,6 +86,12 @@ xdr_ioq_uv_create(u_int size, u_int uio_flags)
 		uv->v.vio_wrap = uv->v.vio_base + size;
 		/* ensure not wrapping to zero */
 		assert(uv->v.vio_base < uv->v.vio_wrap);
+
+		/* only buffers freed by xdr_ioq_uv_release() */
+		if (uio_flags & UIO_FLAG_FREE) {
+			svc_mem_add(SVC_MEM_IOQ, size);
+			uio_flags |= UIO_FLAG_MEMACCT;
+		}
 	}
 	uv->u.uio_flags = uio_flags;
 	uv->u.uio_references = 1;	/* starting one */
@@ -194,17 +202,21 @@ xdr_ioq_uv_recycle(struct poolq_head *ioqh, struct poolq_entry *have)
 void
 xdr_ioq_uv_release(struct xdr_ioq_uv *uv)
 {
-	if (uv->u.uio_refer) {
-		/* not optional in this case! */
-		uv->u.uio_refer->uio_release(uv->u.uio_refer, UIO_FLAG_NONE);
-		uv->u.uio_refer = NULL;
-	}
+	if (!atomic_dec_int32_t(&uv->u.uio_references)) {
+		if (uv->u.uio_refer) {
+			/* not optional in this case! */
+			uv->u.uio_refer->uio_release(uv->u.uio_refer,
+						     UIO_FLAG_NONE);
+			uv->u.uio_refer = NULL;
+		}
 
-	if (!(--uv->u.uio_references)) {
 		if (uv->u.uio_release) {
 			/* handle both xdr_ioq_uv and vio */
 			uv->u.uio_release(&uv->u, UIO_FLAG_NONE);
 		} else if (uv->u.uio_flags & UIO_FLAG_FREE) {
+			if (uv->u.uio_flags & UIO_FLAG_MEMACCT)
+				svc_mem_add(SVC_MEM_IOQ,
+					    -(int64_t)ioquv_size(uv));
 			free_buffer(uv->v.vio_base, ioquv_size(uv));
 			mem_free(uv, sizeof(*uv));
 		} else if (uv->u.uio_flags & UIO_FLAG_BUFQ) {
@@ -291,6 +303,51 @@ xdr_ioq_create(u_int min_bsize, u_int max_bsize, u_int uio_flags)
 	return (xioq->xdrs);
 }
 
+/*
+ * Create an encoding stream with exactly size bytes of buffer, in as
+ * few segments of at most max_bsize bytes as will hold it (size is
+ * usually from xdr_sizeof() or a xdrsize_create() stream).  Should the
+ * encoding outgrow it, min_bsize segments are appended as usual.
+ *
+ * Returns NULL if the buffers cannot be allocated.
+ */
+XDR *
+xdr_ioq_create_sized(u_int size, u_int min_bsize, u_int max_bsize,
+		     u_int uio_flags)
+{
+	struct xdr_ioq *xioq;
+	struct xdr_ioq_uv *uv;
+	u_int len;
+
+	/* whole XDR units per segment, so none are split */
+	max_bsize &= ~(BYTES_PER_XDR_UNIT - 1);
+	size = RNDUP(size);
+	if (unlikely(!max_bsize || !size))
+		return (NULL);
+
+	xioq = mem_zalloc(sizeof(struct xdr_ioq));
+	if (!xioq)
+		return (NULL);
+
+	xdr_ioq_setup(xioq);
+	xioq->ioq_uv.min_bsize = min_bsize;
+	xioq->ioq_uv.max_bsize = max_bsize;
+
+	for (; size; size -= len) {
+		len = (size < max_bsize) ? size : max_bsize;
+		uv = xdr_ioq_uv_create(len, uio_flags);
+		if (!uv) {
+			xdr_ioq_destroy(xioq, sizeof(struct xdr_ioq));
+			return (NULL);
+		}
+		(xioq->ioq_uv.uvqh.qcount)++;
+		TAILQ_INSERT_TAIL(&xioq->ioq_uv.uvqh.qh, &uv->uvq, q);
+	}
+	xdr_ioq_reset(xioq, 0);
+
+	return (xioq->xdrs);
+}
+
 /*
  * Advance read/insert or fill position.
  *
@@ -346,6 +403,10 @@ xdr_ioq_uv_next(struct xdr_ioq *xioq, u_int ioq_flags)
 
 				base = mem_alloc(xioq->ioq_uv.max_bsize);
 				memcpy(base, uv->v.vio_head, len);
+				if (uv->u.uio_flags & UIO_FLAG_MEMACCT)
+					svc_mem_add(SVC_MEM_IOQ,
+						    xioq->ioq_uv.max_bsize
+						    - size);
 				mem_free(uv->v.vio_base, size);
 				uv->v.vio_base =
 				uv->v.vio_head = base + 0;
@@ -363,15 +424,15 @@ xdr_ioq_uv_next(struct xdr_ioq *xioq, u_int ioq_flags)
 			/* XXX empty buffer slot (not supported for now) */
 			uv = xdr_ioq_uv_create(0, UIO_FLAG_NONE);
 		}
-	}
 
-	if (uv) {
-		if (!xioq->ioq_uv.uvq_fetch) {
+		if (uv && !xioq->ioq_uv.uvq_fetch) {
 			/* new xdr_ioq_uv */
 			(xioq->ioq_uv.uvqh.qcount)++;
 			TAILQ_INSERT_TAIL(&xioq->ioq_uv.uvqh.qh, &uv->uvq, q);
 		}
+	}
 
+	if (uv) {
 		/* advance iterator */
 		xioq->xdrs[0].x_private = uv->v.vio_head;
 		xioq->xdrs[0].x_base = &uv->v;
@@ -497,115 +558,195 @@ xdr_ioq_putbytes(XDR *xdrs, const char *addr, u_int len)
 	return (true);
 }
 
-/* Get buffers from the queue. */
-static bool
-xdr_ioq_getbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
+/* Segments referenced by xdr_ioq_getbufs() follow the vectors. */
+#define xdr_ioq_uio_size(count) \
+	(sizeof(xdr_uio) + (count) * (sizeof(xdr_vio) \
+				      + sizeof(struct xdr_ioq_uv *)))
+
+static void
+xdr_ioq_uio_release(xdr_uio *uio, u_int flags)
 {
-    /* XXX finalize */
-#if 0
+	struct xdr_ioq_uv **uvs = uio->uio_p1;
+	size_t ix;
+
+	if (atomic_dec_int32_t(&uio->uio_references))
+		return;
+	for (ix = 0; ix < uio->uio_count; ++ix)
+		xdr_ioq_uv_release(uvs[ix]);
+	mem_free(uio, (uintptr_t)uio->uio_u1);
+}
 
+/* Get buffers from the queue.
+ *
+ * Each segment spanned gains a reference, dropped by uio_release, so
+ * the data outlives the stream.  Nothing is consumed unless all len
+ * bytes are already queued.
+ */
+static bool
+xdr_ioq_getbufs(XDR *xdrs, xdr_uio **uiop, u_int len, u_int flags)
+{
+	struct poolq_entry *have = &IOQV(xdrs->x_base)->uvq;
+	struct xdr_ioq_uv **uvs;
 	struct xdr_ioq_uv *uv;
-	ssize_t delta;
-	int ix;
-
-	/* allocate sufficient slots to empty the queue, else MAX */
-	uio->xbs_cnt = XIOQ(xdrs)->ioq_uv.uvqh.qsize - XIOQ(xdrs)->ioq_uv.pcount;
-	if (uio->xbs_cnt > VREC_MAXBUFS) {
-		uio->xbs_cnt = VREC_MAXBUFS;
+	xdr_uio *uio;
+	size_t delta = (uintptr_t)xdrs->x_v.vio_tail
+		     - (uintptr_t)xdrs->x_private;
+	u_int resid = len;
+	u_int count = 1;
+	u_int ix = 0;
+
+	if (xdrs->x_op != XDR_DECODE || !len)
+		return (false);
+
+	/* count segments spanned */
+	while (delta < resid) {
+		resid -= delta;
+		have = TAILQ_NEXT(have, q);
+		if (!have)
+			return (false);
+		delta = ioquv_length(IOQ_(have));
+		count++;
 	}
 
-	/* fail if no segments available */
-	if (unlikely(! uio->xbs_cnt))
-		return (FALSE);
+	uio = mem_alloc(xdr_ioq_uio_size(count));
+	if (!uio)
+		return (false);
+	memset(uio, 0, sizeof(xdr_uio));
+	uvs = (struct xdr_ioq_uv **)&uio->uio_vio[count];
+	uio->uio_release = xdr_ioq_uio_release;
+	uio->uio_p1 = uvs;
+	uio->uio_u1 = (void *)(uintptr_t)xdr_ioq_uio_size(count);
+	uio->uio_references = 1;
 
-	uio->xbs_buf = mem_alloc(uio->xbs_cnt);
-	uio->xbs_resid = 0;
-	ix = 0;
-
-	/* re-consuming bytes in a stream (after SETPOS/rewind) */
-	while (len > 0
-		&& XIOQ(xdrs)->ioq_uv.pcount < XIOQ(xdrs)->ioq_uv.uvqh.qcount) {
-		delta = (uintptr_t)XDR_VIO(xioq->xdrs)->vio_tail
+	while (len > 0) {
+		delta = (uintptr_t)xdrs->x_v.vio_tail
 			- (uintptr_t)xdrs->x_private;
 
 		if (unlikely(delta > len)) {
 			delta = len;
 		} else if (unlikely(!delta)) {
+			/* advance fill pointer */
 			uv = xdr_ioq_uv_next(XIOQ(xdrs), IOQ_FLAG_NONE);
-			if (!uv)
+			if (!uv) {
+				/* counted above, should not happen */
+				xdr_ioq_uio_release(uio, UIO_FLAG_NONE);
 				return (false);
+			}
 			continue;
 		}
-		(uio->xbs_buf[ix]).xb_p1 = uv;
-		uv->u.uio_references)++;
-		(uio->xbs_buf[ix]).xb_base = xdrs->x_private;
-		XIOQ(xdrs)->ioq_uv.plength += delta;
+		uv = IOQV(xdrs->x_base);
+		atomic_inc_int32_t(&uv->u.uio_references);
+		uvs[ix] = uv;
+		uio->uio_vio[ix].vio_base =
+		uio->uio_vio[ix].vio_head = xdrs->x_private;
+		uio->uio_vio[ix].vio_tail =
+		uio->uio_vio[ix].vio_wrap = xdrs->x_private + delta;
+		uio->uio_count = ++ix;
 		xdrs->x_private += delta;
 		len -= delta;
 	}
-#endif /* 0 */
 
-	/* assert(len == 0); */
-	return (TRUE);
+	*uiop = uio;
+	return (true);
 }
 
-/* Post buffers on the queue, or, if indicated in flags, return buffers
- * referenced with getbufs. */
+/* Spliced segments hold no buffer of their own. */
+static void
+xdr_ioq_uv_splice_release(xdr_uio *uio, u_int flags)
+{
+	mem_free(IOQU(uio), sizeof(struct xdr_ioq_uv));
+}
+
+/* Post buffers on the queue.
+ *
+ * Each vector becomes a segment of its own, following the fill
+ * position, and is sent in place (UIO_FLAG_FD ranges by sendfile).
+ * The last of them holds the stream's reference on uio, so it is
+ * released after all of its buffers.  Pooled streams, and
+ * XDR_FLAG_NOSPLICE, copy instead.
+ */
 static bool
 xdr_ioq_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 {
-	struct xdr_ioq_uv *uv;
+	struct xdr_ioq *xioq = XIOQ(xdrs);
+	struct xdr_ioq_uv *uv = NULL;
+	struct poolq_entry *have;
 	xdr_vio *v;
-	int ix;
+	size_t total;
+	size_t ix;
+	u_int uv_flags = (uio->uio_flags & UIO_FLAG_FD)
+		       ? UIO_FLAG_FD : (uio->uio_flags & UIO_FLAG_FREE);
+
+	if (xdrs->x_op != XDR_ENCODE)
+		return (false);
+	if (xioq->ioq_uv.uvq_fetch || (xdrs->x_flags & XDR_FLAG_NOSPLICE)
+	    || !uio->uio_count)
+		return (xdr_putbufs_copy(xdrs, uio, flags));
+
+	/* file ranges are sent as record fragments of their own, and
+	 * the stream position (u_int) must still cover all of them */
+	if (uv_flags & UIO_FLAG_FD) {
+		total = XDR_GETPOS(xdrs);
+		for (ix = 0; ix < uio->uio_count; ++ix) {
+			v = &uio->uio_vio[ix];
+			if ((uintptr_t)v->vio_tail - (uintptr_t)v->vio_head
+			    >= (1U << 31))
+				return (false);
+			total += (uintptr_t)v->vio_tail
+				 - (uintptr_t)v->vio_head;
+		}
+		if (total > UINT_MAX)
+			return (false);
+	}
 
-	for (ix = 0; ix < uio->uio_count; ++ix) {
-		/* advance fill pointer, do not allocate buffers, refs =1 */
-		if (!(flags & IOQ_FLAG_XTENDQ))
-			return (FALSE);
-		uv = xdr_ioq_uv_next(XIOQ(xdrs), flags);
-		if (!uv)
-			return (FALSE);
-
-		v = &(uio->uio_vio[ix]);
-		uv->u.uio_flags = UIO_FLAG_NONE; /* !RECLAIM */
-		uv->v = *v;
+	/* close the current segment */
+	xdr_tail_update(xdrs);
+	have = &IOQV(xdrs->x_base)->uvq;
 
-#if 0
-Saved for later golden buttery results -- Matt
-	if (flags & XDR_PUTBUFS_FLAG_BRELE) {
-		/* the caller is returning buffers */
-		for (ix = 0; ix < uio->xbs_cnt; ++ix) {
-			uv = (struct xdr_ioq_uv *)(uio->xbs_buf[ix]).xb_p1;
-			xdr_ioq_uv_release(uv);
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		uv = xdr_ioq_uv_create(0, uv_flags);
+		if (!uv) {
+			/* unwind */
+			while (ix--) {
+				struct poolq_entry *next = TAILQ_NEXT(
+					&IOQV(xdrs->x_base)->uvq, q);
+
+				TAILQ_REMOVE(&xioq->ioq_uv.uvqh.qh, next, q);
+				(xioq->ioq_uv.uvqh.qcount)--;
+				mem_free(IOQ_(next), sizeof(struct xdr_ioq_uv));
+			}
+			return (false);
 		}
-		mem_free(uio->xbs_buf, 0);
-		break;
-	} else {
-		for (ix = 0; ix < uio->xbs_cnt; ++ix) {
-			/* advance fill pointer, do not allocate buffers */
-			*uv = xdr_ioq_uv_next(XIOQ(xdrs), IOQ_FLAG_XTENDQ);
-			if (!uv)
-				return (false);
-			xbuf = &(uio->xbs_buf[ix]);
-			XIOQ(xdrs)->ioq_uv.plength += xbuf->xb_len;
-			uv->u.uio_flags = UIO_FLAG_NONE;	/* !RECLAIM */
-			uv->u.uio_references =
-			    (xbuf->xb_flags & UIO_FLAG_GIFT) ? 0 : 1;
-			uv->v.vio_base = xbuf->xb_base;
-			uv->v.vio_wrap = xbuf->xb_len;
-			uv->v.vio_tail = xbuf->xb_len;
-			uv->v.vio_head = 0;
+		v = &uio->uio_vio[ix];
+		uv->v = *v;
+		if (!(uv_flags & UIO_FLAG_FREE)) {
+			/* referenced, never filled */
+			uv->v.vio_wrap = v->vio_tail;
+			uv->u.uio_release = xdr_ioq_uv_splice_release;
 		}
+		uv->u.uio_u1 = uio->uio_u1;	/* UIO_FLAG_FD */
+		TAILQ_INSERT_AFTER(&xioq->ioq_uv.uvqh.qh, have, &uv->uvq, q);
+		(xioq->ioq_uv.uvqh.qcount)++;
+		have = &uv->uvq;
 	}
-#endif
-		/* save original buffer sequence for rele */
-		if (ix == 0) {
-			uv->u.uio_refer = uio;
-			(uio->uio_references)++;
-		}
+
+	if (uio->uio_release) {
+		uv->u.uio_refer = uio;
+		if (!(uio->uio_flags & UIO_FLAG_GIFT))
+			atomic_inc_int32_t(&uio->uio_references);
 	}
 
-	return (TRUE);
+	/* advance the fill position past them */
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		xioq->ioq_uv.plength += ioquv_length(IOQV(xdrs->x_base));
+		(xioq->ioq_uv.pcount)++;
+		xdrs->x_base = &IOQ_(TAILQ_NEXT(
+				&IOQV(xdrs->x_base)->uvq, q))->v;
+	}
+	xdrs->x_v = uv->v;
+	xdrs->x_private = uv->v.vio_tail;
+
+	return (true);
 }
 
 /*
@@ -54,8 +54,7 @@
 #include "un-namespace.h"
 
 typedef bool (*dummyfunc3)(XDR *, int, void *);
-typedef bool (*dummy_getbufs)(XDR *, xdr_uio *, u_int);
-typedef bool (*dummy_putbufs)(XDR *, xdr_uio *, u_int);
+typedef bool (*dummy_getbufs)(XDR *, xdr_uio **, u_int, u_int);
 
 static const struct xdr_ops xdrmem_ops_aligned;
 static const struct xdr_ops xdrmem_ops_unaligned;
@@ -262,7 +261,7 @@ static const struct xdr_ops xdrmem_ops_aligned = {
 	xdrmem_destroy,
 	(dummyfunc3) xdrmem_noop,	/* x_control */
 	(dummy_getbufs) xdrmem_noop,	/* x_getbufs */
-	(dummy_putbufs) xdrmem_noop,	/* x_putbufs */
+	xdr_putbufs_copy,	/* x_putbufs */
 };
 
 static const struct xdr_ops xdrmem_ops_unaligned = {
@@ -276,5 +275,5 @@ static const struct xdr_ops xdrmem_ops_unaligned = {
 	xdrmem_destroy,
 	(dummyfunc3) xdrmem_noop,	/* x_control */
 	(dummy_getbufs) xdrmem_noop,	/* x_getbufs */
-	(dummy_putbufs) xdrmem_noop,	/* x_putbufs */
+	xdr_putbufs_copy,	/* x_putbufs */
 };
@@ -77,11 +77,11 @@ static u_int xdrrec_getpos(XDR *);
 static bool xdrrec_setpos(XDR *, u_int);
 static int32_t *xdrrec_inline(XDR *, u_int);
 static void xdrrec_destroy(XDR *);
+static bool xdrrec_putbufs(XDR *, xdr_uio *, u_int);
 static bool xdrrec_noop(void);
 
 typedef bool (*dummyfunc3) (XDR *, int, void *);
-typedef bool (*dummy_getbufs) (XDR *, xdr_uio *, u_int);
-typedef bool (*dummy_putbufs) (XDR *, xdr_uio *, u_int);
+typedef bool (*dummy_getbufs) (XDR *, xdr_uio **, u_int, u_int);
 
 static const struct  xdr_ops xdrrec_ops = {
 	xdrrec_getlong,
@@ -94,7 +94,7 @@ static const struct  xdr_ops xdrrec_ops = {
 	xdrrec_destroy,
 	(dummyfunc3) xdrrec_noop,       /* x_control */
 	(dummy_getbufs) xdrrec_noop,    /* x_getbufs */
-	(dummy_putbufs) xdrrec_noop     /* x_putbufs */
+	xdrrec_putbufs                  /* x_putbufs */
 };
 
 /*
@@ -329,6 +329,68 @@ xdrrec_putbytes(XDR *xdrs, const char *addr, u_int len)
 	return (true);
 }
 
+/*
+ * Vectors that fit the output buffer are copied.  Larger ones are
+ * written in place as fragments of their own, after the buffer.
+ */
+static bool
+xdrrec_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
+{
+	RECSTREAM *rstrm = (RECSTREAM *) (xdrs->x_private);
+	u_int32_t len;
+	size_t ix;
+	int out;
+
+	if (uio->uio_flags & UIO_FLAG_FD)
+		return (xdr_putbufs_copy(xdrs, uio, flags));
+
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		char *addr = uio->uio_vio[ix].vio_head;
+
+		len = (u_int32_t) (PtrToUlong(uio->uio_vio[ix].vio_tail) -
+				   PtrToUlong(addr));
+		if (len <= (PtrToUlong(rstrm->out_boundry) -
+			    PtrToUlong(rstrm->out_finger))) {
+			if (!xdrrec_putbytes(xdrs, addr, len))
+				return (false);
+			continue;
+		}
+
+		/* end the current fragment, and start the vector's (an
+		 * empty one is reused, as zero length reads as garbage) */
+		out = PtrToUlong(rstrm->out_finger)
+		    - PtrToUlong(rstrm->frag_header) - sizeof(u_int32_t);
+		if (out > 0) {
+			if (PtrToUlong(rstrm->out_finger) + sizeof(u_int32_t) >
+			    PtrToUlong(rstrm->out_boundry)) {
+				if (!flush_out(rstrm, false))
+					return (false);
+			} else {
+				*(rstrm->frag_header) = htonl((u_int32_t) out);
+				rstrm->frag_header =
+				    (u_int32_t *) (void *)rstrm->out_finger;
+				rstrm->out_finger += sizeof(u_int32_t);
+			}
+		}
+		*(rstrm->frag_header) = htonl(len);
+
+		/* then the vector itself */
+		out = PtrToUlong(rstrm->out_finger)
+		    - PtrToUlong(rstrm->out_base);
+		if ((*(rstrm->writeit))
+		    (xdrs, rstrm->tcp_handle, rstrm->out_base, out) != out
+		    || (*(rstrm->writeit))
+		    (xdrs, rstrm->tcp_handle, addr, (int)len) != (int)len)
+			return (false);
+
+		rstrm->frag_sent = true;
+		rstrm->frag_header = (u_int32_t *) (void *)rstrm->out_base;
+		rstrm->out_finger = (char *)rstrm->out_base + sizeof(u_int32_t);
+	}
+	xdr_putbufs_release(uio);
+	return (true);
+}
+
 static u_int
 xdrrec_getpos(XDR *xdrs)
 {
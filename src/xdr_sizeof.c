@@ -32,129 +32,154 @@
  *
  * General purpose routine to see how much space something will use
  * when serialized using XDR.
+ *
+ * The counting stream (xdrsize_create) encodes nothing; it only
+ * advances its position, so that XDR_GETPOS() after encoding gives the
+ * exact encoded length, e.g. to size an xdr_ioq before the real pass.
  */
 
-#include <sys/cdefs.h>
+#include <config.h>
+#include <sys/types.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "namespace.h"
 #include <rpc/types.h>
-#include <sys/types.h>
 #include <misc/portable.h>
 #include <reentrant.h>
 #include <rpc/xdr.h>
 #include "un-namespace.h"
 
-#include "rpc_com.h"
+typedef bool (*dummyfunc1)(XDR *, long *);
+typedef bool (*dummyfunc2)(XDR *, char *, u_int);
+typedef bool (*dummyfunc3)(XDR *, int, void *);
+typedef bool (*dummy_getbufs)(XDR *, xdr_uio **, u_int, u_int);
 
 /* ARGSUSED */
 static bool
-x_putlong(XDR *xdrs, const long *longp)
+xdrsize_putlong(XDR *xdrs, const long *longp)
 {
 	xdrs->x_handy += BYTES_PER_XDR_UNIT;
-	return (TRUE);
+	return (true);
 }
 
 /* ARGSUSED */
 static bool
-x_putbytes(XDR *xdrs, const char *bp, u_int len)
+xdrsize_putbytes(XDR *xdrs, const char *bp, u_int len)
 {
 	xdrs->x_handy += len;
-	return (TRUE);
+	return (true);
 }
 
-static u_int x_getpostn(XDR *xdrs)
+static u_int
+xdrsize_getpos(XDR *xdrs)
 {
 	return (xdrs->x_handy);
 }
 
 /* ARGSUSED */
 static bool
-x_setpostn(XDR *xdrs, u_int pos)
+xdrsize_setpos(XDR *xdrs, u_int pos)
 {
 	/* This is not allowed */
-	return (FALSE);
+	return (false);
 }
 
+/*
+ * Callers encode into the returned area, so hand out a scratch buffer
+ * (x_base, of x_v.vio_wrap - x_v.vio_base bytes) and count it.
+ */
 static int32_t *
-x_inline(XDR *xdrs, u_int len)
+xdrsize_inline(XDR *xdrs, u_int len)
 {
-	if (len == 0)
-		return (NULL);
-	if (xdrs->x_op != XDR_ENCODE)
+	size_t size = (uintptr_t)xdrs->x_v.vio_wrap
+		    - (uintptr_t)xdrs->x_v.vio_base;
+
+	if (len == 0 || xdrs->x_op != XDR_ENCODE)
 		return (NULL);
-	if (len < PtrToUlong(xdrs->x_base)) {
-		/* x_private was already allocated */
-		xdrs->x_handy += len;
-		return ((int32_t *) xdrs->x_private);
-	} else {
-		/* Free the earlier space and allocate new area */
-		if (xdrs->x_private)
-			__free(xdrs->x_private);
-		xdrs->x_private = (caddr_t) mem_alloc(len);
-		if (!xdrs->x_private) {
-			xdrs->x_base = 0;
+
+	if (len > size) {
+		if (xdrs->x_base)
+			mem_free(xdrs->x_base, size);
+		xdrs->x_base = mem_alloc(len);
+		if (!xdrs->x_base) {
+			xdrs->x_v.vio_base =
+			xdrs->x_v.vio_wrap = NULL;
 			return (NULL);
 		}
-		xdrs->x_base = (void *)(intptr_t) len;	/* XXX */
-		xdrs->x_handy += len;
-		return ((int32_t *) xdrs->x_private);
+		xdrs->x_v.vio_base = xdrs->x_base;
+		xdrs->x_v.vio_wrap = xdrs->x_base + len;
 	}
+	xdrs->x_handy += len;
+	return ((int32_t *) xdrs->x_base);
 }
 
-static int
-harmless(void)
+static void
+xdrsize_destroy(XDR *xdrs)
 {
-	/* Always return FALSE/NULL, as the case may be */
-	return (0);
+	if (xdrs->x_base) {
+		mem_free(xdrs->x_base, (uintptr_t)xdrs->x_v.vio_wrap
+				       - (uintptr_t)xdrs->x_v.vio_base);
+		xdrs->x_base = NULL;
+	}
+	xdrs->x_v.vio_base =
+	xdrs->x_v.vio_wrap = NULL;
+	xdrs->x_handy = 0;
 }
 
-static void
-x_destroy(XDR *xdrs)
+/* ARGSUSED */
+static bool
+xdrsize_putbufs(XDR *xdrs, xdr_uio *uio, u_int flags)
 {
-	xdrs->x_handy = 0;
-	xdrs->x_base = 0;
-	if (xdrs->x_private) {
-		__free(xdrs->x_private);
-		xdrs->x_private = NULL;
+	size_t ix;
+
+	for (ix = 0; ix < uio->uio_count; ++ix) {
+		xdrs->x_handy += (uintptr_t)uio->uio_vio[ix].vio_tail
+			       - (uintptr_t)uio->uio_vio[ix].vio_head;
 	}
-	return;
+	return (true);
+}
+
+static bool
+xdrsize_noop(void)
+{
+	return (false);
 }
 
-unsigned long
+static const struct xdr_ops xdrsize_ops = {
+	(dummyfunc1) xdrsize_noop,	/* x_getlong */
+	xdrsize_putlong,
+	(dummyfunc2) xdrsize_noop,	/* x_getbytes */
+	xdrsize_putbytes,
+	xdrsize_getpos,
+	xdrsize_setpos,
+	xdrsize_inline,
+	xdrsize_destroy,
+	(dummyfunc3) xdrsize_noop,	/* x_control */
+	(dummy_getbufs) xdrsize_noop,	/* x_getbufs */
+	xdrsize_putbufs,
+};
+
+/*
+ * Create a counting (encode only) stream.  XDR_DESTROY() it when done.
+ */
+void
+xdrsize_create(XDR *xdrs)
+{
+	memset(xdrs, 0, sizeof(XDR));
+	xdrs->x_op = XDR_ENCODE;
+	xdrs->x_ops = &xdrsize_ops;
+}
+
+u_long
 xdr_sizeof(xdrproc_t func, void *data)
 {
 	XDR x;
-	struct xdr_ops ops;
-	bool stat;
-	/* to stop ANSI-C compiler from complaining */
-	typedef bool(*dummyfunc1) (XDR *, long *);
-	typedef bool(*dummyfunc2) (XDR *, caddr_t, u_int);
-	typedef bool(*dummyfunc3) (XDR *, const char *, u_int, u_int);
-	typedef bool(*dummy_getbufs) (XDR *, xdr_uio *, u_int, u_int);
-	typedef bool(*dummy_putbufs) (XDR *, xdr_uio *, u_int);
-
-	ops.x_putlong = x_putlong;
-	ops.x_putbytes = x_putbytes;
-	ops.x_inline = x_inline;
-	ops.x_getpostn = x_getpostn;
-	ops.x_setpostn = x_setpostn;
-	ops.x_destroy = x_destroy;
-
-	/* the other harmless ones */
-	ops.x_getlong = (dummyfunc1) harmless;
-	ops.x_getbytes = (dummyfunc2) harmless;
-	ops.x_getbufs = (dummy_getbufs) harmless;
-	ops.x_putbufs = (dummy_putbufs) harmless;
-
-	x.x_op = XDR_ENCODE;
-	x.x_ops = &ops;
-	x.x_handy = 0;
-	x.x_private = (caddr_t) NULL;
-	x.x_base = (caddr_t) 0;
-
-	stat = func(&x, data);
-	if (x.x_private)
-		__free(x.x_private);
-	return (stat == TRUE ? (unsigned)x.x_handy : 0);
+	u_long size = 0;
+
+	xdrsize_create(&x);
+	if ((*func) (&x, data))
+		size = x.x_handy;
+	XDR_DESTROY(&x);
+	return (size);
 }
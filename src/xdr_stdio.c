@@ -60,8 +60,7 @@ static int32_t *xdrstdio_inline(XDR *, u_int);
 static bool xdrstdio_noop(void);
 
 typedef bool (*dummyfunc3) (XDR *, int, void *);
-typedef bool (*dummy_getbufs) (XDR *, xdr_uio *, u_int);
-typedef bool (*dummy_putbufs) (XDR *, xdr_uio *, u_int);
+typedef bool (*dummy_getbufs) (XDR *, xdr_uio **, u_int, u_int);
 
 /*
  * Ops vector for stdio type XDR
@@ -77,7 +76,7 @@ static const struct xdr_ops xdrstdio_ops = {
 	xdrstdio_destroy,	/* destroy stream */
 	(dummyfunc3) xdrstdio_noop,	/* x_control */
 	(dummy_getbufs) xdrstdio_noop,	/* x_getbufs */
-	(dummy_putbufs) xdrstdio_noop	/* x_putbufs */
+	xdr_putbufs_copy	/* x_putbufs */
 };
 
 /*